@@ -10,6 +10,7 @@
 #include "../System/platformLog.h"
 #include "../System/random.h"
 #include "../System/ECPS/entityComponentProcessSystem.h"
+#include "../System/memory.h"
 #include "../Utils/stretchyBuffer.h"
 #include "../Input/input.h"
 #include "../Utils/idSet.h"
@@ -169,7 +170,7 @@ static uint8_t driveSpaceLeft( )
 
 	for( size_t i = 0; i < sb_Count( drive.sbFiles ); ++i ) {
 		EntityID id = drive.sbFiles[i];
-		uint16_t idx = idSet_GetIndex( id );
+		uint32_t idx = idSet_GetIndex( id );
 		totalSpace += sbFiles[idx].sizeBlocks;
 	}
 
@@ -178,7 +179,7 @@ static uint8_t driveSpaceLeft( )
 
 static void addExistingFileToDrive( EntityID fileID )
 {
-	uint16_t idx = idSet_GetIndex( fileID );
+	uint32_t idx = idSet_GetIndex( fileID );
 	assert( driveSpaceLeft( ) >= sbFiles[idx].sizeBlocks );
 	sb_Push( drive.sbFiles, fileID );
 }
@@ -196,7 +197,7 @@ static void removeFileFromDrive( EntityID fileID )
 static EntityID createFile(  const char* name, const char* description, int type, uint8_t sizeBlocks )
 {
 	EntityID newID = idSet_ClaimID( &fileIDs );
-	uint16_t idx = idSet_GetIndex( newID );
+	uint32_t idx = idSet_GetIndex( newID );
 	if( idx >= sb_Count( sbFiles ) ) {
 		size_t add = ( idx + 1 ) - sb_Count( sbFiles );
 		assert( add > 0 );
@@ -227,7 +228,7 @@ static EntityID createFile(  const char* name, const char* description, int type
 
 static void destroyFile( EntityID fileID )
 {
-	uint16_t idx = idSet_GetIndex( fileID );
+	uint32_t idx = idSet_GetIndex( fileID );
 
 	// if it has any archived files then destroy them
 	for( size_t i = 0; i < sb_Count( sbFiles[idx].sbContainedFiles ); ++i ) {
@@ -283,7 +284,7 @@ static void deselectAllFiles( )
 {
 	EntityID id = idSet_GetFirstValidID( &fileIDs );
 	while( id != INVALID_ENTITY_ID ) {
-		uint16_t idx = idSet_GetIndex( id );
+		uint32_t idx = idSet_GetIndex( id );
 		sbFiles[idx].isSelected = false;
 		id = idSet_GetNextValidID( &fileIDs, id );
 	}
@@ -291,11 +292,11 @@ static void deselectAllFiles( )
 
 static void recalculateArchiveSize( EntityID archive )
 {
-	uint16_t idx = idSet_GetIndex( archive );
+	uint32_t idx = idSet_GetIndex( archive );
 	uint8_t containedSize = 0;
 	for( size_t i = 0; i < sb_Count( sbFiles[idx].sbContainedFiles ); ++i ) {
 		EntityID childID = sbFiles[idx].sbContainedFiles[i];
-		uint16_t childIdx = idSet_GetIndex( childID );
+		uint32_t childIdx = idSet_GetIndex( childID );
 		containedSize += sbFiles[childIdx].sizeBlocks;
 	}
 
@@ -307,7 +308,7 @@ static void recalculateArchiveSize( EntityID archive )
 
 static void immediateAddFileToArchive( EntityID archive, EntityID file )
 {
-	uint16_t idx = idSet_GetIndex( archive );
+	uint32_t idx = idSet_GetIndex( archive );
 	sb_Push( sbFiles[idx].sbContainedFiles, file );
 
 	recalculateArchiveSize( archive );
@@ -315,7 +316,7 @@ static void immediateAddFileToArchive( EntityID archive, EntityID file )
 
 static void immediateRemoveFileFromArchive( EntityID archive, EntityID file )
 {
-	uint16_t idx = idSet_GetIndex( archive );
+	uint32_t idx = idSet_GetIndex( archive );
 	uint8_t containedSize = 0;
 	for( size_t i = 0; i < sb_Count( sbFiles[idx].sbContainedFiles ); ++i ) {
 		if( sbFiles[idx].sbContainedFiles[i] == file ) {
@@ -329,12 +330,12 @@ static void immediateRemoveFileFromArchive( EntityID archive, EntityID file )
 
 static uint8_t calculateSizeWithoutFile( EntityID archive, EntityID skipFile )
 {
-	uint16_t idx = idSet_GetIndex( archive );
+	uint32_t idx = idSet_GetIndex( archive );
 	uint8_t containedSize = 0;
 	for( size_t i = 0; i < sb_Count( sbFiles[idx].sbContainedFiles ); ++i ) {
 		EntityID childID = sbFiles[idx].sbContainedFiles[i];
 		if( skipFile == childID ) continue;
-		uint16_t childIdx = idSet_GetIndex( childID );
+		uint32_t childIdx = idSet_GetIndex( childID );
 		containedSize += sbFiles[childIdx].sizeBlocks;
 	}
 
@@ -346,15 +347,15 @@ static uint8_t calculateSizeWithoutFile( EntityID archive, EntityID skipFile )
 
 static uint8_t calculateSizeWithFile( EntityID archive, EntityID addFile )
 {
-	uint16_t idx = idSet_GetIndex( archive );
+	uint32_t idx = idSet_GetIndex( archive );
 	uint8_t containedSize = 0;
 	for( size_t i = 0; i < sb_Count( sbFiles[idx].sbContainedFiles ); ++i ) {
 		EntityID childID = sbFiles[idx].sbContainedFiles[i];
-		uint16_t childIdx = idSet_GetIndex( childID );
+		uint32_t childIdx = idSet_GetIndex( childID );
 		containedSize += sbFiles[childIdx].sizeBlocks;
 	}
 
-	uint16_t addIdx = idSet_GetIndex( addFile );
+	uint32_t addIdx = idSet_GetIndex( addFile );
 	containedSize += sbFiles[addIdx].sizeBlocks;
 
 	if( ( containedSize % 2 ) == 1 ) {
@@ -388,7 +389,7 @@ static void addCompressionOperation( EntityID archive )
 	EntityID id = idSet_GetFirstValidID( &fileIDs );
 	memset( newOp.compressFiles, 0, ARRAYSIZE( newOp.compressFiles ) * sizeof( newOp.compressFiles[0] ) );
 	while( ( id != INVALID_ENTITY_ID ) && ( currArcFileIdx < ARRAYSIZE( newOp.compressFiles ) ) ) {
-		uint16_t idx = idSet_GetIndex( id );
+		uint32_t idx = idSet_GetIndex( id );
 		if( sbFiles[idx].isSelected ) {
 			newOp.compressFiles[currArcFileIdx] = id;
 			sbFiles[idx].isSelected = false;
@@ -627,25 +628,27 @@ static void gameScreen_Process( void )
 {
 }
 
-static void appendTextToStretchyBuffer( const char* txt, char** sb )
+// the display strings are only needed for the frame they're drawn in, so they're built in the frame arena
+//  the string is always kept null terminated, len doesn't include the terminator
+static void appendTextToFrameString( const char* txt, char** str, size_t* len )
 {
-	while( *txt ) {
-		sb_Push( (*sb), *(txt++) );
-	}
+	size_t txtLen = strlen( txt );
+	(*str) = (char*)memArena_Resize( &frameArena, (*str), (*len) + txtLen + 1 );
+	memcpy( (*str) + (*len), txt, txtLen + 1 );
+	(*len) += txtLen;
 }
 
-static void appendFileNameToStretchyBuffer( EntityID fileID, char** sb )
+static void appendFileNameToFrameString( EntityID fileID, char** str, size_t* len )
 {
-	uint16_t fileIdx = idSet_GetIndex( fileID );
-	appendTextToStretchyBuffer( sbFiles[fileIdx].name, sb );
-	sb_Push( *sb, '.' );
-	appendTextToStretchyBuffer( fileTypes[sbFiles[fileIdx].fileType].typeName, sb );
+	uint32_t fileIdx = idSet_GetIndex( fileID );
+	appendTextToFrameString( sbFiles[fileIdx].name, str, len );
+	appendTextToFrameString( ".", str, len );
+	appendTextToFrameString( fileTypes[sbFiles[fileIdx].fileType].typeName, str, len );
 }
 
-char* sbDisplayName = NULL;
 static void drawFileInfo( EntityID fileID, Vector2 topLeft, Vector2 size, bool highlighted, bool selected )
 {
-	uint16_t fileIdx = idSet_GetIndex( fileID );
+	uint32_t fileIdx = idSet_GetIndex( fileID );
 
 	// don't bother with empty files, these are most likely archives that are just starting up
 	if( sbFiles[fileIdx].sizeBlocks <= 0 ) return;
@@ -664,8 +667,15 @@ static void drawFileInfo( EntityID fileID, Vector2 topLeft, Vector2 size, bool h
 	Vector2 pos;
 	vec2_AddScaled( &topLeft, &bgSize, 0.5f, &pos );
 
-	sb_Clear( sbDisplayName );
-	appendFileNameToStretchyBuffer( fileID, &sbDisplayName );
+	char* displayName = NULL;
+	size_t displayNameLen = 0;
+	if( selected ) {
+		appendTextToFrameString( "*", &displayName, &displayNameLen );
+	}
+	appendFileNameToFrameString( fileID, &displayName, &displayNameLen );
+	if( selected ) {
+		appendTextToFrameString( "*", &displayName, &displayNameLen );
+	}
 
 	if( highlighted ) {
 		clr.r *= 1.25f;
@@ -673,13 +683,6 @@ static void drawFileInfo( EntityID fileID, Vector2 topLeft, Vector2 size, bool h
 		clr.b *= 1.25f;
 	}
 
-	if( selected ) {
-		appendTextToStretchyBuffer( "*", &sbDisplayName );
-		sb_Insert( sbDisplayName, 0, '*' );
-	}
-
-	sb_Push( sbDisplayName, 0 );
-
 	img_Draw_sv_c( gradientImg, 1, pos, pos, imgSize, imgSize, clr, clr, 1 );
 
 
@@ -687,7 +690,7 @@ static void drawFileInfo( EntityID fileID, Vector2 topLeft, Vector2 size, bool h
 	Vector2 textSize = size;
 	textPos.x += 4.0f;
 	textSize.x -= 8.0f;
-	txt_DisplayTextArea( (uint8_t*)sbDisplayName, textPos, textSize, fileTypes[sbFiles[fileIdx].fileType].textClr, HORIZ_ALIGN_LEFT, VERT_ALIGN_TOP, displayFont, 0, NULL, 1, 2 );
+	txt_DisplayTextArea( (uint8_t*)displayName, textPos, textSize, fileTypes[sbFiles[fileIdx].fileType].textClr, HORIZ_ALIGN_LEFT, VERT_ALIGN_TOP, displayFont, 0, NULL, 1, 2 );
 }
 
 static bool isPointInsideBox( Vector2 point, Vector2 topLeft, Vector2 size )
@@ -724,7 +727,6 @@ static void drawMeter( Vector2 topLeft, Vector2 size, float pctFilled, Color bgC
 	img_Draw_sv_c( whiteImg, 1, pos, pos, fgSize, fgSize, fillColor, fillColor, 1 );
 }
 
-char* sbDataDisplay = NULL;
 static void gameScreen_Draw( void )
 {
 	// draw the storage
@@ -758,7 +760,7 @@ static void gameScreen_Draw( void )
 	highlighted = INVALID_ENTITY_ID;
 	for( size_t i = 0; i < sb_Count( drive.sbFiles ); ++i ) {
 		EntityID fileID = drive.sbFiles[i];
-		uint16_t fileIdx = idSet_GetIndex( fileID );
+		uint32_t fileIdx = idSet_GetIndex( fileID );
 		Vector2 pos;
 		pos.x = 250.0f;
 		pos.y = 12.0f + ( currOffset * 32.0f );
@@ -778,7 +780,7 @@ static void gameScreen_Draw( void )
 					EntityID deselectID = idSet_GetFirstValidID( &fileIDs );
 					while( deselectID != INVALID_ENTITY_ID ) {
 						if( deselectID != fileID ) {
-							uint16_t idx = idSet_GetIndex( deselectID );
+							uint32_t idx = idSet_GetIndex( deselectID );
 							sbFiles[idx].isSelected = false;
 						}
 
@@ -799,61 +801,54 @@ static void gameScreen_Draw( void )
 	Vector2 dataAreaTopLeft = { 575.0f, 64.0f };
 	Vector2 dataAreaSize = { 200.0f, 550.0f };
 	
-	if( sb_Count( sbDataDisplay ) > 0 ) {
-		memset( sbDataDisplay, 0, sb_Count( sbDataDisplay ) * sizeof( sbDataDisplay[0] ) );
-	}
-	sb_Clear( sbDataDisplay );
+	char* dataDisplay = NULL;
+	size_t dataDisplayLen = 0;
+	appendTextToFrameString( "", &dataDisplay, &dataDisplayLen ); // make sure there's always a valid string
 	if( highlighted != INVALID_ENTITY_ID ) {
-		uint16_t fileIdx = idSet_GetIndex( highlighted );
+		uint32_t fileIdx = idSet_GetIndex( highlighted );
 
-		appendFileNameToStretchyBuffer( highlighted, &sbDataDisplay );
-		sb_Push( sbDataDisplay, '\n' );
-		sb_Push( sbDataDisplay, ' ' );
-		sb_Push( sbDataDisplay, ' ' );
-		sb_Push( sbDataDisplay, ' ' );
+		appendFileNameToFrameString( highlighted, &dataDisplay, &dataDisplayLen );
+		appendTextToFrameString( "\n   ", &dataDisplay, &dataDisplayLen );
 		if( sbFiles[fileIdx].description == NULL ) {
-			appendTextToStretchyBuffer( "NO DESCRIPTION PROVIDED", &sbDataDisplay );
+			appendTextToFrameString( "NO DESCRIPTION PROVIDED", &dataDisplay, &dataDisplayLen );
 		} else {
-			appendTextToStretchyBuffer( sbFiles[fileIdx].description, &sbDataDisplay );
+			appendTextToFrameString( sbFiles[fileIdx].description, &dataDisplay, &dataDisplayLen );
 		}
-		sb_Push( sbDataDisplay, '\n' );
+		appendTextToFrameString( "\n", &dataDisplay, &dataDisplayLen );
 
 		if( sb_Count( sbFiles[fileIdx].sbContainedFiles ) > 0 ) {
-			appendTextToStretchyBuffer( "Contents:\n", &sbDataDisplay );
+			appendTextToFrameString( "Contents:\n", &dataDisplay, &dataDisplayLen );
 			for( size_t i = 0; i < sb_Count( sbFiles[fileIdx].sbContainedFiles ); ++i ) {
-				sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, '+' ); sb_Push( sbDataDisplay, '>' );
-				appendFileNameToStretchyBuffer( sbFiles[fileIdx].sbContainedFiles[i], &sbDataDisplay );
-				sb_Push( sbDataDisplay, '\n' );
+				appendTextToFrameString( " +>", &dataDisplay, &dataDisplayLen );
+				appendFileNameToFrameString( sbFiles[fileIdx].sbContainedFiles[i], &dataDisplay, &dataDisplayLen );
+				appendTextToFrameString( "\n", &dataDisplay, &dataDisplayLen );
 			}
 		}
 	} else {
 		// just display a list of the selected files
-		appendTextToStretchyBuffer( "Selected Files:\n", &sbDataDisplay );
+		appendTextToFrameString( "Selected Files:\n", &dataDisplay, &dataDisplayLen );
 		for( size_t i = 0; i < sb_Count( drive.sbFiles ); ++i ) {
 
 			EntityID fileID = drive.sbFiles[i];
-			uint16_t fileIdx = idSet_GetIndex( fileID );
+			uint32_t fileIdx = idSet_GetIndex( fileID );
 
 			if( !sbFiles[fileIdx].isSelected ) continue;
 
-			sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, ' ' );
-			appendFileNameToStretchyBuffer( fileID, &sbDataDisplay );
+			appendTextToFrameString( "   ", &dataDisplay, &dataDisplayLen );
+			appendFileNameToFrameString( fileID, &dataDisplay, &dataDisplayLen );
 
 			// TODO?: Display the deeper structure for achived files
 			//  or don't, if they want to make archives of archives then let them get the space gains, but they lose speed since they don't know what contains what
 			if( sb_Count( sbFiles[fileIdx].sbContainedFiles ) > 0 ) {
 				for( size_t x = 0; x < sb_Count( sbFiles[fileIdx].sbContainedFiles ); ++x ) {
-					sb_Push( sbDataDisplay, '\n' );
-					sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, ' ' );
-					sb_Push( sbDataDisplay, ' ' ); sb_Push( sbDataDisplay, '+' ); sb_Push( sbDataDisplay, '>' );
-					appendFileNameToStretchyBuffer( sbFiles[fileIdx].sbContainedFiles[x], &sbDataDisplay );
+					appendTextToFrameString( "\n    +>", &dataDisplay, &dataDisplayLen );
+					appendFileNameToFrameString( sbFiles[fileIdx].sbContainedFiles[x], &dataDisplay, &dataDisplayLen );
 				}
 			}
-			sb_Push( sbDataDisplay, '\n' );
+			appendTextToFrameString( "\n", &dataDisplay, &dataDisplayLen );
 		}
 	}
-	sb_Push( sbDataDisplay, 0 );
-	txt_DisplayTextArea( (const uint8_t*)sbDataDisplay, dataAreaTopLeft, dataAreaSize, CLR_LIGHT_GREY, HORIZ_ALIGN_LEFT, VERT_ALIGN_TOP, textFont, 0, NULL, 1, 10 );
+	txt_DisplayTextArea( (const uint8_t*)dataDisplay, dataAreaTopLeft, dataAreaSize, CLR_LIGHT_GREY, HORIZ_ALIGN_LEFT, VERT_ALIGN_TOP, textFont, 0, NULL, 1, 10 );
 
 	// handle input stuff
 	// display (A)rchive button and file name text field
@@ -861,7 +856,7 @@ static void gameScreen_Draw( void )
 	bool archiveSelected = false;
 	for( size_t i = 0; i < sb_Count( drive.sbFiles ); ++i ) {
 		EntityID fileID = drive.sbFiles[i];
-		uint16_t fileIdx = idSet_GetIndex( fileID );
+		uint32_t fileIdx = idSet_GetIndex( fileID );
 
 		if( !sbFiles[fileIdx].isSelected ) continue;
 
@@ -889,7 +884,7 @@ static void gameScreen_Draw( void )
 		if( deletePressed ) {
 			EntityID fileID = idSet_GetFirstValidID( &fileIDs );
 			while( fileID!= INVALID_ENTITY_ID ) {
-				uint16_t idx = idSet_GetIndex( fileID );
+				uint32_t idx = idSet_GetIndex( fileID );
 				if( sbFiles[idx].isSelected ) {
 					addDeleteOperation( fileID );
 				}
@@ -909,7 +904,7 @@ static void gameScreen_Draw( void )
 		if( expandPressed ) {
 			EntityID fileID = idSet_GetFirstValidID( &fileIDs );
 			while( fileID!= INVALID_ENTITY_ID ) {
-				uint16_t idx = idSet_GetIndex( fileID );
+				uint32_t idx = idSet_GetIndex( fileID );
 
 				if( sbFiles[idx].isSelected && ( sbFiles[idx].fileType == FT_ARC ) ) {
 					sbFiles[idx].isSelected = false;
@@ -940,7 +935,7 @@ static void gameScreen_Draw( void )
 			UserRequest* req = &( sbUsers[idx].sbRequests[x] );
 
 			EntityID fileID = sbRequestableFiles[req->requestableFileIdx].fileID;
-			uint16_t idx = idSet_GetIndex( fileID );
+			uint32_t idx = idSet_GetIndex( fileID );
 
 			Vector2 p = vec2( 24.0f, currY );
 			Color txtColor;
@@ -1090,7 +1085,7 @@ static void updateUserRequests( float dt )
 
 				--( sbUsers[idx].fileRequestsLeft );
 
-				uint16_t fileIdx = idSet_GetIndex( request.requestableFileIdx );
+				uint32_t fileIdx = idSet_GetIndex( request.requestableFileIdx );
 				signalNewRequest( sbUsers[idx].userName, sbFiles[fileIdx].name );
 			}
 		}
@@ -1144,13 +1139,13 @@ static void updateUserRequests( float dt )
 static bool runArchive( Operation* op, float delta )
 {
 	EntityID arcID = op->archiveFile;
-	uint16_t arcIdx = idSet_GetIndex( arcID );
+	uint32_t arcIdx = idSet_GetIndex( arcID );
 	File* arcFile = &( sbFiles[arcIdx] );
 
 	EntityID currID = op->processingFile;
 	if( currID != INVALID_ENTITY_ID ) {
 		// compressing file
-		uint16_t currIdx = idSet_GetIndex( currID );
+		uint32_t currIdx = idSet_GetIndex( currID );
 		File* currFile = &( sbFiles[currIdx] );
 
 		float totalTime = currFile->sizeBlocks * ARC_PER_BLOCK_TIME;
@@ -1203,14 +1198,14 @@ static bool runArchive( Operation* op, float delta )
 static bool runExpand( Operation* op, float delta )
 {
 	EntityID arcID = op->archiveFile;
-	uint16_t arcIdx = idSet_GetIndex( arcID );
+	uint32_t arcIdx = idSet_GetIndex( arcID );
 	File* arcFile = &( sbFiles[arcIdx] );
 
 	EntityID currID = op->processingFile;
 	
 	// we're either currently working on a file, or we're starting a file
 	if( currID != INVALID_ENTITY_ID ) {
-		uint16_t currIdx = idSet_GetIndex( currID );
+		uint32_t currIdx = idSet_GetIndex( currID );
 		File* currFile = &( sbFiles[currIdx] );
 
 		// file already in drive, we're operating on it
@@ -1236,7 +1231,7 @@ static bool runExpand( Operation* op, float delta )
 	} else {
 		// starting up a file
 		currID = arcFile->sbContainedFiles[0];
-		uint16_t currIdx = idSet_GetIndex( currID );
+		uint32_t currIdx = idSet_GetIndex( currID );
 		File* currFile = &( sbFiles[currIdx] );
 		
 		//  check to see if there's room for it, if there isn't then fail
@@ -1265,7 +1260,7 @@ static bool runExpand( Operation* op, float delta )
 static bool runDelete( Operation* op, float delta )
 {
 	EntityID fileID = op->processingFile;
-	uint16_t fileIdx = idSet_GetIndex( fileID );
+	uint32_t fileIdx = idSet_GetIndex( fileID );
 	File* file = &( sbFiles[fileIdx] );
 
 	float totalTime = file->sizeBlocks * TIME_TO_DELETE_BLOCK;
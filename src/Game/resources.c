@@ -6,6 +6,7 @@
 #include "../UI/text.h"
 #include "../sound.h"
 #include "../UI/button.h"
+#include "../System/jobQueue.h"
 
 int whiteImg = -1;
 int gradientImg = -1;
@@ -23,19 +24,28 @@ int newRequestSnd = -1;
 
 void loadResources( void )
 {
-	whiteImg = img_Load( "Images/white.png", ST_DEFAULT );
-	gradientImg = img_Load( "Images/gradient.png", ST_DEFAULT );
+	// decode the images and sounds on the worker threads while the main thread does the rest, the main thread
+	//  then binds them as they finish
+	JobCounter loadCounter;
+	jq_InitCounter( &loadCounter );
+
+	img_ThreadedLoad( "Images/white.png", ST_DEFAULT, &whiteImg, &loadCounter );
+	img_ThreadedLoad( "Images/gradient.png", ST_DEFAULT, &gradientImg, &loadCounter );
+
+	snd_ThreadedLoadSample( "Sounds/login.ogg", 1, false, &loginSnd, &loadCounter );
+	snd_ThreadedLoadSample( "Sounds/logout.ogg", 1, false, &logoutSnd, &loadCounter );
+	snd_ThreadedLoadSample( "Sounds/requestDone.ogg", 1, false, &requestDoneSnd, &loadCounter );
+	snd_ThreadedLoadSample( "Sounds/requestFailed.ogg", 1, false, &requestFailSnd, &loadCounter );
+	snd_ThreadedLoadSample( "Sounds/opFailed.ogg", 1, false, &opFailedSnd, &loadCounter );
+	snd_ThreadedLoadSample( "Sounds/newRequest.ogg", 1, false, &newRequestSnd, &loadCounter );
+
+	// the threaded font loading still has problems with the packed code points, so keep them here
 	img_LoadSpriteSheet( "Images/button.ss", ST_DEFAULT, &button3x3 );
 	displayFont = txt_LoadFont( "Fonts/kenvector_future_thin.ttf", 24.0f );
 	textFont = txt_LoadFont( "Fonts/kenvector_future_thin.ttf", 16.0f );
 	largeFont = txt_LoadFont( "Fonts/kenvector_future_thin.ttf", 64.0f );
 
-	loginSnd = snd_LoadSample( "Sounds/login.ogg", 1, false );
-	logoutSnd = snd_LoadSample( "Sounds/logout.ogg", 1, false );
-	requestDoneSnd = snd_LoadSample( "Sounds/requestDone.ogg", 1, false );
-	requestFailSnd = snd_LoadSample( "Sounds/requestFailed.ogg", 1, false );
-	opFailedSnd = snd_LoadSample( "Sounds/opFailed.ogg", 1, false );
-	newRequestSnd = snd_LoadSample( "Sounds/newRequest.ogg", 1, false );
+	jq_WaitForCounter( &loadCounter );
 
 	// always want the buttons
 	btn_Init( );
@@ -20,6 +20,8 @@ Handles the platform specific OpenGL stuff.
 #define GL_DEPTH_COMPONENT32 GL_DEPTH_COMPONENT32F
 #define GL_BACK_LEFT GL_BACK
 
+#define SHADER_VERSION "#version 300 es\n"
+
 // some default shaders
 #define DEFAULT_VERTEX_SHADER \
 	"#version 300 es\n" \
@@ -91,6 +93,8 @@ Handles the platform specific OpenGL stuff.
 
 #define PROFILE SDL_GL_CONTEXT_PROFILE_CORE
 
+#define SHADER_VERSION "#version 330\n"
+
 // some default shaders
 #define DEFAULT_VERTEX_SHADER \
 	"#version 330\n" \
@@ -157,6 +161,55 @@ Handles the platform specific OpenGL stuff.
 	"}\n"
 #endif
 
+// sprites drawn with triRenderer_AddInstances( ), interpolates between the start and end states and builds the
+//  corners the same way triRenderer_AddQuads( ) does, sprites the camera can't see are moved outside the clip area
+//  lerpTime is expected to already be in [0,1], the only difference between the platforms is the version
+#define INSTANCED_SPRITE_VERTEX_SHADER \
+	SHADER_VERSION \
+	"uniform mat4 vpMatrix;\n" \
+	"uniform float lerpTime;\n" \
+	"uniform float zOrderScale;\n" \
+	"uniform uint camFlags;\n" \
+	"layout(location = 0) in vec2 vCorner;\n" \
+	"layout(location = 1) in vec4 iPos;\n" \
+	"layout(location = 2) in vec4 iSize;\n" \
+	"layout(location = 3) in vec4 iStartColor;\n" \
+	"layout(location = 4) in vec4 iEndColor;\n" \
+	"layout(location = 5) in vec2 iRot;\n" \
+	"layout(location = 6) in vec2 iOffset;\n" \
+	"layout(location = 7) in vec4 iUVs;\n" \
+	"layout(location = 8) in float iDepth;\n" \
+	"layout(location = 9) in uvec2 iOrderCamFlags;\n" \
+	"out vec2 vTex;\n" \
+	"out vec4 vCol;\n" \
+	"void main( void )\n" \
+	"{\n" \
+	"	vTex = mix( iUVs.xy, iUVs.zw, vCorner + 0.5f );\n" \
+	"	if( ( iOrderCamFlags.y & camFlags ) == 0u ) {\n" \
+	"		vCol = vec4( 0.0f );\n" \
+	"		gl_Position = vec4( 2.0f, 2.0f, 2.0f, 1.0f );\n" \
+	"		return;\n" \
+	"	}\n" \
+	"	vec2 pos = iPos.xy + ( ( iPos.zw - iPos.xy ) * lerpTime );\n" \
+	"	vec2 size = iSize.xy + ( ( iSize.zw - iSize.xy ) * lerpTime );\n" \
+	"	float rotDiff = iRot.y - iRot.x;\n" \
+	"	float rotSign = sign( rotDiff );\n" \
+	"	rotDiff = abs( rotDiff );\n" \
+	"	if( rotDiff > 3.14159265f ) {\n" \
+	"		rotDiff = 6.28318531f - rotDiff;\n" \
+	"		rotSign = -rotSign;\n" \
+	"	}\n" \
+	"	float rot = iRot.x + ( rotDiff * rotSign * lerpTime );\n" \
+	"	float cosRot = cos( rot );\n" \
+	"	float sinRot = sin( rot );\n" \
+	"	vec2 center = pos + vec2( ( iOffset.x * cosRot ) - ( iOffset.y * sinRot ), ( iOffset.x * sinRot ) + ( iOffset.y * cosRot ) );\n" \
+	"	vec2 right = vec2( cosRot, sinRot ) * ( size.x * 0.5f );\n" \
+	"	vec2 down = vec2( -sinRot, cosRot ) * ( size.y * 0.5f );\n" \
+	"	vec2 world = center + ( right * sign( vCorner.x ) ) + ( down * sign( vCorner.y ) );\n" \
+	"	vCol = iStartColor + ( ( iEndColor - iStartColor ) * lerpTime );\n" \
+	"	gl_Position = vpMatrix * vec4( world, iDepth + ( float( iOrderCamFlags.x ) * zOrderScale ), 1.0f );\n" \
+	"}\n"
+
 int glInit( void );
 
 #endif // inclusion guard
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <SDL_timer.h>
+#include <SDL_atomic.h>
+#include <SDL_thread.h>
 
 #include "../Math/matrix4.h"
 #include "gfxUtil.h"
@@ -15,6 +18,9 @@
 #include "../System/jobQueue.h"
 #include "../System/jobRingQueue.h"
 #include "../System/memory.h"
+#include "../System/random.h"
+#include "../System/testing.h"
+#include "../Utils/stretchyBuffer.h"
 
 /* Image loading types and variables */
 #define MAX_IMAGES 512
@@ -39,7 +45,41 @@ typedef struct {
 static Image images[MAX_IMAGES];
 
 /* Rendering types and variables */
-#define MAX_RENDER_INSTRUCTIONS 1024
+// draw instructions are packed one after another, the header is always there and is followed by only the optional
+//  parts that were set, in the same order as their flags
+enum {
+	DRAWFLAG_SCALE = 0x1,
+	DRAWFLAG_COLOR = 0x2,
+	DRAWFLAG_ROTATION = 0x4,
+	DRAWFLAG_TRANSPARENT = 0x8, // doesn't have a part, set if the color has some transparency
+};
+
+typedef struct {
+	int16_t imageObj; // set to -1 if the image is cleaned up before the instruction is rendered
+	uint8_t flags;
+	int8_t depth;
+	int scissorID;
+	uint32_t camFlags;
+	Vector2 startPos;
+	Vector2 endPos;
+} DrawInstruction;
+
+typedef struct {
+	Vector2 start;
+	Vector2 end;
+} DrawInstructionScale;
+
+typedef struct {
+	Color start;
+	Color end;
+} DrawInstructionColor;
+
+typedef struct {
+	float start;
+	float end;
+} DrawInstructionRotation;
+
+// an instruction after it's been unpacked and combined with its image
 typedef struct {
 	Vector2 pos;
 	Vector2 scaleSize;
@@ -47,30 +87,37 @@ typedef struct {
 	float rotation;
 } DrawInstructionState;
 
-typedef struct {
-	GLuint textureObj;
-	int imageObj;
-	Vector2 offset;
-	Vector2 uvs[4];
-	DrawInstructionState start;
-	DrawInstructionState end;
-	int flags;
-	int scissorID;
-	uint32_t camFlags;
-	int8_t depth;
-	ShaderType shaderType;
-} DrawInstruction;
+#define DRAW_LIST_CHUNK_SIZE ( 16 * 1024 )
+typedef struct DrawListChunk {
+	struct DrawListChunk* next;
+	size_t used;
+	uint8_t data[DRAW_LIST_CHUNK_SIZE];
+} DrawListChunk;
 
-static DrawInstruction renderBuffer[MAX_RENDER_INSTRUCTIONS];
-static int lastDrawInstruction;
+// the instructions have to last until they're cleared, which can be several rendered frames, so they get their own
+//  arena instead of using the frameArena
+#define DRAW_ARENA_START_SIZE ( 256 * 1024 )
+static MemoryArena drawArena;
 
-static const DrawInstruction DEFAULT_DRAW_INSTRUCTION = {
-	0, -1, { 0.0f, 0.0f },
-	{ { 0.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f } },
-	{ { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, 0.0f },
-	{ { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, 0.0f },
-	0, 0, 0
-};
+typedef struct {
+	DrawListChunk* first;
+	DrawListChunk* last;
+	uint32_t count;
+} DrawList;
+static DrawList drawList;
+
+// draws made on a thread that's recording go into their own list, so several threads can draw at once, the lists
+//  are added to the main one in order of their sequence by img_AddDrawRecordings( )
+typedef struct {
+	DrawList list;
+	uint32_t sequence;
+} DrawRecording;
+
+static SDL_TLSID drawRecordingID = 0;
+static SDL_atomic_t numRecording; // so drawing when nothing is recording doesn't need to check the thread local value
+static SDL_SpinLock drawLock = 0; // guards the arena and the finished recordings while anything is recording
+static DrawRecording* sbFinishedRecordings = NULL;
+static bool useInstancing = false;
 
 static GLint maxTextureSize;
 
@@ -82,6 +129,18 @@ int img_Init( void )
 {
 	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maxTextureSize );
 	memset( images, 0, sizeof(images) );
+
+	if( memArena_Init( &drawArena, DRAW_ARENA_START_SIZE ) < 0 ) {
+		llog( LOG_ERROR, "Unable to create draw instruction arena." );
+		return -1;
+	}
+	img_ClearDrawInstructions( );
+
+	if( drawRecordingID == 0 ) {
+		drawRecordingID = SDL_TLSCreate( );
+	}
+	SDL_AtomicSet( &numRecording, 0 );
+
 	return 0;
 }
 
@@ -149,6 +208,7 @@ typedef struct {
 	ShaderType shaderType;
 	int* outIdx;
 	LoadedImage loadedImage;
+	JobCounter* counter;
 } ThreadedLoadImageData;
 
 static void bindImageJob( void* data )
@@ -214,14 +274,14 @@ static void loadImageJob( void* data )
 	gfxUtil_LoadImage( loadData->fileName, &( loadData->loadedImage ) );
 
 	// binding needs to be done on the main thread
-	jq_AddMainThreadJob( bindImageJob, data );
+	jq_AddMainThreadJobWithCounter( bindImageJob, data, loadData->counter );
 }
 
 /*
 Loads the image in a seperate thread. Puts the resulting image index into outIdx.
  Returns -1 if there was an issue, 0 otherwise.
 */
-void img_ThreadedLoad( const char* fileName, ShaderType shaderType, int* outIdx )
+void img_ThreadedLoad( const char* fileName, ShaderType shaderType, int* outIdx, JobCounter* counter )
 {
 	// set it to something that won't draw anything
 	(*outIdx) = -1;
@@ -239,8 +299,9 @@ void img_ThreadedLoad( const char* fileName, ShaderType shaderType, int* outIdx
 	data->shaderType = shaderType;
 	data->outIdx = outIdx;
 	data->loadedImage.data = NULL;
+	data->counter = counter;
 
-	if( !jq_AddJob( loadImageJob, data ) ) {
+	if( !jq_AddJobWithCounter( loadImageJob, data, counter ) ) {
 		mem_Release( data );
 	}
 }
@@ -282,6 +343,34 @@ int img_Create( SDL_Surface* surface, ShaderType shaderType )
 	return newIdx;
 }
 
+// where an optional part is in the instruction, any parts before it that were set come first
+static void* instructionPart( DrawInstruction* ri, uint8_t part )
+{
+	uint8_t* pos = (uint8_t*)ri + sizeof( DrawInstruction );
+	if( ( part > DRAWFLAG_SCALE ) && ( ri->flags & DRAWFLAG_SCALE ) ) {
+		pos += sizeof( DrawInstructionScale );
+	}
+	if( ( part > DRAWFLAG_COLOR ) && ( ri->flags & DRAWFLAG_COLOR ) ) {
+		pos += sizeof( DrawInstructionColor );
+	}
+	return pos;
+}
+
+static size_t instructionSize( uint8_t flags )
+{
+	size_t size = sizeof( DrawInstruction );
+	if( flags & DRAWFLAG_SCALE ) {
+		size += sizeof( DrawInstructionScale );
+	}
+	if( flags & DRAWFLAG_COLOR ) {
+		size += sizeof( DrawInstructionColor );
+	}
+	if( flags & DRAWFLAG_ROTATION ) {
+		size += sizeof( DrawInstructionRotation );
+	}
+	return size;
+}
+
 /*
 Cleans up an image at the specified index, trying to render with it after this won't work.
 */
@@ -291,20 +380,19 @@ void img_Clean( int idx )
 	assert( idx >= 0 );
 	assert( images[idx].flags & IMGFLAG_IN_USE );
 
-	int bufIdx;
-
 	if( ( idx < 0 ) || ( ( images[idx].size.v[0] == 0.0f ) && ( images[idx].size.v[1] == 0.0f ) ) || ( idx >= MAX_IMAGES ) ) {
 		return;
 	}
 
 	/* clean up anything we're wanting to draw */
-	for( bufIdx = 0; bufIdx <= lastDrawInstruction; ++bufIdx ) {
-		if( renderBuffer[bufIdx].imageObj == idx ) {
-			if( lastDrawInstruction > 0 ) {
-				renderBuffer[bufIdx] = renderBuffer[lastDrawInstruction-1];
+	for( DrawListChunk* chunk = drawList.first; chunk != NULL; chunk = chunk->next ) {
+		size_t pos = 0;
+		while( pos < chunk->used ) {
+			DrawInstruction* ri = (DrawInstruction*)( chunk->data + pos );
+			pos += instructionSize( ri->flags );
+			if( ri->imageObj == idx ) {
+				ri->imageObj = -1;
 			}
-			--lastDrawInstruction;
-			--bufIdx;
 		}
 	}
 
@@ -500,12 +588,11 @@ int img_GetTextureID( int idx, GLuint* out )
 }
 
 /*
-initializes the structure so only what's used needs to be set, also fill in
-  some stuff that all of the queueRenderImage functions use, returns the pointer
-  for further setting of other stuff
+Gets room for the next draw instruction and fills in the header, parts of the instruction for the flags passed in
+ need to be set after this with instructionPart( ).
  returns NULL if there's a problem
 */
-static DrawInstruction* GetNextRenderInstruction( int imgObj, uint32_t camFlags, Vector2 startPos, Vector2 endPos, int8_t depth )
+static DrawInstruction* GetNextRenderInstruction( int imgObj, uint32_t camFlags, Vector2 startPos, Vector2 endPos, int8_t depth, uint8_t flags )
 {
 	// the image hasn't been loaded yet, so don't render anything
 	if( imgObj < 0 ) {
@@ -518,42 +605,47 @@ static DrawInstruction* GetNextRenderInstruction( int imgObj, uint32_t camFlags,
 		return NULL;
 	}
 
-	if( lastDrawInstruction >= MAX_RENDER_INSTRUCTIONS ) {
-		llog( LOG_VERBOSE, "Render instruction queue full." );
-		return NULL;
+	DrawList* list = &drawList;
+	bool recording = SDL_AtomicGet( &numRecording ) > 0;
+	if( recording ) {
+		DrawRecording* rec = (DrawRecording*)SDL_TLSGet( drawRecordingID );
+		if( rec != NULL ) {
+			list = &( rec->list );
+		}
 	}
 
-	++lastDrawInstruction;
-	DrawInstruction* ri = &( renderBuffer[lastDrawInstruction] );
-
-	*ri = DEFAULT_DRAW_INSTRUCTION;
-	ri->textureObj = images[imgObj].textureObj;
-	ri->imageObj = imgObj;
-	ri->start.pos = startPos;
-	ri->end.pos = endPos;
-	ri->start.scaleSize = images[imgObj].size;
-	ri->end.scaleSize = images[imgObj].size;
-	ri->start.color = CLR_WHITE;
-	ri->end.color = CLR_WHITE;
-	ri->start.rotation = 0.0f;
-	ri->end.rotation = 0.0f;
-	ri->offset = images[imgObj].offset;
-	ri->flags = images[imgObj].flags;
-	ri->camFlags = camFlags;
-	ri->shaderType = images[imgObj].shaderType;
-	ri->depth = depth;
-	ri->scissorID = scissor_GetTopID( );
-	memcpy( ri->uvs, DEFAULT_DRAW_INSTRUCTION.uvs, sizeof( ri->uvs ) );
-
-	ri->uvs[0] = images[imgObj].uvMin;
+	size_t size = instructionSize( flags );
+	if( ( list->last == NULL ) || ( ( DRAW_LIST_CHUNK_SIZE - list->last->used ) < size ) ) {
+		// only happens once every DRAW_LIST_CHUNK_SIZE bytes, so other threads shouldn't be kept waiting long
+		if( recording ) SDL_AtomicLock( &drawLock );
+		DrawListChunk* chunk = (DrawListChunk*)memArena_Allocate( &drawArena, sizeof( DrawListChunk ) );
+		if( recording ) SDL_AtomicUnlock( &drawLock );
+		if( chunk == NULL ) {
+			llog( LOG_ERROR, "Unable to allocate room for more draw instructions." );
+			return NULL;
+		}
+		chunk->next = NULL;
+		chunk->used = 0;
 
-	ri->uvs[1].x = images[imgObj].uvMin.x;
-	ri->uvs[1].y = images[imgObj].uvMax.y;
+		if( list->last == NULL ) {
+			list->first = chunk;
+		} else {
+			list->last->next = chunk;
+		}
+		list->last = chunk;
+	}
 
-	ri->uvs[2].x = images[imgObj].uvMax.x;
-	ri->uvs[2].y = images[imgObj].uvMin.y;
+	DrawInstruction* ri = (DrawInstruction*)( list->last->data + list->last->used );
+	list->last->used += size;
+	++( list->count );
 
-	ri->uvs[3] = images[imgObj].uvMax;
+	ri->imageObj = (int16_t)imgObj;
+	ri->flags = flags;
+	ri->depth = depth;
+	ri->scissorID = scissor_GetTopID( );
+	ri->camFlags = camFlags;
+	ri->startPos = startPos;
+	ri->endPos = endPos;
 
 	return ri;
 }
@@ -561,60 +653,63 @@ static DrawInstruction* GetNextRenderInstruction( int imgObj, uint32_t camFlags,
 /*
 Adds to the list of images to draw.
 */
-#define DRAW_INSTRUCTION_START \
-	DrawInstruction* ri = GetNextRenderInstruction( imgID, camFlags, startPos, endPos, depth ); \
+#define DRAW_INSTRUCTION_START( flags ) \
+	DrawInstruction* ri = GetNextRenderInstruction( imgID, camFlags, startPos, endPos, depth, ( flags ) ); \
 	if( ri == NULL ) { return -1; }
 
 #define DRAW_INSTRUCTION_END \
 	return 0;
 
-#define SET_DRAW_INSTRUCTION_SCALE( startX, startY, endX, endY ) \
-	ri->start.scaleSize.x *= startX; \
-	ri->start.scaleSize.y *= startY; \
-	ri->end.scaleSize.x *= endX; \
-	ri->end.scaleSize.y *= endY;
-
-#define SET_DRAW_INSTRUCTION_COLOR( startColor, endColor ) \
-	ri->start.color = startColor; \
-	ri->end.color = endColor; \
+#define SET_DRAW_INSTRUCTION_SCALE( startX, startY, endX, endY ) { \
+	DrawInstructionScale* scale = (DrawInstructionScale*)instructionPart( ri, DRAWFLAG_SCALE ); \
+	scale->start.x = startX; \
+	scale->start.y = startY; \
+	scale->end.x = endX; \
+	scale->end.y = endY; }
+
+#define SET_DRAW_INSTRUCTION_COLOR( startColor, endColor ) { \
+	DrawInstructionColor* color = (DrawInstructionColor*)instructionPart( ri, DRAWFLAG_COLOR ); \
+	color->start = startColor; \
+	color->end = endColor; \
 	if( ( ( startColor.a > 0 ) && ( startColor.a < 1.0f ) ) || \
 		( ( endColor.a > 0 ) && ( endColor.a < 1.0f ) )) { \
-		ri->flags |= IMGFLAG_HAS_TRANSPARENCY; }
+		ri->flags |= DRAWFLAG_TRANSPARENT; } }
 
-#define SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad ) \
-	ri->start.rotation = startRotRad; \
-	ri->end.rotation = endRotRad;
+#define SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad ) { \
+	DrawInstructionRotation* rotation = (DrawInstructionRotation*)instructionPart( ri, DRAWFLAG_ROTATION ); \
+	rotation->start = startRotRad; \
+	rotation->end = endRotRad; }
 
 int img_Draw( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( 0 );
 	DRAW_INSTRUCTION_END;
 }
 
 int img_Draw_s( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, float startScale, float endScale, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE );
 	SET_DRAW_INSTRUCTION_SCALE( startScale, startScale, endScale, endScale );
 	DRAW_INSTRUCTION_END;
 }
 
 int img_Draw_sv( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Vector2 startScale, Vector2 endScale, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE );
 	SET_DRAW_INSTRUCTION_SCALE( startScale.x, startScale.y, endScale.x, endScale.y );
 	DRAW_INSTRUCTION_END;
 }
 
 int img_Draw_c( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Color startColor, Color endColor, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_COLOR );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	DRAW_INSTRUCTION_END;
 }
 
 int img_Draw_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
 	DRAW_INSTRUCTION_END;
 }
@@ -622,7 +717,7 @@ int img_Draw_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos,
 int img_Draw_s_c( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, float startScale, float endScale,
 	Color startColor, Color endColor, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_COLOR );
 	SET_DRAW_INSTRUCTION_SCALE( startScale, startScale, endScale, endScale );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	DRAW_INSTRUCTION_END;
@@ -631,7 +726,7 @@ int img_Draw_s_c( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos
 int img_Draw_s_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, float startScale, float endScale,
 	float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_SCALE( startScale, startScale, endScale, endScale );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
 	DRAW_INSTRUCTION_END;
@@ -640,7 +735,7 @@ int img_Draw_s_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos
 int img_Draw_sv_c( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Vector2 startScale, Vector2 endScale,
 	Color startColor, Color endColor, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_COLOR );
 	SET_DRAW_INSTRUCTION_SCALE( startScale.x, startScale.y, endScale.x, endScale.y );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	DRAW_INSTRUCTION_END;
@@ -649,7 +744,7 @@ int img_Draw_sv_c( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPo
 int img_Draw_sv_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Vector2 startScale, Vector2 endScale,
 	float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_SCALE( startScale.x, startScale.y, endScale.x, endScale.y );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
 	DRAW_INSTRUCTION_END;
@@ -658,7 +753,7 @@ int img_Draw_sv_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPo
 int img_Draw_c_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Color startColor, Color endColor,
 	float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_COLOR | DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
 	DRAW_INSTRUCTION_END;
@@ -667,7 +762,7 @@ int img_Draw_c_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos
 int img_Draw_s_c_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, float startScale, float endScale,
 	Color startColor, Color endColor, float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_COLOR | DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_SCALE( startScale, startScale, endScale, endScale );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
@@ -677,7 +772,7 @@ int img_Draw_s_c_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endP
 int img_Draw_sv_c_r( int imgID, uint32_t camFlags, Vector2 startPos, Vector2 endPos, Vector2 startScale, Vector2 endScale,
 	Color startColor, Color endColor, float startRotRad, float endRotRad, int8_t depth )
 {
-	DRAW_INSTRUCTION_START;
+	DRAW_INSTRUCTION_START( DRAWFLAG_SCALE | DRAWFLAG_COLOR | DRAWFLAG_ROTATION );
 	SET_DRAW_INSTRUCTION_SCALE( startScale.x, startScale.y, endScale.x, endScale.y );
 	SET_DRAW_INSTRUCTION_COLOR( startColor, endColor );
 	SET_DRAW_INSTRUCTION_ROT( startRotRad, endRotRad );
@@ -798,8 +893,8 @@ int img_Draw3x3v_c( int* imgs, uint32_t camFlags, Vector2 startPos, Vector2 endP
 		camFlags, startPos, endPos, startSize, endSize, startColor, endColor, depth );
 }
 
-#undef DRAW_INSTRUCTION_QUEUE_START
-#undef DRAW_INSTRUCTION_QUEUE_END
+#undef DRAW_INSTRUCTION_START
+#undef DRAW_INSTRUCTION_END
 #undef SET_DRAW_INSTRUCTION_SCALE
 #undef SET_DRAW_INSTRUCTION_COLOR
 #undef SET_DRAW_INSTRUCTION_ROT
@@ -809,38 +904,247 @@ Clears the image draw list.
 */
 void img_ClearDrawInstructions( void )
 {
-	lastDrawInstruction = -1;
+	assert( SDL_AtomicGet( &numRecording ) == 0 );
+
+	drawList.first = NULL;
+	drawList.last = NULL;
+	drawList.count = 0;
+	sb_Clear( sbFinishedRecordings );
+
+	if( drawArena.memory == NULL ) {
+		return;
+	}
+
+	memArena_Reset( &drawArena );
+
+	// if the last list didn't fit then make room for it, so we're not falling back to the main memory every frame
+	if( drawArena.lastHighWaterMark > drawArena.size ) {
+		size_t newSize = drawArena.size;
+		while( newSize < drawArena.lastHighWaterMark ) {
+			newSize *= 2;
+		}
+
+		memArena_CleanUp( &drawArena );
+		if( memArena_Init( &drawArena, newSize ) < 0 ) {
+			llog( LOG_ERROR, "Unable to grow draw instruction arena to %u bytes.", (unsigned int)newSize );
+		}
+	}
 }
 
-static void createRenderTransform( Vector2* pos, Vector2* scale, float rot,  Vector2* offset, Matrix4* out )
+/*
+Draws made on this thread until img_FinishDrawRecording( ) is called are kept in their own list, so several threads
+ can draw at the same time. The lists are added to the draw list in order of their sequence by img_AddDrawRecordings( ).
+*/
+void img_StartDrawRecording( uint32_t sequence )
 {
-	memcpy( out, &IDENTITY_MATRIX, sizeof( Matrix4 ) );
-	// this is the fully multiplied out multiplication of the transform, scale, and z-rotation
-	// pos * rot * offset * scale
-	//  problem here if the scale is different in each dimension (e.g scale = { 16, 24 }), the rotation isn't taken
-	//  into account so you end up with an oddly stretched image
+	assert( SDL_TLSGet( drawRecordingID ) == NULL );
 
-	
-	float cosRot = cosf( rot );
-	float sinRot = sinf( rot );
+	DrawRecording* rec = (DrawRecording*)mem_Allocate( sizeof( DrawRecording ) );
+	if( rec == NULL ) {
+		llog( LOG_ERROR, "Unable to allocate draw recording, drawing directly to the draw list." );
+		return;
+	}
+	rec->list.first = NULL;
+	rec->list.last = NULL;
+	rec->list.count = 0;
+	rec->sequence = sequence;
+
+	SDL_TLSSet( drawRecordingID, rec, NULL );
+	SDL_AtomicIncRef( &numRecording );
+}
 
-	out->m[0] = cosRot * scale->v[0];
-	out->m[1] = sinRot * scale->v[0];
-	out->m[4] = -sinRot * scale->v[1];
-	out->m[5] = cosRot * scale->v[1];
-	//out->m[10] = scale->v[2];
-	out->m[12] = pos->v[0] - ( offset->v[1] * sinRot ) + ( offset->v[0] * cosRot );
-	out->m[13] = pos->v[1] + ( offset->v[0] * sinRot ) + ( offset->v[1] * cosRot );
-	//out->m[14] = -pos->v[2]; //*/
+/*
+Stops recording draws on this thread, what was recorded is held until img_AddDrawRecordings( ) is called.
+*/
+void img_FinishDrawRecording( void )
+{
+	DrawRecording* rec = (DrawRecording*)SDL_TLSGet( drawRecordingID );
+	if( rec == NULL ) {
+		return;
+	}
+	SDL_TLSSet( drawRecordingID, NULL, NULL );
 
-	// pos * rot * scale * offset
-	/*out->m[0] = cosRot * scale->v[0];
-	out->m[1] = sinRot * scale->v[0];
-	out->m[4] = -sinRot * scale->v[1];
-	out->m[5] = cosRot * scale->v[1];
+	SDL_AtomicLock( &drawLock ); {
+		sb_Push( sbFinishedRecordings, *rec );
+	} SDL_AtomicUnlock( &drawLock );
+	SDL_AtomicDecRef( &numRecording );
 
-	out->m[12] = pos->v[0] + ( offset->v[0] * scale->v[0] * cosRot ) + ( offset->v[1] * scale->v[1] * -sinRot );
-	out->m[13] = pos->v[1] + ( offset->v[0] * scale->v[0] * sinRot ) + ( offset->v[1] * scale->v[1] * cosRot );//*/
+	mem_Release( rec );
+}
+
+/*
+Adds everything recorded since the last call to the end of the draw list, ordered by the sequence they were started
+ with. Must be called once nothing is recording.
+*/
+void img_AddDrawRecordings( void )
+{
+	assert( SDL_AtomicGet( &numRecording ) == 0 );
+
+	// there's one recording for each range of entities and they mostly finish in order, so an insertion sort does well
+	size_t count = sb_Count( sbFinishedRecordings );
+	for( size_t i = 1; i < count; ++i ) {
+		DrawRecording rec = sbFinishedRecordings[i];
+		size_t j = i;
+		while( ( j > 0 ) && ( sbFinishedRecordings[j - 1].sequence > rec.sequence ) ) {
+			sbFinishedRecordings[j] = sbFinishedRecordings[j - 1];
+			--j;
+		}
+		sbFinishedRecordings[j] = rec;
+	}
+
+	for( size_t i = 0; i < count; ++i ) {
+		DrawList* list = &( sbFinishedRecordings[i].list );
+		if( list->first == NULL ) {
+			continue;
+		}
+
+		if( drawList.last == NULL ) {
+			drawList.first = list->first;
+		} else {
+			drawList.last->next = list->first;
+		}
+		drawList.last = list->last;
+		drawList.count += list->count;
+	}
+
+	sb_Clear( sbFinishedRecordings );
+}
+
+// everything about the instructions that has to match for them to go into the same call to triRenderer_AddQuads( )
+//  or triRenderer_AddInstances( )
+typedef struct {
+	GLuint textureObj;
+	ShaderType shaderType;
+	int scissorID;
+	uint32_t camFlags;
+	int8_t depth;
+	int transparent;
+} SpriteState;
+
+static int sameSpriteState( SpriteState* first, SpriteState* second )
+{
+	return ( first->textureObj == second->textureObj ) &&
+		( first->shaderType == second->shaderType ) &&
+		( first->scissorID == second->scissorID ) &&
+		( first->camFlags == second->camFlags ) &&
+		( first->depth == second->depth ) &&
+		( first->transparent == second->transparent );
+}
+
+#define SPRITE_BATCH_SIZE 64
+
+typedef struct {
+	SpriteState state;
+	int count;
+	union {
+		TriQuad quads[SPRITE_BATCH_SIZE];
+		TriSpriteInstance instances[SPRITE_BATCH_SIZE];
+	};
+} SpriteBatch;
+
+static void flushSpriteBatch( SpriteBatch* batch )
+{
+	if( batch->count <= 0 ) {
+		return;
+	}
+
+	SpriteState* state = &( batch->state );
+	if( useInstancing ) {
+		triRenderer_AddInstances( batch->instances, (size_t)batch->count, state->shaderType, state->textureObj,
+			state->scissorID, state->camFlags, state->depth, state->transparent );
+	} else {
+		triRenderer_AddQuads( batch->quads, (size_t)batch->count, state->shaderType, state->textureObj,
+			state->scissorID, state->camFlags, state->depth, state->transparent );
+	}
+
+	batch->count = 0;
+}
+
+// fills in the start and end states from the instruction and its image
+static void unpackInstruction( DrawInstruction* ri, Image* img, DrawInstructionState* outStart, DrawInstructionState* outEnd )
+{
+	// the parts that were set follow the header in order
+	uint8_t* part = (uint8_t*)ri + sizeof( DrawInstruction );
+
+	outStart->pos = ri->startPos;
+	outEnd->pos = ri->endPos;
+
+	outStart->scaleSize = img->size;
+	outEnd->scaleSize = img->size;
+	if( ri->flags & DRAWFLAG_SCALE ) {
+		DrawInstructionScale* scale = (DrawInstructionScale*)part;
+		outStart->scaleSize.x *= scale->start.x;
+		outStart->scaleSize.y *= scale->start.y;
+		outEnd->scaleSize.x *= scale->end.x;
+		outEnd->scaleSize.y *= scale->end.y;
+		part += sizeof( DrawInstructionScale );
+	}
+
+	if( ri->flags & DRAWFLAG_COLOR ) {
+		DrawInstructionColor* color = (DrawInstructionColor*)part;
+		outStart->color = color->start;
+		outEnd->color = color->end;
+		part += sizeof( DrawInstructionColor );
+	} else {
+		outStart->color = CLR_WHITE;
+		outEnd->color = CLR_WHITE;
+	}
+
+	if( ri->flags & DRAWFLAG_ROTATION ) {
+		DrawInstructionRotation* rotation = (DrawInstructionRotation*)part;
+		outStart->rotation = rotation->start;
+		outEnd->rotation = rotation->end;
+	} else {
+		outStart->rotation = 0.0f;
+		outEnd->rotation = 0.0f;
+	}
+}
+
+// interpolates the instruction on the CPU and adds it to the batch as a quad
+static void addQuad( SpriteBatch* batch, DrawInstruction* ri, Image* img, float normTimeElapsed )
+{
+	DrawInstructionState start;
+	DrawInstructionState end;
+	unpackInstruction( ri, img, &start, &end );
+
+	TriQuad* quad = &( batch->quads[batch->count] );
+	vec2_Lerp( &( start.pos ), &( end.pos ), normTimeElapsed, &( quad->pos ) );
+	clr_Lerp( &( start.color ), &( end.color ), normTimeElapsed, &( quad->color ) );
+	vec2_Lerp( &( start.scaleSize ), &( end.scaleSize ), normTimeElapsed, &( quad->size ) );
+	quad->rotation = radianRotLerp( start.rotation, end.rotation, normTimeElapsed );
+	quad->offset = img->offset;
+	quad->uvMin = img->uvMin;
+	quad->uvMax = img->uvMax;
+}
+
+// packs the start and end states of the instruction so it can be interpolated on the GPU
+static void addInstance( SpriteBatch* batch, DrawInstruction* ri, Image* img )
+{
+	DrawInstructionState start;
+	DrawInstructionState end;
+	unpackInstruction( ri, img, &start, &end );
+
+	TriSpriteInstance* instance = &( batch->instances[batch->count] );
+	instance->startPos = start.pos;
+	instance->endPos = end.pos;
+	instance->startSize = start.scaleSize;
+	instance->endSize = end.scaleSize;
+	instance->startColor = start.color;
+	instance->endColor = end.color;
+	instance->startRotation = start.rotation;
+	instance->endRotation = end.rotation;
+	instance->offset = img->offset;
+	instance->uvMin = img->uvMin;
+	instance->uvMax = img->uvMax;
+}
+
+/*
+Sets whether images are drawn as instances, which are interpolated and transformed on the GPU, or as quads that
+ are done on the CPU. Uses quads by default.
+*/
+void img_SetInstancedRendering( bool instanced )
+{
+	useInstancing = instanced;
 }
 
 /*
@@ -848,43 +1152,298 @@ Draw all the images.
 */
 void img_Render( float normTimeElapsed )
 {
-	Vector2 unitSqVertPos[] = { { -0.5f, -0.5f }, { -0.5f, 0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f } };
-	GLuint indices[] = {
-		0, 1, 2,
-		1, 2, 3,
-	};
+	// clamped here so the quads and the instances are interpolated the same way
+	normTimeElapsed = clamp( 0.0f, 1.0f, normTimeElapsed );
+
+	if( useInstancing ) {
+		triRenderer_SetInstanceLerpTime( normTimeElapsed );
+	}
+
+	// runs of instructions with the same render state are sent to the triangle renderer together
+	SpriteBatch batch;
+	batch.count = 0;
+
+	for( DrawListChunk* chunk = drawList.first; chunk != NULL; chunk = chunk->next ) {
+		size_t pos = 0;
+		while( pos < chunk->used ) {
+			DrawInstruction* ri = (DrawInstruction*)( chunk->data + pos );
+			pos += instructionSize( ri->flags );
+
+			if( ri->imageObj < 0 ) {
+				continue;
+			}
 
-	for( int idx = 0; idx <= lastDrawInstruction; ++idx ) {
-		Vector2 verts[4];
+			Image* img = &( images[ri->imageObj] );
 
-		// generate the sprites matrix
-		Matrix4 modelTf;
-		Vector2 pos, sclSz;
-		float rot;
-		Color col;
+			SpriteState state;
+			state.textureObj = img->textureObj;
+			state.shaderType = img->shaderType;
+			state.scissorID = ri->scissorID;
+			state.camFlags = ri->camFlags;
+			state.depth = ri->depth;
+			state.transparent = ( ( img->flags & IMGFLAG_HAS_TRANSPARENCY ) || ( ri->flags & DRAWFLAG_TRANSPARENT ) ) ? 1 : 0;
 
-		vec2_Lerp( &( renderBuffer[idx].start.pos ), &( renderBuffer[idx].end.pos ), normTimeElapsed, &pos );
-		clr_Lerp( &( renderBuffer[idx].start.color ), &( renderBuffer[idx].end.color ), normTimeElapsed, &col );
-		vec2_Lerp( &( renderBuffer[idx].start.scaleSize ), &( renderBuffer[idx].end.scaleSize ), normTimeElapsed, &sclSz );
+			if( ( batch.count >= SPRITE_BATCH_SIZE ) || ( ( batch.count > 0 ) && !sameSpriteState( &( batch.state ), &state ) ) ) {
+				flushSpriteBatch( &batch );
+			}
 
-		rot = radianRotLerp( renderBuffer[idx].start.rotation, renderBuffer[idx].end.rotation, normTimeElapsed );
-		createRenderTransform( &pos, &sclSz, rot, &renderBuffer[idx].offset, &modelTf );
+			if( batch.count == 0 ) {
+				batch.state = state;
+			}
 
-		for( int i = 0; i < 4; ++i ) {
-			mat4_TransformVec2Pos( &modelTf, &( unitSqVertPos[i] ), &( verts[i] ) );
+			if( useInstancing ) {
+				addInstance( &batch, ri, img );
+			} else {
+				addQuad( &batch, ri, img, normTimeElapsed );
+			}
+			++batch.count;
 		}
+	}
+
+	flushSpriteBatch( &batch );
+}
 
-		int transparent = ( renderBuffer[idx].flags & IMGFLAG_HAS_TRANSPARENCY ) != 0;
+typedef struct {
+	Vector2 startPos;
+	Vector2 endPos;
+	float rotation;
+} BenchmarkSprite;
+
+typedef struct {
+	BenchmarkSprite* sprites;
+	size_t numSprites;
+	int* imgIDs;
+	int numImgIDs;
+} BenchmarkSpriteContext;
 
-		triRenderer_Add( verts[indices[0]], verts[indices[1]], verts[indices[2]],
-			renderBuffer[idx].uvs[indices[0]], renderBuffer[idx].uvs[indices[1]], renderBuffer[idx].uvs[indices[2]],
-			renderBuffer[idx].shaderType, renderBuffer[idx].textureObj, col,
-			renderBuffer[idx].scissorID, renderBuffer[idx].camFlags, renderBuffer[idx].depth,
-			transparent );
-		triRenderer_Add( verts[indices[3]], verts[indices[4]], verts[indices[5]],
-			renderBuffer[idx].uvs[indices[3]], renderBuffer[idx].uvs[indices[4]], renderBuffer[idx].uvs[indices[5]],
-			renderBuffer[idx].shaderType, renderBuffer[idx].textureObj, col,
-			renderBuffer[idx].scissorID, renderBuffer[idx].camFlags, renderBuffer[idx].depth,
-			transparent );
+static void drawBenchmarkSprites( BenchmarkSpriteContext* ctx, size_t start, size_t end )
+{
+	Color transparentColor = CLR_WHITE;
+	transparentColor.a = 0.5f;
+
+	for( size_t i = start; i < end; ++i ) {
+		// runs of a few sprites with the same image, like you'd get from a tile map or particles
+		int img = ctx->imgIDs[( i / 8 ) % ctx->numImgIDs];
+		BenchmarkSprite* sprite = &( ctx->sprites[i] );
+		if( ( ( i / 8 ) % 4 ) == 0 ) {
+			img_Draw_c_r( img, 1, sprite->startPos, sprite->endPos, transparentColor, transparentColor,
+				sprite->rotation, sprite->rotation + 0.1f, 0 );
+		} else {
+			img_Draw_r( img, 1, sprite->startPos, sprite->endPos, sprite->rotation, sprite->rotation + 0.1f, 0 );
+		}
+	}
+}
+
+// records each range separately, like the render process does when it's run on the job queue
+#define BENCHMARK_RECORDING_RANGE 1024
+static void recordBenchmarkSprites( void* context, size_t start, size_t end )
+{
+	BenchmarkSpriteContext* ctx = (BenchmarkSpriteContext*)context;
+	for( size_t r = start; r < end; ++r ) {
+		img_StartDrawRecording( (uint32_t)r );
+		drawBenchmarkSprites( ctx, r * BENCHMARK_RECORDING_RANGE, SDL_min( ( r + 1 ) * BENCHMARK_RECORDING_RANGE, ctx->numSprites ) );
+		img_FinishDrawRecording( );
+	}
+}
+
+static void recordBenchmarkSpritesAcrossThreads( BenchmarkSpriteContext* ctx )
+{
+	size_t numRanges = ( ctx->numSprites + BENCHMARK_RECORDING_RANGE - 1 ) / BENCHMARK_RECORDING_RANGE;
+	jq_ParallelFor( numRanges, 1, recordBenchmarkSprites, ctx );
+	img_AddDrawRecordings( );
+}
+
+static void releaseBenchmarkSprites( BenchmarkSpriteContext* ctx )
+{
+	mem_Release( ctx->sprites );
+	for( int i = 0; i < ctx->numImgIDs; ++i ) {
+		memset( &( images[ctx->imgIDs[i]] ), 0, sizeof( Image ) );
 	}
-}
\ No newline at end of file
+}
+
+// claims stand in images for the instructions to use and creates numSprites random sprites using them, the textures
+//  are never bound since nothing is drawn
+//  returns a value < 0 if there's a problem
+#define BENCHMARK_IMAGE_COUNT 8
+static int createBenchmarkSprites( BenchmarkSpriteContext* ctx, int* imgIDs, uint32_t numSprites )
+{
+	ctx->sprites = NULL;
+	ctx->numSprites = numSprites;
+	ctx->imgIDs = imgIDs;
+	ctx->numImgIDs = 0;
+
+	for( int i = 0; i < BENCHMARK_IMAGE_COUNT; ++i ) {
+		imgIDs[i] = findAvailableImageIndex( );
+		if( imgIDs[i] < 0 ) {
+			llog( LOG_WARN, "Not enough free images to run the image render benchmark." );
+			releaseBenchmarkSprites( ctx );
+			return -1;
+		}
+
+		Image* img = &( images[imgIDs[i]] );
+		memset( img, 0, sizeof( Image ) );
+		img->textureObj = (GLuint)( 1 + i );
+		img->size.x = img->size.y = 32.0f;
+		img->uvMax.x = img->uvMax.y = 1.0f;
+		img->flags = IMGFLAG_IN_USE;
+		img->packageID = -1;
+		img->nextInPackage = -1;
+		img->shaderType = ST_DEFAULT;
+		++( ctx->numImgIDs );
+	}
+
+	ctx->sprites = (BenchmarkSprite*)mem_Allocate( sizeof( BenchmarkSprite ) * ( numSprites > 0 ? numSprites : 1 ) );
+	if( ctx->sprites == NULL ) {
+		llog( LOG_WARN, "Unable to allocate sprites for the image render benchmark." );
+		releaseBenchmarkSprites( ctx );
+		return -1;
+	}
+
+	RandomGroup rand;
+	rand_Seed( &rand, 2048 );
+	for( uint32_t i = 0; i < numSprites; ++i ) {
+		ctx->sprites[i].startPos.x = rand_GetRangeFloat( &rand, 0.0f, 800.0f );
+		ctx->sprites[i].startPos.y = rand_GetRangeFloat( &rand, 0.0f, 600.0f );
+		ctx->sprites[i].endPos.x = ctx->sprites[i].startPos.x + rand_GetRangeFloat( &rand, -4.0f, 4.0f );
+		ctx->sprites[i].endPos.y = ctx->sprites[i].startPos.y + rand_GetRangeFloat( &rand, -4.0f, 4.0f );
+		ctx->sprites[i].rotation = rand_GetRangeFloat( &rand, -M_PI_F, M_PI_F );
+	}
+
+	return 0;
+}
+
+// returns the size of the draw list, and if out isn't NULL copies the instructions in it into out as one stream
+static size_t copyDrawList( uint8_t* out )
+{
+	size_t listBytes = 0;
+	for( DrawListChunk* chunk = drawList.first; chunk != NULL; chunk = chunk->next ) {
+		if( out != NULL ) {
+			memcpy( out + listBytes, chunk->data, chunk->used );
+		}
+		listBytes += chunk->used;
+	}
+	return listBytes;
+}
+
+// the chunks are split differently when recording across threads, so compare the instructions as one stream
+static bool drawListMatches( const uint8_t* serialList, size_t listBytes, uint32_t serialCount )
+{
+	bool matches = ( serialList != NULL ) && ( drawList.count == serialCount );
+	size_t pos = 0;
+	for( DrawListChunk* chunk = drawList.first; matches && ( chunk != NULL ); chunk = chunk->next ) {
+		matches = ( ( pos + chunk->used ) <= listBytes ) && ( memcmp( serialList + pos, chunk->data, chunk->used ) == 0 );
+		pos += chunk->used;
+	}
+	return matches && ( pos == listBytes );
+}
+
+/*
+Records a few ranges of sprites, with the last one partly filled, on this thread and across the job queue and checks
+ both give the same instructions. Clears out the current draw instructions.
+*/
+void img_RunTests( void )
+{
+	int imgIDs[BENCHMARK_IMAGE_COUNT];
+	BenchmarkSpriteContext ctx;
+	if( !TEST_CHECK( createBenchmarkSprites( &ctx, imgIDs, ( BENCHMARK_RECORDING_RANGE * 3 ) + 100 ) >= 0, "test sprites were created" ) ) {
+		return;
+	}
+
+	img_ClearDrawInstructions( );
+	drawBenchmarkSprites( &ctx, 0, ctx.numSprites );
+	TEST_CHECK( drawList.count == ctx.numSprites, "every sprite was recorded" );
+
+	size_t listBytes = copyDrawList( NULL );
+	uint8_t* serialList = (uint8_t*)mem_Allocate( listBytes > 0 ? listBytes : 1 );
+	if( TEST_CHECK( serialList != NULL, "allocated a copy of the draw list" ) ) {
+		copyDrawList( serialList );
+		uint32_t serialCount = drawList.count;
+
+		img_ClearDrawInstructions( );
+		recordBenchmarkSpritesAcrossThreads( &ctx );
+		TEST_CHECK( drawListMatches( serialList, listBytes, serialCount ), "recording across threads gives the same instructions as one thread" );
+
+		// recording nothing across threads leaves an empty list
+		img_ClearDrawInstructions( );
+		img_AddDrawRecordings( );
+		TEST_CHECK( drawList.count == 0, "no recordings adds no instructions" );
+
+		mem_Release( serialList );
+	}
+
+	img_ClearDrawInstructions( );
+	releaseBenchmarkSprites( &ctx );
+}
+
+/*
+Times how long it takes to record numSprites draw instructions and how long img_Render( ) takes to hand them over
+ to the triangle renderer, interpolating them on the CPU as quads compared to packing them as instances. Only the
+ CPU side is timed, nothing is drawn. Clears out the current draw instructions and triangles.
+*/
+void img_RunRenderBenchmark( uint32_t numSprites, uint32_t runs )
+{
+	int imgIDs[BENCHMARK_IMAGE_COUNT];
+	BenchmarkSpriteContext ctx;
+	if( createBenchmarkSprites( &ctx, imgIDs, numSprites ) < 0 ) {
+		return;
+	}
+
+	llog( LOG_INFO, "Image render benchmark: %u sprites, %u runs", numSprites, runs );
+
+	double bestMS = 0.0;
+	for( uint32_t r = 0; r < runs; ++r ) {
+		Uint64 start = SDL_GetPerformanceCounter( );
+		img_ClearDrawInstructions( );
+		drawBenchmarkSprites( &ctx, 0, numSprites );
+		bestMS = test_Fastest( bestMS, test_MSSince( start ), r );
+	}
+
+	size_t listBytes = copyDrawList( NULL );
+	llog( LOG_INFO, "  recording: %.4f ms, %.1f ns per sprite, %u instructions in %u bytes", bestMS,
+		( bestMS * 1000000.0 ) / (double)( numSprites > 0 ? numSprites : 1 ), drawList.count, (unsigned int)listBytes );
+
+	// keep a copy of what was recorded on a single thread, recording across threads should give exactly the same list
+	uint8_t* serialList = (uint8_t*)mem_Allocate( listBytes > 0 ? listBytes : 1 );
+	if( serialList != NULL ) {
+		copyDrawList( serialList );
+	}
+	uint32_t serialCount = drawList.count;
+
+	bestMS = 0.0;
+	for( uint32_t r = 0; r < runs; ++r ) {
+		Uint64 start = SDL_GetPerformanceCounter( );
+		img_ClearDrawInstructions( );
+		recordBenchmarkSpritesAcrossThreads( &ctx );
+		bestMS = test_Fastest( bestMS, test_MSSince( start ), r );
+	}
+
+	llog( LOG_INFO, "  recording in %u ranges across threads: %.4f ms, %.1f ns per sprite",
+		(unsigned int)( ( numSprites + BENCHMARK_RECORDING_RANGE - 1 ) / BENCHMARK_RECORDING_RANGE ), bestMS,
+		( bestMS * 1000000.0 ) / (double)( numSprites > 0 ? numSprites : 1 ) );
+	TEST_CHECK( drawListMatches( serialList, listBytes, serialCount ), "recording across threads gives the same instructions as one thread" );
+	mem_Release( serialList );
+
+	bool wasInstancing = useInstancing;
+	for( int instanced = 0; instanced < 2; ++instanced ) {
+		useInstancing = ( instanced != 0 );
+
+		bestMS = 0.0;
+		for( uint32_t r = 0; r < runs; ++r ) {
+			triRenderer_Clear( );
+			Uint64 start = SDL_GetPerformanceCounter( );
+			img_Render( 0.5f );
+			bestMS = test_Fastest( bestMS, test_MSSince( start ), r );
+		}
+
+		llog( LOG_INFO, "  %s: %.4f ms, %.1f ns per sprite", useInstancing ? "instances" : "quads", bestMS,
+			( bestMS * 1000000.0 ) / (double)( numSprites > 0 ? numSprites : 1 ) );
+	}
+	useInstancing = wasInstancing;
+
+	triRenderer_Clear( );
+	img_ClearDrawInstructions( );
+
+	releaseBenchmarkSprites( &ctx );
+}
+#undef BENCHMARK_IMAGE_COUNT
+#undef BENCHMARK_RECORDING_RANGE
@@ -2,10 +2,12 @@
 #define IMAGES_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <SDL.h>
 #include "../Math/vector2.h"
 #include "color.h"
 #include "triRendering.h"
+#include "../System/jobQueue.h"
 
 /*
 Initializes images.
@@ -16,8 +18,9 @@ int img_Init( void );
 //************ Threaded functions
 /*
 Loads the image in a seperate thread. Puts the resulting image index into outIdx.
+ If counter isn't NULL it won't reach zero until the image has been loaded and bound.
 */
-void img_ThreadedLoad( const char* fileName, ShaderType shaderType, int* outIdx );
+void img_ThreadedLoad( const char* fileName, ShaderType shaderType, int* outIdx, JobCounter* counter );
 
 //************ End threaded functions
 
@@ -116,9 +119,46 @@ Clears the image draw list.
 */
 void img_ClearDrawInstructions( void );
 
+/*
+Draws made on this thread until img_FinishDrawRecording( ) is called are kept in their own list, so several threads
+ can draw at the same time. Scissors should not be changed while anything is recording.
+*/
+void img_StartDrawRecording( uint32_t sequence );
+
+/*
+Stops recording draws on this thread, what was recorded is held until img_AddDrawRecordings( ) is called.
+*/
+void img_FinishDrawRecording( void );
+
+/*
+Adds everything recorded since the last call to the end of the draw list, ordered by the sequence each recording was
+ started with. Must be called once nothing is recording.
+*/
+void img_AddDrawRecordings( void );
+
+/*
+Sets whether images are drawn as instances, which are interpolated and transformed on the GPU, or as quads that
+ are done on the CPU. Uses quads by default.
+*/
+void img_SetInstancedRendering( bool instanced );
+
 /*
 Draw all the images.
 */
 void img_Render( float normTimeElapsed );
 
+/*
+Checks that recording draw instructions across the job queue gives the same instructions as recording them on one
+ thread, asserting if anything fails. Clears out the current draw instructions.
+*/
+void img_RunTests( void );
+
+/*
+Times how long it takes to record numSprites draw instructions, both on this thread and split into recordings
+ across the job queue, and how long img_Render( ) takes to hand them over to the triangle renderer, interpolating them
+ on the CPU as quads compared to packing them as instances. Asserts if recording across threads doesn't give the
+ same instructions. Only the CPU side is timed, nothing is drawn. Clears out the current draw instructions and triangles.
+*/
+void img_RunRenderBenchmark( uint32_t numSprites, uint32_t runs );
+
 #endif /* inclusion guard */
\ No newline at end of file
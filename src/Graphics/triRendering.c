@@ -1,6 +1,10 @@
 #include "triRendering.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <SDL_timer.h>
 
 #include "glPlatform.h"
 
@@ -10,6 +14,10 @@
 #include "glDebugging.h"
 #include "scissor.h"
 #include "../System/platformLog.h"
+#include "../System/memory.h"
+#include "../Utils/stretchyBuffer.h"
+#include "../System/random.h"
+#include "../System/testing.h"
 
 typedef struct {
 	Vector3 pos;
@@ -26,46 +34,117 @@ typedef struct {
 	ShaderType shaderType;
 
 	int scissorID;
+
+	// the z position isn't known until everything has been added, since it depends on how many triangles there are
+	uint32_t order;
+	int8_t depth;
 } Triangle;
 
+// what's sent to the GPU for each sprite instance, the layout has to match the attributes set up in
+//  pointInstanceAttributes( )
+typedef struct {
+	TriSpriteInstance sprite;
+	float depth;
+	uint32_t order;
+	uint32_t camFlags;
+} InstanceData;
+
+typedef struct {
+	InstanceData data;
+	GLuint texture;
+	ShaderType shaderType;
+	int scissorID;
+} SpriteInstance;
+
+// a run of triangles that can be drawn with one call, for instanced batches the first index and number of indices
+//  are the first instance and how many instances there are
+typedef struct {
+	GLuint texture;
+	ShaderType shaderType;
+	int scissorID;
+	size_t firstIndex;
+	size_t numIndices;
+	bool instanced;
+} DrawBatch;
+
+// the render state or depth of a triangle or sprite instance packed so it can be radix sorted, the triangles
+//  themselves are never moved, drawing goes through the sorted list instead
+typedef struct {
+	uint64_t key;
+	uint32_t item; // index of the triangle, or of the instance if INSTANCE_ITEM is set
+} SortItem;
+
+#define INSTANCE_ITEM 0x80000000u
+
 /*
 Ok, so what do we want to optimize for?
 I'd think transferring memory.
 So we have the vertices we transfer at the beginning of the rendering
 Once that is done we generate index buffers to represent what each camera can see
 */
-#define MAX_TRIS 2048
-#define MAX_VERTS ( MAX_TRIS * 3 )
+// the vertices are stored in fixed size chunks that are kept between frames, so adding triangles never has to move
+//  the ones already added, the triangles themselves are in one array since they get sorted
+// the vertices for a triangle or quad are never split between chunks, so a chunk can end with a few unused ones
+#define CHUNK_VERTS_SHIFT 14
+#define CHUNK_VERTS ( 1 << CHUNK_VERTS_SHIFT )
+#define CHUNK_VERTS_MASK ( CHUNK_VERTS - 1 )
 
 typedef struct {
-	Vertex startVertices[MAX_VERTS];
-	Vertex endVertices[MAX_VERTS];
-
-	Triangle triangles[MAX_TRIS];
-	Vertex vertices[MAX_VERTS];
-	GLuint indices[MAX_VERTS];
+	Triangle* sbTriangles;
+	Vertex** sbVertexChunks;
+	size_t numVertices;
+	GLuint* sbIndices;
+	DrawBatch* sbBatches;
+	SortItem* sbSortItems;
+	SortItem* sbSortScratch;
+	SpriteInstance* sbInstances;
+	InstanceData* sbInstanceData; // the instances in the order they're drawn
 	GLuint VAO;
 	GLuint VBO;
 	GLuint IBO;
-	int lastTriIndex;
-	int lastIndexBufferIndex;
+	GLuint instanceVAO;
+	GLuint instanceVBO;
+	size_t vboSize; // bytes allocated for each buffer, they grow when a frame needs more
+	size_t iboSize;
+	size_t instanceVBOSize;
 } TriangleList;
 
 TriangleList solidTriangles;
 TriangleList transparentTriangles;
 
-#define Z_ORDER_OFFSET ( 1.0f / (float)( 2 * ( MAX_TRIS + 1 ) ) )
+static TriRendererStats lastFrameStats;
+
+// how many triangles, quads, and instances have been added since the last clear, used to order things at the same depth
+static uint32_t nextOrder;
+static float zOrderScale;
+
+// where the instanced sprites are in their interpolation between their start and end states
+static float instanceLerpTime;
+
+// the corners of the unit square for each instance, in triangle strip order so they match QUAD_INDICES
+static GLuint quadCornerVBO;
+static const Vector2 QUAD_CORNERS[4] = {
+	{ -0.5f, -0.5f }, { -0.5f, 0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }
+};
 
-static ShaderProgram shaderPrograms[NUM_SHADERS];
+// both triangles of a quad share its vertices, in the same order as the unit square in img_Render
+static const GLuint QUAD_INDICES[6] = {
+	0, 1, 2,
+	1, 2, 3,
+};
+
+// the instanced version of each shader is stored NUM_SHADERS after the normal one
+static ShaderProgram shaderPrograms[NUM_SHADERS * 2];
+#define INSTANCED_PROGRAM( shaderType ) ( NUM_SHADERS + ( shaderType ) )
 
 int triRenderer_LoadShaders( void )
 {
 	llog( LOG_INFO, "Loading triangle renderer shaders." );
-	ShaderDefinition shaderDefs[3];
-	ShaderProgramDefinition progDefs[NUM_SHADERS];
+	ShaderDefinition shaderDefs[4];
+	ShaderProgramDefinition progDefs[NUM_SHADERS * 2];
 
 	llog( LOG_INFO, "  Destroying shaders." );
-	shaders_Destroy( shaderPrograms, NUM_SHADERS );
+	shaders_Destroy( shaderPrograms, NUM_SHADERS * 2 );
 
 	// Sprite shader
 	shaderDefs[0].fileName = NULL;
@@ -81,6 +160,11 @@ int triRenderer_LoadShaders( void )
 	shaderDefs[2].type = GL_FRAGMENT_SHADER;
 	shaderDefs[2].shaderText = FONT_FRAG_SHADER;
 
+	// for sprite instances
+	shaderDefs[3].fileName = NULL;
+	shaderDefs[3].type = GL_VERTEX_SHADER;
+	shaderDefs[3].shaderText = INSTANCED_SPRITE_VERTEX_SHADER;
+
 	progDefs[0].fragmentShader = 1;
 	progDefs[0].vertexShader = 0;
 	progDefs[0].geometryShader = -1;
@@ -91,9 +175,19 @@ int triRenderer_LoadShaders( void )
 	progDefs[1].geometryShader = -1;
 	progDefs[1].uniformNames = "vpMatrix textureUnit0";
 
+	progDefs[INSTANCED_PROGRAM( ST_DEFAULT )].fragmentShader = 1;
+	progDefs[INSTANCED_PROGRAM( ST_DEFAULT )].vertexShader = 3;
+	progDefs[INSTANCED_PROGRAM( ST_DEFAULT )].geometryShader = -1;
+	progDefs[INSTANCED_PROGRAM( ST_DEFAULT )].uniformNames = "vpMatrix textureUnit0 lerpTime zOrderScale camFlags";
+
+	progDefs[INSTANCED_PROGRAM( ST_ALPHA_ONLY )].fragmentShader = 2;
+	progDefs[INSTANCED_PROGRAM( ST_ALPHA_ONLY )].vertexShader = 3;
+	progDefs[INSTANCED_PROGRAM( ST_ALPHA_ONLY )].geometryShader = -1;
+	progDefs[INSTANCED_PROGRAM( ST_ALPHA_ONLY )].uniformNames = "vpMatrix textureUnit0 lerpTime zOrderScale camFlags";
+
 	llog( LOG_INFO, "  Loading shaders." );
 	if( shaders_Load( &( shaderDefs[0] ), sizeof( shaderDefs ) / sizeof( ShaderDefinition ),
-		progDefs, shaderPrograms, NUM_SHADERS ) <= 0 ) {
+		progDefs, shaderPrograms, NUM_SHADERS * 2 ) <= 0 ) {
 		llog( LOG_ERROR, "Error compiling image shaders.\n" );
 		return -1;
 	}
@@ -113,11 +207,14 @@ static int createTriListGLObjects( TriangleList* triList )
 
 	GL( glBindVertexArray( triList->VAO ) );
 
+	// start with room for a single chunk, they'll grow as needed
+	triList->vboSize = sizeof( Vertex ) * CHUNK_VERTS;
 	GL( glBindBuffer( GL_ARRAY_BUFFER, triList->VBO ) );
-	GL( glBufferData( GL_ARRAY_BUFFER, sizeof( triList->vertices ), NULL, GL_DYNAMIC_DRAW ) );
+	GL( glBufferData( GL_ARRAY_BUFFER, triList->vboSize, NULL, GL_STREAM_DRAW ) );
 
+	triList->iboSize = sizeof( GLuint ) * CHUNK_VERTS;
 	GL( glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, triList->IBO ) );
-	GL( glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( triList->indices ), triList->indices, GL_DYNAMIC_DRAW ) );
+	GL( glBufferData( GL_ELEMENT_ARRAY_BUFFER, triList->iboSize, NULL, GL_STREAM_DRAW ) );
 
 	GL( glEnableVertexAttribArray( 0 ) );
 	GL( glEnableVertexAttribArray( 1 ) );
@@ -129,10 +226,40 @@ static int createTriListGLObjects( TriangleList* triList )
 
 	GL( glBindVertexArray( 0 ) );
 
+	// the instances only need the corners of the quad per vertex, everything else advances once per instance
+	GL( glGenVertexArrays( 1, &( triList->instanceVAO ) ) );
+	GL( glGenBuffers( 1, &( triList->instanceVBO ) ) );
+	if( ( triList->instanceVAO == 0 ) || ( triList->instanceVBO == 0 ) ) {
+		llog( LOG_ERROR, "Unable to create one or more storage objects for instanced sprite rendering." );
+		return -1;
+	}
+
+	GL( glBindVertexArray( triList->instanceVAO ) );
+
+	GL( glBindBuffer( GL_ARRAY_BUFFER, quadCornerVBO ) );
+	GL( glEnableVertexAttribArray( 0 ) );
+	GL( glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( Vector2 ), NULL ) );
+
+	// most lists never get any instances, so the storage isn't created until the first time some are drawn
+	triList->instanceVBOSize = 0;
+	for( GLuint i = 1; i <= 9; ++i ) {
+		GL( glEnableVertexAttribArray( i ) );
+		GL( glVertexAttribDivisor( i, 1 ) );
+	}
+
+	GL( glBindVertexArray( 0 ) );
+
 	GL( glBindBuffer( GL_ARRAY_BUFFER, 0 ) );
 
-	triList->lastIndexBufferIndex = -1;
-	triList->lastTriIndex = -1;
+	triList->sbTriangles = NULL;
+	triList->sbVertexChunks = NULL;
+	triList->numVertices = 0;
+	triList->sbIndices = NULL;
+	triList->sbBatches = NULL;
+	triList->sbSortItems = NULL;
+	triList->sbSortScratch = NULL;
+	triList->sbInstances = NULL;
+	triList->sbInstanceData = NULL;
 
 	return 0;
 }
@@ -143,7 +270,7 @@ Initializes all the stuff needed for rendering the triangles.
 */
 int triRenderer_Init( int renderAreaWidth, int renderAreaHeight )
 {
-	for( int i = 0; i < NUM_SHADERS; ++i ) {
+	for( int i = 0; i < ( NUM_SHADERS * 2 ); ++i ) {
 		shaderPrograms[i].programID = 0;
 	}
 
@@ -152,6 +279,15 @@ int triRenderer_Init( int renderAreaWidth, int renderAreaHeight )
 	}
 
 	llog( LOG_INFO, "Creating triangle lists." );
+	GL( glGenBuffers( 1, &quadCornerVBO ) );
+	if( quadCornerVBO == 0 ) {
+		llog( LOG_ERROR, "Unable to create the buffer for instanced sprite corners." );
+		return -1;
+	}
+	GL( glBindBuffer( GL_ARRAY_BUFFER, quadCornerVBO ) );
+	GL( glBufferData( GL_ARRAY_BUFFER, sizeof( QUAD_CORNERS ), QUAD_CORNERS, GL_STATIC_DRAW ) );
+	GL( glBindBuffer( GL_ARRAY_BUFFER, 0 ) );
+
 	if( ( createTriListGLObjects( &solidTriangles ) < 0 ) ||
 		( createTriListGLObjects( &transparentTriangles ) < 0 ) ) {
 		return -1;
@@ -160,39 +296,162 @@ int triRenderer_Init( int renderAreaWidth, int renderAreaHeight )
 	return 0;
 }
 
+static size_t triangleCount( TriangleList* triList )
+{
+	return sb_Count( triList->sbTriangles );
+}
+
+static Vertex* getVertex( TriangleList* triList, GLuint idx )
+{
+	return &( triList->sbVertexChunks[idx >> CHUNK_VERTS_SHIFT][idx & CHUNK_VERTS_MASK] );
+}
+
+// reserves count vertices next to each other, returns NULL if we couldn't get the memory for them
+static Vertex* allocateVertices( TriangleList* triList, size_t count, GLuint* outFirstIdx )
+{
+	size_t first = triList->numVertices;
+	if( ( ( first & CHUNK_VERTS_MASK ) + count ) > CHUNK_VERTS ) {
+		first = ( first + CHUNK_VERTS_MASK ) & ~( (size_t)CHUNK_VERTS_MASK );
+	}
+
+	// chunks are only added, never released, so once a frame with this many vertices has been drawn it won't
+	//  need to allocate again
+	size_t chunk = first >> CHUNK_VERTS_SHIFT;
+	if( chunk >= sb_Count( triList->sbVertexChunks ) ) {
+		Vertex* newChunk = mem_Allocate( sizeof( Vertex ) * CHUNK_VERTS );
+		if( newChunk == NULL ) {
+			llog( LOG_ERROR, "Unable to allocate more space for triangles." );
+			return NULL;
+		}
+		sb_Push( triList->sbVertexChunks, newChunk );
+	}
+
+	triList->numVertices = first + count;
+	(*outFirstIdx) = (GLuint)first;
+	return &( triList->sbVertexChunks[chunk][first & CHUNK_VERTS_MASK] );
+}
+
+static Triangle* addTriangleState( TriangleList* triList, ShaderType shader, GLuint texture, int clippingID,
+	uint32_t camFlags, int8_t depth, uint32_t order )
+{
+	Triangle* tri = sb_Add( triList->sbTriangles, 1 );
+	tri->camFlags = camFlags;
+	tri->texture = texture;
+	tri->zPos = (float)depth;
+	tri->shaderType = shader;
+	tri->scissorID = clippingID;
+	tri->order = order;
+	tri->depth = depth;
+	return tri;
+}
+
 int addTriangle( TriangleList* triList, Vector2 pos0, Vector2 pos1, Vector2 pos2, Vector2 uv0, Vector2 uv1, Vector2 uv2,
 	ShaderType shader, GLuint texture, Color color, int clippingID, uint32_t camFlags, int8_t depth )
 {
-	if( triList->lastTriIndex >= ( MAX_TRIS - 1 ) ) {
-		llog( LOG_VERBOSE, "Triangle list full." );
+	GLuint baseIdx;
+	Vertex* verts = allocateVertices( triList, 3, &baseIdx );
+	if( verts == NULL ) {
 		return -1;
 	}
 
-	float z = (float)depth + ( Z_ORDER_OFFSET * ( solidTriangles.lastTriIndex + transparentTriangles.lastTriIndex + 2 ) );
+	Triangle* tri = addTriangleState( triList, shader, texture, clippingID, camFlags, depth, nextOrder++ );
+
+	vec2ToVec3( &( pos0 ), tri->zPos, &( verts[0].pos ) );
+	verts[0].col = color;
+	verts[0].uv = uv0;
+	tri->vertexIndices[0] = baseIdx;
+
+	vec2ToVec3( &( pos1 ), tri->zPos, &( verts[1].pos ) );
+	verts[1].col = color;
+	verts[1].uv = uv1;
+	tri->vertexIndices[1] = baseIdx + 1;
+
+	vec2ToVec3( &( pos2 ), tri->zPos, &( verts[2].pos ) );
+	verts[2].col = color;
+	verts[2].uv = uv2;
+	tri->vertexIndices[2] = baseIdx + 2;
+
+	return 0;
+}
+
+static int addQuads( TriangleList* triList, const TriQuad* quads, size_t count, ShaderType shader, GLuint texture,
+	int clippingID, uint32_t camFlags, int8_t depth )
+{
+	for( size_t i = 0; i < count; ++i ) {
+		const TriQuad* quad = &( quads[i] );
+
+		GLuint baseIdx;
+		Vertex* verts = allocateVertices( triList, 4, &baseIdx );
+		if( verts == NULL ) {
+			return -1;
+		}
 
-	int idx = triList->lastTriIndex + 1;
-	triList->lastTriIndex = idx;
-	triList->triangles[idx].camFlags = camFlags;
-	triList->triangles[idx].texture = texture;
-	triList->triangles[idx].zPos = z;
-	triList->triangles[idx].shaderType = shader;
-	triList->triangles[idx].scissorID = clippingID;
-	int baseIdx = idx * 3;
+		// same as transforming the unit square by position * rotation * offset * size, without building the matrix
+		float cosRot = cosf( quad->rotation );
+		float sinRot = sinf( quad->rotation );
+		float halfW = quad->size.x * 0.5f;
+		float halfH = quad->size.y * 0.5f;
+
+		float centerX = quad->pos.x + ( quad->offset.x * cosRot ) - ( quad->offset.y * sinRot );
+		float centerY = quad->pos.y + ( quad->offset.x * sinRot ) + ( quad->offset.y * cosRot );
+		float rightX = cosRot * halfW;
+		float rightY = sinRot * halfW;
+		float downX = -sinRot * halfH;
+		float downY = cosRot * halfH;
+
+		float z = (float)depth;
+		verts[0].pos.x = centerX - rightX - downX;
+		verts[0].pos.y = centerY - rightY - downY;
+		verts[0].pos.z = z;
+		verts[0].uv = quad->uvMin;
+
+		verts[1].pos.x = centerX - rightX + downX;
+		verts[1].pos.y = centerY - rightY + downY;
+		verts[1].pos.z = z;
+		verts[1].uv.x = quad->uvMin.x;
+		verts[1].uv.y = quad->uvMax.y;
+
+		verts[2].pos.x = centerX + rightX - downX;
+		verts[2].pos.y = centerY + rightY - downY;
+		verts[2].pos.z = z;
+		verts[2].uv.x = quad->uvMax.x;
+		verts[2].uv.y = quad->uvMin.y;
+
+		verts[3].pos.x = centerX + rightX + downX;
+		verts[3].pos.y = centerY + rightY + downY;
+		verts[3].pos.z = z;
+		verts[3].uv = quad->uvMax;
+
+		for( int v = 0; v < 4; ++v ) {
+			verts[v].col = quad->color;
+		}
 
-	vec2ToVec3( &( pos0 ), z, &( triList->vertices[baseIdx].pos ) );
-	triList->vertices[baseIdx].col = color;
-	triList->vertices[baseIdx].uv = uv0;
-	triList->triangles[idx].vertexIndices[0] = baseIdx;
+		// both triangles get the same order so they end up at the same z
+		uint32_t order = nextOrder++;
+		for( int t = 0; t < 2; ++t ) {
+			Triangle* tri = addTriangleState( triList, shader, texture, clippingID, camFlags, depth, order );
+			tri->vertexIndices[0] = baseIdx + QUAD_INDICES[( t * 3 )];
+			tri->vertexIndices[1] = baseIdx + QUAD_INDICES[( t * 3 ) + 1];
+			tri->vertexIndices[2] = baseIdx + QUAD_INDICES[( t * 3 ) + 2];
+		}
+	}
 
-	vec2ToVec3( &( pos1 ), z, &( triList->vertices[baseIdx+1].pos ) );
-	triList->vertices[baseIdx+1].col = color;
-	triList->vertices[baseIdx+1].uv = uv1;
-	triList->triangles[idx].vertexIndices[1] = baseIdx + 1;
+	return 0;
+}
 
-	vec2ToVec3( &( pos2 ), z, &( triList->vertices[baseIdx+2].pos ) );
-	triList->vertices[baseIdx+2].col = color;
-	triList->vertices[baseIdx+2].uv = uv2;
-	triList->triangles[idx].vertexIndices[2] = baseIdx + 2;
+static int addInstances( TriangleList* triList, const TriSpriteInstance* instances, size_t count, ShaderType shader,
+	GLuint texture, int clippingID, uint32_t camFlags, int8_t depth )
+{
+	SpriteInstance* added = sb_Add( triList->sbInstances, count );
+	for( size_t i = 0; i < count; ++i ) {
+		added[i].data.sprite = instances[i];
+		added[i].data.depth = (float)depth;
+		added[i].data.order = nextOrder++;
+		added[i].data.camFlags = camFlags;
+		added[i].texture = texture;
+		added[i].shaderType = shader;
+		added[i].scissorID = clippingID;
+	}
 
 	return 0;
 }
@@ -218,15 +477,59 @@ int triRenderer_Add( Vector2 pos0, Vector2 pos1, Vector2 pos2, Vector2 uv0, Vect
 	}
 }
 
+/*
+Adds count quads that all share the same render state, each one is four vertices and two triangles. Cheaper than
+ adding each sprite as two separate triangles.
+ Return a value < 0 if there's a problem.
+*/
+int triRenderer_AddQuads( const TriQuad* quads, size_t count, ShaderType shader, GLuint texture, int clippingID,
+	uint32_t camFlags, int8_t depth, int transparent )
+{
+	if( transparent ) {
+		return addQuads( &transparentTriangles, quads, count, shader, texture, clippingID, camFlags, depth );
+	} else {
+		return addQuads( &solidTriangles, quads, count, shader, texture, clippingID, camFlags, depth );
+	}
+}
+
+/*
+Adds count sprites that all share the same render state, the interpolation between their start and end states and
+ the building of their corners is done on the GPU.
+ Return a value < 0 if there's a problem.
+*/
+int triRenderer_AddInstances( const TriSpriteInstance* instances, size_t count, ShaderType shader, GLuint texture,
+	int clippingID, uint32_t camFlags, int8_t depth, int transparent )
+{
+	if( transparent ) {
+		return addInstances( &transparentTriangles, instances, count, shader, texture, clippingID, camFlags, depth );
+	} else {
+		return addInstances( &solidTriangles, instances, count, shader, texture, clippingID, camFlags, depth );
+	}
+}
+
+/*
+Sets where all the instances are between their start and end states when they're drawn, t should be in [0,1].
+*/
+void triRenderer_SetInstanceLerpTime( float t )
+{
+	instanceLerpTime = t;
+}
+
 /*
 Clears out all the triangles currently stored.
 */
 void triRenderer_Clear( void )
 {
-	transparentTriangles.lastTriIndex = -1;
-	solidTriangles.lastTriIndex = -1;
+	sb_Clear( transparentTriangles.sbTriangles );
+	sb_Clear( solidTriangles.sbTriangles );
+	sb_Clear( transparentTriangles.sbInstances );
+	sb_Clear( solidTriangles.sbInstances );
+	transparentTriangles.numVertices = 0;
+	solidTriangles.numVertices = 0;
+	nextOrder = 0;
 }
 
+// the old comparison sorts, only kept around so the benchmark has something to compare against
 static int sortByRenderState( const void* p1, const void* p2 )
 {
 	Triangle* tri1 = (Triangle*)p1;
@@ -253,10 +556,193 @@ static int sortByDepth( const void* p1, const void* p2 )
 	return ( ( ( tri1->zPos ) - ( tri2->zPos ) ) > 0.0f ) ? 1 : -1;
 }
 
+// shader in the top 8 bits, then the 32 bit texture, then the scissor in the bottom 24 bits, we only need triangles
+//  with the same state to end up next to each other so the scissor being cut off doesn't matter
+static uint64_t renderStateKey( ShaderType shaderType, GLuint texture, int scissorID )
+{
+	return ( ( (uint64_t)( shaderType & 0xFF ) ) << 56 ) |
+		( ( (uint64_t)texture ) << 24 ) |
+		( (uint64_t)( (uint32_t)scissorID & 0xFFFFFF ) );
+}
+
+// same ordering as the z position, the depth moved to be unsigned and then the order it was added in
+static uint64_t depthKey( int depth, uint32_t order )
+{
+	return ( ( (uint64_t)(uint8_t)( depth + 128 ) ) << 32 ) | (uint64_t)order;
+}
+
+// least significant digit radix sort on the keys, a byte at a time, stable so triangles with the same key stay in
+//  the order they were added. all the histograms are built in one pass, and any byte that's the same for every key
+//  is skipped, which is most of them since textures and depths don't use their full range
+static void radixSortItems( TriangleList* triList )
+{
+	size_t count = sb_Count( triList->sbSortItems );
+	if( count <= 1 ) {
+		return;
+	}
+
+	sb_Clear( triList->sbSortScratch );
+	sb_Add( triList->sbSortScratch, count );
+
+	size_t histograms[8][256];
+	memset( histograms, 0, sizeof( histograms ) );
+	for( size_t i = 0; i < count; ++i ) {
+		uint64_t key = triList->sbSortItems[i].key;
+		for( int b = 0; b < 8; ++b ) {
+			++( histograms[b][( key >> ( b * 8 ) ) & 0xFF] );
+		}
+	}
+
+	SortItem* src = triList->sbSortItems;
+	SortItem* dest = triList->sbSortScratch;
+	for( int b = 0; b < 8; ++b ) {
+		size_t* histogram = histograms[b];
+		int shift = b * 8;
+
+		if( histogram[( src[0].key >> shift ) & 0xFF] == count ) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for( int d = 0; d < 256; ++d ) {
+			size_t digitCount = histogram[d];
+			histogram[d] = offset;
+			offset += digitCount;
+		}
+
+		for( size_t i = 0; i < count; ++i ) {
+			dest[histogram[( src[i].key >> shift ) & 0xFF]++] = src[i];
+		}
+
+		SortItem* temp = src;
+		src = dest;
+		dest = temp;
+	}
+
+	// the sorted items may have ended up in the scratch buffer
+	if( src != triList->sbSortItems ) {
+		triList->sbSortScratch = triList->sbSortItems;
+		triList->sbSortItems = src;
+	}
+}
+
+// the triangles and instances are sorted together so transparent instances are still drawn in the correct order
+//  compared to everything else, the instances are then gathered in that order so each batch of them is contiguous
+static void sortTriangles( TriangleList* triList, bool byDepth )
+{
+	size_t count = triangleCount( triList );
+	size_t numInstances = sb_Count( triList->sbInstances );
+	sb_Clear( triList->sbSortItems );
+	sb_Clear( triList->sbInstanceData );
+	if( ( count + numInstances ) == 0 ) {
+		return;
+	}
+
+	SortItem* items = sb_Add( triList->sbSortItems, count + numInstances );
+	for( size_t i = 0; i < count; ++i ) {
+		Triangle* tri = &( triList->sbTriangles[i] );
+		items[i].key = byDepth ? depthKey( tri->depth, tri->order ) : renderStateKey( tri->shaderType, tri->texture, tri->scissorID );
+		items[i].item = (uint32_t)i;
+	}
+
+	for( size_t i = 0; i < numInstances; ++i ) {
+		SpriteInstance* inst = &( triList->sbInstances[i] );
+		items[count + i].key = byDepth ? depthKey( (int)inst->data.depth, inst->data.order ) : renderStateKey( inst->shaderType, inst->texture, inst->scissorID );
+		items[count + i].item = (uint32_t)i | INSTANCE_ITEM;
+	}
+
+	radixSortItems( triList );
+
+	if( numInstances > 0 ) {
+		InstanceData* data = sb_Add( triList->sbInstanceData, numInstances );
+		for( size_t i = 0; i < sb_Count( triList->sbSortItems ); ++i ) {
+			uint32_t item = triList->sbSortItems[i].item;
+			if( item & INSTANCE_ITEM ) {
+				(*data) = triList->sbInstances[item & ~INSTANCE_ITEM].data;
+				++data;
+			}
+		}
+	}
+}
+
+// each triangle is put in front of the ones added before it at the same depth, spread out over [depth, depth + 0.5)
+//  the instances do the same thing in their shader
+static void setDepths( TriangleList* triList )
+{
+	size_t count = triangleCount( triList );
+	for( size_t i = 0; i < count; ++i ) {
+		Triangle* tri = &( triList->sbTriangles[i] );
+		tri->zPos = (float)tri->depth + ( zOrderScale * (float)tri->order );
+
+		getVertex( triList, tri->vertexIndices[0] )->pos.z = tri->zPos;
+		getVertex( triList, tri->vertexIndices[1] )->pos.z = tri->zPos;
+		getVertex( triList, tri->vertexIndices[2] )->pos.z = tri->zPos;
+	}
+}
+
+// orphans the buffer currently bound to target so we don't have to wait for the previous frame to be done with
+//  it, growing it if there's not enough room for size bytes
+static void prepareStreamingBuffer( GLenum target, size_t* bufferSize, size_t size )
+{
+	if( size > (*bufferSize) ) {
+		while( (*bufferSize) < size ) {
+			(*bufferSize) *= 2;
+		}
+	}
+	GL( glBufferData( target, (GLsizeiptr)(*bufferSize), NULL, GL_STREAM_DRAW ) );
+}
+
 static void generateVertexArray( TriangleList* triList )
 {
+	size_t count = triList->numVertices;
+	if( count == 0 ) {
+		return;
+	}
+
 	GL( glBindBuffer( GL_ARRAY_BUFFER, triList->VBO ) );
-	GL( glBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( Vertex ) * ( ( triList->lastTriIndex + 1 ) * 3 ), triList->vertices ) );
+	prepareStreamingBuffer( GL_ARRAY_BUFFER, &( triList->vboSize ), sizeof( Vertex ) * count );
+
+	for( size_t start = 0; start < count; start += CHUNK_VERTS ) {
+		size_t chunkVerts = ( ( count - start ) > CHUNK_VERTS ) ? CHUNK_VERTS : ( count - start );
+		size_t size = sizeof( Vertex ) * chunkVerts;
+		GL( glBufferSubData( GL_ARRAY_BUFFER, (GLintptr)( sizeof( Vertex ) * start ), (GLsizeiptr)size, triList->sbVertexChunks[start >> CHUNK_VERTS_SHIFT] ) );
+		lastFrameStats.bytesUploaded += size;
+	}
+}
+
+static void uploadInstances( TriangleList* triList )
+{
+	size_t count = sb_Count( triList->sbInstanceData );
+	if( count == 0 ) {
+		return;
+	}
+
+	size_t size = sizeof( InstanceData ) * count;
+	if( triList->instanceVBOSize == 0 ) {
+		triList->instanceVBOSize = size;
+	}
+	GL( glBindBuffer( GL_ARRAY_BUFFER, triList->instanceVBO ) );
+	prepareStreamingBuffer( GL_ARRAY_BUFFER, &( triList->instanceVBOSize ), size );
+	GL( glBufferSubData( GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, triList->sbInstanceData ) );
+	lastFrameStats.bytesUploaded += size;
+}
+
+// there's no base instance in OpenGL 3.3 or ES 3, so to draw a batch of instances that doesn't start at the
+//  beginning of the buffer we point the attributes at the first one, the instance VAO and VBO must be bound
+static void pointInstanceAttributes( size_t firstInstance )
+{
+	const uint8_t* base = (const uint8_t*)( sizeof( InstanceData ) * firstInstance );
+	GLsizei stride = sizeof( InstanceData );
+
+	GL( glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.startPos ) ) );
+	GL( glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.startSize ) ) );
+	GL( glVertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.startColor ) ) );
+	GL( glVertexAttribPointer( 4, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.endColor ) ) );
+	GL( glVertexAttribPointer( 5, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.startRotation ) ) );
+	GL( glVertexAttribPointer( 6, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.offset ) ) );
+	GL( glVertexAttribPointer( 7, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, sprite.uvMin ) ) );
+	GL( glVertexAttribPointer( 8, 1, GL_FLOAT, GL_FALSE, stride, base + offsetof( InstanceData, depth ) ) );
+	GL( glVertexAttribIPointer( 9, 2, GL_UNSIGNED_INT, stride, base + offsetof( InstanceData, order ) ) );
 }
 
 static void setScissor( int area )
@@ -270,75 +756,142 @@ static void setScissor( int area )
 	GL( glScissor( x, y, w, h ) );
 }
 
+static bool batchMatches( DrawBatch* batch, bool instanced, GLuint texture, ShaderType shaderType, int scissorID )
+{
+	return ( batch != NULL ) && ( batch->instanced == instanced ) && ( batch->texture == texture ) &&
+		( batch->shaderType == shaderType ) && ( batch->scissorID == scissorID );
+}
+
+static DrawBatch* startBatch( TriangleList* triList, bool instanced, GLuint texture, ShaderType shaderType, int scissorID,
+	size_t first )
+{
+	DrawBatch* batch = sb_Add( triList->sbBatches, 1 );
+	batch->texture = texture;
+	batch->shaderType = shaderType;
+	batch->scissorID = scissorID;
+	batch->firstIndex = first;
+	batch->numIndices = 0;
+	batch->instanced = instanced;
+	return batch;
+}
+
+// gathers the indices for all the triangles the camera can see into batches that share the same render state, so
+//  the index buffer only has to be sent once for each camera
+// instances are all uploaded once, so batches of them are ranges of the instance buffer
+static void buildBatches( uint32_t camFlags, TriangleList* triList )
+{
+	sb_Clear( triList->sbIndices );
+	sb_Clear( triList->sbBatches );
+
+	DrawBatch* batch = NULL;
+	size_t nextInstance = 0;
+	size_t count = sb_Count( triList->sbSortItems );
+	for( size_t i = 0; i < count; ++i ) {
+		uint32_t item = triList->sbSortItems[i].item;
+
+		if( item & INSTANCE_ITEM ) {
+			size_t instanceIdx = nextInstance;
+			++nextInstance;
+
+			SpriteInstance* inst = &( triList->sbInstances[item & ~INSTANCE_ITEM] );
+			if( ( inst->data.camFlags & camFlags ) == 0 ) {
+				continue;
+			}
+
+			// any instances skipped since the last one in the batch can't be seen by this camera, so they can be
+			//  drawn as part of it and the shader will hide them
+			if( batchMatches( batch, true, inst->texture, inst->shaderType, inst->scissorID ) ) {
+				batch->numIndices = instanceIdx - batch->firstIndex + 1;
+			} else {
+				batch = startBatch( triList, true, inst->texture, inst->shaderType, inst->scissorID, instanceIdx );
+				batch->numIndices = 1;
+			}
+			continue;
+		}
+
+		Triangle* tri = &( triList->sbTriangles[item] );
+		if( ( tri->camFlags & camFlags ) == 0 ) {
+			continue;
+		}
+
+		if( !batchMatches( batch, false, tri->texture, tri->shaderType, tri->scissorID ) ) {
+			batch = startBatch( triList, false, tri->texture, tri->shaderType, tri->scissorID, sb_Count( triList->sbIndices ) );
+		}
+
+		GLuint* indices = sb_Add( triList->sbIndices, 3 );
+		indices[0] = tri->vertexIndices[0];
+		indices[1] = tri->vertexIndices[1];
+		indices[2] = tri->vertexIndices[2];
+		batch->numIndices += 3;
+	}
+}
+
 static void drawTriangles( uint32_t currCamera, TriangleList* triList )
 {
-	// create the index buffers to access the vertex buffer
-	//  TODO: Test to see if having the index buffer or the vertex buffer in order is faster
-	GLuint lastBoundTexture = 0;
-	int triIdx = 0;
-	ShaderType lastBoundShader = NUM_SHADERS;
-	Matrix4 vpMat;
-	uint32_t camFlags = 0;
+	int lastBoundProgram = -1;
 	int lastSetClippingArea = -1;
+	Matrix4 vpMat;
 
-	// we'll only be accessing the one vertex array
-	GL( glBindVertexArray( triList->VAO ) );
+	uint32_t camFlags = cam_GetFlags( currCamera );
+	buildBatches( camFlags, triList );
+	if( sb_Count( triList->sbBatches ) == 0 ) {
+		return;
+	}
 
-	do {
-		GLuint texture = triList->triangles[triIdx].texture;
-		triList->lastIndexBufferIndex = -1;
+	cam_GetVPMatrix( currCamera, &vpMat );
 
-		if( ( triIdx <= triList->lastTriIndex ) && ( triList->triangles[triIdx].shaderType != lastBoundShader ) ) {
-			// next shader, bind and set up
-			lastBoundShader = triList->triangles[triIdx].shaderType;
+	// the index buffer is part of the triangle vertex array's state
+	GL( glBindVertexArray( triList->VAO ) );
+	bool instanceArrayBound = false;
 
-			camFlags = cam_GetFlags( currCamera );
-			cam_GetVPMatrix( currCamera, &vpMat );
+	size_t indicesSize = sizeof( GLuint ) * sb_Count( triList->sbIndices );
+	if( indicesSize > 0 ) {
+		prepareStreamingBuffer( GL_ELEMENT_ARRAY_BUFFER, &( triList->iboSize ), indicesSize );
+		GL( glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)indicesSize, triList->sbIndices ) );
+		lastFrameStats.bytesUploaded += indicesSize;
+	}
 
-			GL( glUseProgram( shaderPrograms[lastBoundShader].programID ) );
-			GL( glUniformMatrix4fv( shaderPrograms[lastBoundShader].uniformLocs[0], 1, GL_FALSE, &( vpMat.m[0] ) ) );
-			GL( glUniform1i( shaderPrograms[lastBoundShader].uniformLocs[1], 0 ) );
-		}
+	for( size_t i = 0; i < sb_Count( triList->sbBatches ); ++i ) {
+		DrawBatch* batch = &( triList->sbBatches[i] );
 
-		if( ( triIdx <= triList->lastTriIndex ) && ( triList->triangles[triIdx].scissorID != lastSetClippingArea ) ) {
-			lastSetClippingArea = triList->triangles[triIdx].scissorID;
-			setScissor( lastSetClippingArea );
+		if( batch->instanced != instanceArrayBound ) {
+			instanceArrayBound = batch->instanced;
+			if( instanceArrayBound ) {
+				GL( glBindVertexArray( triList->instanceVAO ) );
+				GL( glBindBuffer( GL_ARRAY_BUFFER, triList->instanceVBO ) );
+			} else {
+				GL( glBindVertexArray( triList->VAO ) );
+			}
 		}
 
-		int triCount = 0;
-		// gather the list of all the triangles to be drawn
-		while( ( triIdx <= triList->lastTriIndex ) &&
-				( triList->triangles[triIdx].texture == texture ) &&
-				( triList->triangles[triIdx].shaderType == lastBoundShader ) &&
-				( triList->triangles[triIdx].scissorID == lastSetClippingArea ) ) {
-			if( ( triList->triangles[triIdx].camFlags & camFlags ) != 0 ) {
-				triList->indices[++triList->lastIndexBufferIndex] = triList->triangles[triIdx].vertexIndices[0];
-				triList->indices[++triList->lastIndexBufferIndex] = triList->triangles[triIdx].vertexIndices[1];
-				triList->indices[++triList->lastIndexBufferIndex] = triList->triangles[triIdx].vertexIndices[2];
+		int program = batch->instanced ? INSTANCED_PROGRAM( batch->shaderType ) : (int)batch->shaderType;
+		if( program != lastBoundProgram ) {
+			// next shader, bind and set up
+			lastBoundProgram = program;
+
+			GL( glUseProgram( shaderPrograms[program].programID ) );
+			GL( glUniformMatrix4fv( shaderPrograms[program].uniformLocs[0], 1, GL_FALSE, &( vpMat.m[0] ) ) );
+			GL( glUniform1i( shaderPrograms[program].uniformLocs[1], 0 ) );
+			if( batch->instanced ) {
+				GL( glUniform1f( shaderPrograms[program].uniformLocs[2], instanceLerpTime ) );
+				GL( glUniform1f( shaderPrograms[program].uniformLocs[3], zOrderScale ) );
+				GL( glUniform1ui( shaderPrograms[program].uniformLocs[4], camFlags ) );
 			}
-			++triIdx;
-			++triCount;
 		}
 
-		// send the indices of the vertex array to draw, if there is any
-		if( triList->lastIndexBufferIndex < 0 ) {
-			continue;
+		if( batch->scissorID != lastSetClippingArea ) {
+			lastSetClippingArea = batch->scissorID;
+			setScissor( lastSetClippingArea );
 		}
-		GL( glBindTexture( GL_TEXTURE_2D, texture ) );
-		GL( glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, sizeof( GLuint ) * ( triList->lastIndexBufferIndex + 1 ), triList->indices ) );
-		GL( glDrawElements( GL_TRIANGLES, triList->lastIndexBufferIndex + 1, GL_UNSIGNED_INT, NULL ) );
-	} while( triIdx <= triList->lastTriIndex );
-}
 
-static void lerpVertices( TriangleList* triList, float t )
-{
-	for( int i = 0; i < triList->lastTriIndex; ++i ) {
-		int baseIdx = i * 3;
-		for( int s = 0; s < 3; ++i ) {
-			triList->vertices[baseIdx+s].uv = triList->startVertices[baseIdx+s].uv;
-			vec3_Lerp( &( triList->startVertices[baseIdx+s].pos ), &( triList->endVertices[baseIdx+s].pos ), t, &( triList->vertices[baseIdx+s].pos ) );
-			clr_Lerp( &( triList->startVertices[baseIdx+s].col ), &( triList->endVertices[baseIdx+s].col ), t, &( triList->vertices[baseIdx+s].col ) );
+		GL( glBindTexture( GL_TEXTURE_2D, batch->texture ) );
+		if( batch->instanced ) {
+			pointInstanceAttributes( batch->firstIndex );
+			GL( glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, (GLsizei)batch->numIndices ) );
+		} else {
+			GL( glDrawElements( GL_TRIANGLES, (GLsizei)batch->numIndices, GL_UNSIGNED_INT, (const GLvoid*)( sizeof( GLuint ) * batch->firstIndex ) ) );
 		}
+		++( lastFrameStats.drawCalls );
 	}
 }
 
@@ -347,13 +900,23 @@ Draws out all the triangles.
 */
 void triRenderer_Render( )
 {
-	// SDL_qsort appears to break some times, so fall back onto the standard library qsort for right now, and implement our own when we have time
-	qsort( solidTriangles.triangles, solidTriangles.lastTriIndex + 1, sizeof( Triangle ), sortByRenderState );
-	qsort( transparentTriangles.triangles, transparentTriangles.lastTriIndex + 1, sizeof( Triangle ), sortByDepth );
+	lastFrameStats.triangles = (uint32_t)( triangleCount( &solidTriangles ) + triangleCount( &transparentTriangles ) +
+		( 2 * ( sb_Count( solidTriangles.sbInstances ) + sb_Count( transparentTriangles.sbInstances ) ) ) );
+	lastFrameStats.drawCalls = 0;
+	lastFrameStats.bytesUploaded = 0;
+
+	zOrderScale = 1.0f / (float)( 2 * ( (size_t)nextOrder + 1 ) );
+	setDepths( &solidTriangles );
+	setDepths( &transparentTriangles );
 
-	// now that the triangles have been sorted create the vertex arrays
+	sortTriangles( &solidTriangles, false );
+	sortTriangles( &transparentTriangles, true );
+
+	// the vertices are sent in the order they were added, the sorted order is used when building the index buffers
 	generateVertexArray( &solidTriangles );
 	generateVertexArray( &transparentTriangles );
+	uploadInstances( &solidTriangles );
+	uploadInstances( &transparentTriangles );
 
 	GL( glDisable( GL_CULL_FACE ) );
 	GL( glEnable( GL_DEPTH_TEST ) );
@@ -378,4 +941,206 @@ void triRenderer_Render( )
 	GL( glDisable( GL_SCISSOR_TEST ) );
 	GL( glBindVertexArray( 0 ) );
 	GL( glUseProgram( 0 ) );
-}
\ No newline at end of file
+}
+
+/*
+Returns what was drawn by the last call to triRenderer_Render( ).
+*/
+TriRendererStats triRenderer_GetLastFrameStats( void )
+{
+	return lastFrameStats;
+}
+
+#define BENCHMARK_TEXTURES 8
+
+typedef struct {
+	// indexed by whether it was sorted by depth
+	double qsortMS[2];
+	double radixMS[2];
+} SortBenchmarkResults;
+
+// sorts numTriangles random triangles with the radix sort and the old qsort on the whole triangles, for both the
+//  render state and depth orders, checking they give the same order and keeping the fastest times in out
+//  returns a value < 0 if it couldn't be run
+static int runSortBenchmark( uint32_t numTriangles, uint32_t runs, SortBenchmarkResults* out )
+{
+	TriangleList list;
+	memset( &list, 0, sizeof( list ) );
+	Triangle* qsortTris = mem_Allocate( sizeof( Triangle ) * ( numTriangles + 1 ) );
+	if( qsortTris == NULL ) {
+		llog( LOG_ERROR, "Unable to allocate triangles for sort benchmark." );
+		return -1;
+	}
+
+	RandomGroup rand;
+	rand_Seed( &rand, 2048 );
+
+	Triangle* tris = sb_Add( list.sbTriangles, numTriangles );
+	memset( tris, 0, sizeof( Triangle ) * numTriangles );
+	for( uint32_t i = 0; i < numTriangles; ++i ) {
+		tris[i].shaderType = ( rand_GetRangeS32( &rand, 0, 7 ) == 0 ) ? ST_ALPHA_ONLY : ST_DEFAULT;
+		tris[i].texture = (GLuint)rand_GetRangeS32( &rand, 1, 64 );
+		tris[i].scissorID = rand_GetRangeS32( &rand, 0, 3 );
+		tris[i].depth = (int8_t)rand_GetRangeS32( &rand, -10, 10 );
+		tris[i].order = i;
+		tris[i].zPos = (float)tris[i].depth + ( (float)i / (float)( 2 * ( numTriangles + 1 ) ) );
+	}
+
+	for( int byDepth = 0; byDepth < 2; ++byDepth ) {
+		for( uint32_t r = 0; r < runs; ++r ) {
+			memcpy( qsortTris, tris, sizeof( Triangle ) * numTriangles );
+			Uint64 start = SDL_GetPerformanceCounter( );
+			qsort( qsortTris, numTriangles, sizeof( Triangle ), byDepth ? sortByDepth : sortByRenderState );
+			out->qsortMS[byDepth] = test_Fastest( out->qsortMS[byDepth], test_MSSince( start ), r );
+
+			start = SDL_GetPerformanceCounter( );
+			sortTriangles( &list, ( byDepth != 0 ) );
+			out->radixMS[byDepth] = test_Fastest( out->radixMS[byDepth], test_MSSince( start ), r );
+		}
+
+		// depth orders are unique so they should match exactly, render states only need to be grouped the same way
+		bool matches = ( sb_Count( list.sbSortItems ) == numTriangles );
+		for( uint32_t i = 0; matches && ( i < numTriangles ); ++i ) {
+			Triangle* sorted = &( tris[list.sbSortItems[i].item] );
+			if( byDepth ) {
+				matches = ( sorted->order == qsortTris[i].order );
+			} else {
+				matches = ( sortByRenderState( sorted, &( qsortTris[i] ) ) == 0 );
+			}
+		}
+		TEST_CHECK( matches, byDepth ? "radix sort depth order matches qsort" : "radix sort render state order matches qsort" );
+	}
+
+	mem_Release( qsortTris );
+	sb_Release( list.sbTriangles );
+	sb_Release( list.sbSortItems );
+	sb_Release( list.sbSortScratch );
+
+	return 0;
+}
+
+// adds numSprites random 32x32 sprites spread over the textures, as quads or two triangles each, returns whether
+//  they were all added
+static bool addBenchmarkSprites( RandomGroup* rand, GLuint* textures, uint32_t numSprites, int useQuads )
+{
+	bool added = true;
+	for( uint32_t i = 0; i < numSprites; ++i ) {
+		Vector2 topLeft = { rand_GetRangeFloat( rand, 0.0f, 800.0f ), rand_GetRangeFloat( rand, 0.0f, 600.0f ) };
+		Vector2 topRight = { topLeft.x + 32.0f, topLeft.y };
+		Vector2 bottomLeft = { topLeft.x, topLeft.y + 32.0f };
+		Vector2 bottomRight = { topLeft.x + 32.0f, topLeft.y + 32.0f };
+		GLuint texture = textures[i % BENCHMARK_TEXTURES];
+		int8_t depth = (int8_t)rand_GetRangeS32( rand, -10, 10 );
+		int transparent = ( ( i % 4 ) == 0 );
+
+		if( useQuads ) {
+			TriQuad quad;
+			quad.pos.x = topLeft.x + 16.0f;
+			quad.pos.y = topLeft.y + 16.0f;
+			quad.size.x = 32.0f;
+			quad.size.y = 32.0f;
+			quad.offset = VEC2_ZERO;
+			quad.rotation = 0.0f;
+			quad.uvMin = VEC2_ZERO;
+			quad.uvMax = VEC2_ZERO;
+			quad.color = CLR_WHITE;
+			added = ( triRenderer_AddQuads( &quad, 1, ST_DEFAULT, texture, 0, ~( (uint32_t)0 ), depth, transparent ) >= 0 ) && added;
+		} else {
+			added = ( triRenderer_Add( topLeft, topRight, bottomLeft, VEC2_ZERO, VEC2_ZERO, VEC2_ZERO,
+				ST_DEFAULT, texture, CLR_WHITE, 0, ~( (uint32_t)0 ), depth, transparent ) >= 0 ) && added;
+			added = ( triRenderer_Add( topRight, bottomRight, bottomLeft, VEC2_ZERO, VEC2_ZERO, VEC2_ZERO,
+				ST_DEFAULT, texture, CLR_WHITE, 0, ~( (uint32_t)0 ), depth, transparent ) >= 0 ) && added;
+		}
+	}
+	return added;
+}
+
+/*
+Adds more sprites than the lists used to be able to hold, both as triangles and as quads, and checks they're all
+ drawn, then checks the radix sort orders a smaller set of triangles the same way qsort does. Clears out anything
+ that was added before.
+*/
+void triRenderer_RunTests( void )
+{
+	// more than the 2048 triangles the lists were fixed to before they could grow
+	const uint32_t NUM_SPRITES = 3000;
+
+	GLuint textures[BENCHMARK_TEXTURES];
+	RandomGroup rand;
+	rand_Seed( &rand, 2048 );
+
+	GL( glGenTextures( BENCHMARK_TEXTURES, textures ) );
+
+	for( int useQuads = 0; useQuads < 2; ++useQuads ) {
+		triRenderer_Clear( );
+		TEST_CHECK( addBenchmarkSprites( &rand, textures, NUM_SPRITES, useQuads ),
+			useQuads ? "all the quads were added" : "all the triangles were added" );
+		triRenderer_Render( );
+		TEST_CHECK( lastFrameStats.triangles == ( NUM_SPRITES * 2 ), "all the added triangles were drawn" );
+	}
+
+	triRenderer_Clear( );
+	GL( glDeleteTextures( BENCHMARK_TEXTURES, textures ) );
+
+	// the radix sort has to put the triangles in the same order as sorting them with qsort
+	SortBenchmarkResults sortResults;
+	memset( &sortResults, 0, sizeof( sortResults ) );
+	TEST_CHECK( runSortBenchmark( 1000, 1, &sortResults ) >= 0, "triangle sort ran" );
+}
+
+/*
+Adds numSprites quads spread over a few textures and renders them for a number of frames, logging how long it took
+ and how much was sent to the buffers each frame. Clears out anything that was added before.
+*/
+void triRenderer_RunBenchmark( uint32_t numSprites, uint32_t frames, int useQuads )
+{
+	GLuint textures[BENCHMARK_TEXTURES];
+	RandomGroup rand;
+	rand_Seed( &rand, 2048 );
+
+	GL( glGenTextures( BENCHMARK_TEXTURES, textures ) );
+
+	llog( LOG_INFO, "Triangle renderer benchmark: %u sprites as %s, %u frames", numSprites, useQuads ? "quads" : "triangles", frames );
+
+	double bestMS = 0.0;
+	bool added = true;
+	bool drawn = true;
+	for( uint32_t f = 0; f < frames; ++f ) {
+		Uint64 start = SDL_GetPerformanceCounter( );
+
+		triRenderer_Clear( );
+		added = addBenchmarkSprites( &rand, textures, numSprites, useQuads ) && added;
+		triRenderer_Render( );
+		GL( glFinish( ) );
+
+		bestMS = test_Fastest( bestMS, test_MSSince( start ), f );
+		drawn = drawn && ( lastFrameStats.triangles == ( numSprites * 2 ) );
+	}
+
+	llog( LOG_INFO, "  %u triangles, %u draw calls, %.2f MB uploaded per frame, best frame %.3f ms",
+		lastFrameStats.triangles, lastFrameStats.drawCalls, (double)lastFrameStats.bytesUploaded / ( 1024.0 * 1024.0 ), bestMS );
+	TEST_CHECK( added, "all the benchmark sprites were added" );
+	TEST_CHECK( drawn, "all the benchmark triangles were drawn" );
+
+	triRenderer_Clear( );
+	GL( glDeleteTextures( BENCHMARK_TEXTURES, textures ) );
+}
+
+/*
+Times sorting numTriangles triangles with the radix sort against the old qsort on the whole triangles, for both the
+ render state and depth orders. Doesn't touch OpenGL or the triangles that have been added.
+*/
+void triRenderer_RunSortBenchmark( uint32_t numTriangles, uint32_t runs )
+{
+	llog( LOG_INFO, "Triangle sort benchmark: %u triangles, %u runs", numTriangles, runs );
+
+	SortBenchmarkResults results;
+	memset( &results, 0, sizeof( results ) );
+	if( runSortBenchmark( numTriangles, runs, &results ) < 0 ) {
+		return;
+	}
+
+	for( int byDepth = 0; byDepth < 2; ++byDepth ) {
+		llog( LOG_INFO, "  %s: qsort %.3f ms, radix %.3f ms", byDepth ? "depth" : "render state", results.qsortMS[byDepth], results.radixMS[byDepth] );
+	}
+}
@@ -2,6 +2,7 @@
 #define TRI_RENDERING_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "../Graphics/glPlatform.h"
 #include "glPlatform.h"
@@ -15,6 +16,39 @@ typedef enum {
 	NUM_SHADERS
 } ShaderType;
 
+// a sprite for triRenderer_AddQuads( ), the corners are found from these without building a matrix
+typedef struct {
+	Vector2 pos;
+	Vector2 size;
+	Vector2 offset; // from pos to the center of the quad, rotated along with it
+	float rotation;
+	Vector2 uvMin;
+	Vector2 uvMax;
+	Color color;
+} TriQuad;
+
+// a sprite for triRenderer_AddInstances( ), interpolated between its start and end states on the GPU
+//  the start and end values of each pair have to stay next to each other, they're read as one attribute
+typedef struct {
+	Vector2 startPos;
+	Vector2 endPos;
+	Vector2 startSize;
+	Vector2 endSize;
+	Color startColor;
+	Color endColor;
+	float startRotation;
+	float endRotation;
+	Vector2 offset; // from the position to the center of the quad, rotated along with it
+	Vector2 uvMin;
+	Vector2 uvMax;
+} TriSpriteInstance;
+
+typedef struct {
+	uint32_t triangles;
+	uint32_t drawCalls;
+	size_t bytesUploaded; // vertex and index data sent to the buffers
+} TriRendererStats;
+
 /*
 Makes all the shaders reload.
 */
@@ -35,6 +69,27 @@ int triRenderer_AddVertices( Vector2* positions, Vector2* uvs, ShaderType shader
 int triRenderer_Add( Vector2 pos0, Vector2 pos1, Vector2 pos2, Vector2 uv0, Vector2 uv1, Vector2 uv2, ShaderType shader, GLuint texture,
 	Color color, int clippingID, uint32_t camFlags, int8_t depth, int transparent );
 
+/*
+Adds count quads that all share the same render state, each one is four vertices and two triangles. Cheaper than
+ adding each sprite as two separate triangles.
+ Return a value < 0 if there's a problem.
+*/
+int triRenderer_AddQuads( const TriQuad* quads, size_t count, ShaderType shader, GLuint texture, int clippingID,
+	uint32_t camFlags, int8_t depth, int transparent );
+
+/*
+Adds count sprites that all share the same render state, the interpolation between their start and end states and
+ the building of their corners is done on the GPU.
+ Return a value < 0 if there's a problem.
+*/
+int triRenderer_AddInstances( const TriSpriteInstance* instances, size_t count, ShaderType shader, GLuint texture,
+	int clippingID, uint32_t camFlags, int8_t depth, int transparent );
+
+/*
+Sets where all the instances are between their start and end states when they're drawn, t should be in [0,1].
+*/
+void triRenderer_SetInstanceLerpTime( float t );
+
 /*
 Clears out all the triangles currently stored.
 */
@@ -45,4 +100,30 @@ Draws out all the triangles.
 */
 void triRenderer_Render( );
 
+/*
+Returns what was drawn by the last call to triRenderer_Render( ).
+*/
+TriRendererStats triRenderer_GetLastFrameStats( void );
+
+/*
+Adds more sprites than the triangle lists start out with room for and checks they're all drawn, and checks the
+ radix sort orders triangles the same way qsort does, asserting if anything fails. Clears out anything that was added before.
+ The triangle renderer and cameras must have been initialized.
+*/
+void triRenderer_RunTests( void );
+
+/*
+Adds numSprites quads spread over a few textures and renders them for a number of frames, logging how long it took
+ and how much was sent to the buffers each frame. Clears out anything that was added before.
+ If useQuads is set the sprites are added with triRenderer_AddQuads( ), otherwise as two triangles each.
+ The triangle renderer and cameras must have been initialized, can be run headless with a software renderer like llvmpipe.
+*/
+void triRenderer_RunBenchmark( uint32_t numSprites, uint32_t frames, int useQuads );
+
+/*
+Times the radix sort used to order the triangles against the old qsort for numTriangles random triangles, checking
+ they give the same order. Doesn't need OpenGL.
+*/
+void triRenderer_RunSortBenchmark( uint32_t numTriangles, uint32_t runs );
+
 #endif /* inclusion guard */
\ No newline at end of file
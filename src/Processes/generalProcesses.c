@@ -17,41 +17,63 @@
 // move all of these into separate files?
 
 // ***** Render Process
+//  each chunk only touches its own entities and records its draws separately, so it's safe to run across threads,
+//  the recordings are added to the draw list in the order the chunks would have been run on a single thread
 Process gpRenderProc;
-static void render( ECPS* ecps, const Entity* entity )
+static void render( ECPS* ecps, const EntityChunk* chunk )
 {
-	GCPosData* pos = NULL;
-	GCSpriteData* sd = NULL;
-	GCScaleData* scale = NULL;
-	GCColorData* color = NULL;
-
-	ecps_GetComponentFromEntity( entity, gcPosCompID, &pos );
-	ecps_GetComponentFromEntity( entity, gcSpriteCompID, &sd );
-
-	Vector2 currPos = pos->currPos;
-	Vector2 futurePos = pos->futurePos;
+	uint8_t* pos;
+	const uint8_t* sprite;
+	uint8_t* scale;
+	uint8_t* color;
+	size_t posStride;
+	size_t spriteStride;
+	size_t scaleStride;
+	size_t colorStride;
+
+	ecps_GetChunkComponent( chunk, gcPosCompID, (void**)&pos, &posStride );
+	// the sprite is only read, so it isn't marked as changed
+	ecps_ReadChunkComponent( chunk, gcSpriteCompID, (const void**)&sprite, &spriteStride );
+
+	// every entity in the chunk has the same components, so only need to check for the optional ones once
+	bool hasScale = ecps_GetChunkComponent( chunk, gcScaleCompID, (void**)&scale, &scaleStride );
+	bool hasColor = ecps_GetChunkComponent( chunk, gcClrCompID, (void**)&color, &colorStride );
+
+	img_StartDrawRecording( chunk->sequence );
+	for( size_t i = 0; i < chunk->count; ++i ) {
+		GCPosData* pd = (GCPosData*)( pos + ( i * posStride ) );
+		const GCSpriteData* sd = (const GCSpriteData*)( sprite + ( i * spriteStride ) );
+
+		Vector2 currScale = VEC2_ONE;
+		Vector2 futureScale = VEC2_ONE;
+		if( hasScale ) {
+			GCScaleData* scd = (GCScaleData*)( scale + ( i * scaleStride ) );
+			currScale = scd->currScale;
+			futureScale = scd->futureScale;
+
+			scd->currScale = futureScale;
+		}
 
-	Vector2 currScale = VEC2_ONE;
-	Vector2 futureScale = VEC2_ONE;
-	if( ecps_GetComponentFromEntity( entity, gcScaleCompID, &scale ) ) {
-		currScale = scale->currScale;
-		futureScale = scale->futureScale;
+		Color currClr = CLR_WHITE;
+		Color futureClr = CLR_WHITE;
+		if( hasColor ) {
+			GCColorData* cd = (GCColorData*)( color + ( i * colorStride ) );
+			currClr = cd->currClr;
+			futureClr = cd->futureClr;
 
-		scale->currScale = futureScale;
-	}
+			cd->currClr = futureClr;
+		}
 
-	Color currClr = CLR_WHITE;
-	Color futureClr = CLR_WHITE;
-	if( ecps_GetComponentFromEntity( entity, gcClrCompID, &color ) ) {
-		currClr = color->currClr;
-		futureClr = color->futureClr;
+		img_Draw_sv_c( sd->img, sd->camFlags, pd->currPos, pd->futurePos, currScale, futureScale, currClr, futureClr, sd->depth );
 
-		color->currClr = futureClr;
+		pd->currPos = pd->futurePos;
 	}
+	img_FinishDrawRecording( );
+}
 
-	img_Draw_sv_c( sd->img, sd->camFlags, currPos, futurePos, currScale, futureScale, currClr, futureClr, sd->depth );
-
-	pos->currPos = pos->futurePos;
+static void renderFinish( ECPS* ecps )
+{
+	img_AddDrawRecordings( );
 }
 
 // ***** Clickable Objects
@@ -242,7 +264,8 @@ void gp_RegisterProcesses( ECPS* ecps )
 {
 	SDL_assert( gcPosCompID != INVALID_COMPONENT_ID );
 	SDL_assert( gcSpriteCompID != INVALID_COMPONENT_ID );
-	ecps_CreateProcess( ecps, "DRAW", NULL, render, NULL, &gpRenderProc, 2, gcPosCompID, gcSpriteCompID );
+	ecps_CreateChunkProcess( ecps, "DRAW", NULL, render, renderFinish, &gpRenderProc, 2, gcPosCompID, gcSpriteCompID );
+	ecps_SetProcessThreadSafe( &gpRenderProc, true );
 
 	SDL_assert( gcPosCompID != INVALID_COMPONENT_ID );
 	SDL_assert( gcPointerResponseCompID != INVALID_COMPONENT_ID );
@@ -50,6 +50,24 @@ bool ecps_cbf_CompareExact( const ComponentBitFlags* test, const ComponentBitFla
 	return true;
 }
 
+// FNV-1a over the flag words
+uint32_t ecps_cbf_Hash( const ComponentBitFlags* flags )
+{
+	assert( flags != NULL );
+
+	uint32_t hash = 2166136261u;
+	for( int i = 0; i < FLAGS_ARRAY_SIZE; ++i ) {
+		uint32_t bits = flags->bits[i];
+		for( int b = 0; b < 4; ++b ) {
+			hash ^= ( bits & 0xFF );
+			hash *= 16777619u;
+			bits >>= 8;
+		}
+	}
+
+	return hash;
+}
+
 bool ecps_cbf_CompareContains( const ComponentBitFlags* test, const ComponentBitFlags* against )
 {
 	assert( test != NULL );
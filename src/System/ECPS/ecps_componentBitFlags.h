@@ -13,5 +13,6 @@ void ecps_cbf_SetFlagOff( ComponentBitFlags* flags, uint32_t flagToUnset );
 bool ecps_cbf_IsFlagOn( const ComponentBitFlags* flags, uint32_t flagToTest );
 bool ecps_cbf_CompareExact( const ComponentBitFlags* test, const ComponentBitFlags* against );
 bool ecps_cbf_CompareContains( const ComponentBitFlags* test, const ComponentBitFlags* against );
+uint32_t ecps_cbf_Hash( const ComponentBitFlags* flags );
 
 #endif
\ No newline at end of file
@@ -32,7 +32,7 @@ void ecps_ct_Init( ComponentTypeCollection* ctc )
 {
 	ctc->sbTypes = NULL;
 
-	sharedComponent_ID = ecps_ct_AddType( ctc, "S_ID", sizeof( uint32_t ), NULL );
+	sharedComponent_ID = ecps_ct_AddType( ctc, "S_ID", sizeof( EntityID ), NULL );
 	sharedComponent_Enabled = ecps_ct_AddType( ctc, "S_ENABLED", 0, NULL );
 }
 
@@ -2,7 +2,9 @@
 #define ECPS_DATA_TYPES
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include <SDL_atomic.h>
 
 #include "../../Utils/idSet.h"
 #include "ecps_values.h"
@@ -25,66 +27,163 @@ typedef struct {
 	ComponentType* sbTypes;
 } ComponentTypeCollection;
 
+// the component for the entity at index i is at ( data + offset + ( i * stride ) )
 typedef struct {
-	int32_t offset;
+	ptrdiff_t offset;	// -1 if the array doesn't have the component, columns start at their size times the capacity
+	uint32_t stride;
 } PackageStructureEntry;
 
 typedef struct {
 	PackageStructureEntry entries[MAX_NUM_COMPONENT_TYPES];
 } PackageStructure;
 
+// entities are stored either interleaved, with all of an entity's components next to each other, or in columns,
+//  with each component type in it's own contiguous array
 typedef struct {
 	size_t entitySize;
 	PackageStructure structure;
-	uint8_t* sbData;
+	bool columnar;
+	size_t count;
+	size_t capacity;
+	uint8_t* sbData; // always has room for capacity entities, when columnar the columns are capacity entries long
+
+	// the ecps change version each component was last written at, tracked for every PROCESS_RANGE_SIZE entities
+	//  so there are MAX_NUM_COMPONENT_TYPES versions for each range, adding, removing, or moving an entity marks
+	//  all the components in it's range as changed
+	uint32_t* sbChangeVersions;
 } PackagedComponentArray;
 
 // used for accessing an entity directly
 typedef struct {
 	int32_t packedArrayIdx;		// either the array index, or -1 if the entity doesn't exist
-	size_t positionOffset;		// if the packedArrayIdx is >= 0 then this is the offset into the byte array where it starts
+	size_t index;				// if the packedArrayIdx is >= 0 then this is the index of the entity in the array
 } EntityDirectoryEntry;
 
 typedef struct {
 	uint32_t bits[FLAGS_ARRAY_SIZE];
 } ComponentBitFlags;
 
+// what packaged array an entity moves to when a component is added or removed, -1 if it hasn't been looked up yet
+typedef struct {
+	int32_t add[MAX_NUM_COMPONENT_TYPES];
+	int32_t remove[MAX_NUM_COMPONENT_TYPES];
+} PackagedArrayEdges;
+
 typedef struct {
 	EntityDirectoryEntry* sbEntityDirectory;	// holds the offset into the data where the entity starts
 
-	// the sizes of these two should be the same
+	// the sizes of these three should be the same
 	ComponentBitFlags* sbBitFlags;				// what components the array contains
 	PackagedComponentArray* sbComponentArrays;	// structure information and the entity data
+	PackagedArrayEdges* sbEdges;				// cached moves to other arrays
+
+	// open addressing hash table from bit flags to array index, -1 if the spot is empty, size is always a power of two
+	int32_t* sbArrayLookup;
 } ComponentData;
 
+// a piece of a packaged component array that a thread safe process is run on, each one gets it's own command
+//  buffer so they can be run on separate threads and then merged in the same order they would have been run in
+typedef struct {
+	uint32_t arrayIdx;
+	size_t start;
+	size_t end;
+	uint8_t* sbCommandBuffer;
+} ProcessRange;
+
+// a spot in a packaged component array
+typedef struct {
+	uint32_t arrayIdx;
+	size_t index;
+} PackagedArraySpot;
+
+struct Process;
+
 typedef struct {
 	ComponentData componentData;
 	ComponentTypeCollection componentTypes;
 	bool isRunning;
 	uint32_t id;
 	IDSet idSet;
+	bool columnarLayout; // whether new packaged arrays are stored in columns
+	// only has to last until the end of ecps_RunProcess( ), but it isn't in the frameArena since an ecps can be run
+	//  outside of the main loop where nothing resets it, it's cleared and reused so it stops allocating once it's grown
 	uint8_t* sbCommandBuffer;
 	bool isRunningProcess;
+	uint32_t changeVersion; // advanced whenever a process is run, so processes can tell what's changed since they last ran
+
+	ProcessRange* sbProcessRanges; // reused between runs of thread safe processes
+	struct Process** sbProcesses; // every process created with this, so their matching arrays can be kept up to date
+	SDL_SpinLock idLock; // entities can be created from multiple threads while running a thread safe process
+
+	// scratch space for running the command buffer in batches
+	uint32_t* sbBatchArrays; // packaged array each created entity goes into, also used when restoring snapshots
+	uint32_t* sbBatchCounts; // how many entities are being added to each packaged array
+	PackagedArraySpot* sbBatchSpots; // where each destroyed entity was
 } ECPS;
 
 typedef struct {
 	EntityID id;
-	void* data;
+	void* data; // the start of the data for the array the entity is in
+	size_t index; // where the entity is in the array
 	const PackageStructure* structure;
+	uint32_t* changeVersions; // for the array the entity is in, getting a component marks it as changed
+	uint32_t version; // what to mark changed components with
 } Entity;
 
+// a run of entities in a single packaged array, use ecps_GetChunkComponent( ) to get at the components
+typedef struct {
+	void* data;
+	size_t start;
+	size_t count;
+	const PackageStructure* structure;
+	uint32_t* changeVersions; // for the array the chunk is in, getting a component marks it as changed
+	uint32_t version; // what to mark changed components with
+	uint32_t sequence; // increases with each chunk in a run of a process, thread safe processes can use it to put
+	                   //  what they gather from each chunk back in the order it would have been on a single thread
+} EntityChunk;
+
 typedef void (*PreProcFunc)( ECPS* ecps );
 typedef void (*ProcFunc)( ECPS* ecps, const Entity* entity );
 typedef void (*PostProcFunc)( ECPS* ecps );
+typedef void (*ChunkFunc)( ECPS* ecps, const EntityChunk* chunk, void* context );
+typedef void (*ChunkProcFunc)( ECPS* ecps, const EntityChunk* chunk );
 
 typedef struct {
+	uint32_t lastArraysVisited;
+	uint32_t lastEntitiesVisited;
+	float lastMS;
+
+	uint32_t totalRuns;
+	uint64_t totalEntitiesVisited;
+	double totalMS;
+} ProcessStats;
+
+typedef struct Process {
 	uint32_t ecpsID;
 	PreProcFunc preProc;
 	ProcFunc proc;
+	ChunkProcFunc chunkProc; // used instead of proc if set, called once for each range of entities
 	PostProcFunc postProc;
 
 	ComponentBitFlags bitFlags;
 
+	// if this is set the entities will be split up and processed on the job queue, proc can be called on
+	//  different entities at the same time so it should only modify the entity it's passed in, structural
+	//  changes are fine since they go through the command buffer
+	bool isThreadSafe;
+
+	// if this is set the process is only run on ranges of entities where one of the components in changeFilter
+	//  has been changed since the last time it was run, changes the process makes itself aren't counted
+	bool filterChanges;
+	ComponentBitFlags changeFilter;
+	uint32_t lastRunVersion;
+
+	// indices of the packaged arrays that have all the components the process needs, added to as new
+	//  arrays are created
+	uint32_t* sbMatchingArrays;
+
+	ProcessStats stats;
+
 	char name[32];
 } Process;
 
@@ -4,6 +4,8 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
 
 #include "../../Utils/stretchyBuffer.h"
 
@@ -12,9 +14,22 @@
 #include "ecps_values.h"
 
 #include "../platformLog.h"
+#include "../jobQueue.h"
+#include "../random.h"
+#include "../testing.h"
 
 static const EntityDirectoryEntry EMPTY_EDE = { -1, 0 };
-static const size_t ID_SET_SIZE = UINT16_MAX;
+static const size_t ID_SET_START_SIZE = 1024; // doubled whenever we run out, up to ID_SET_MAX_SIZE
+
+// how many entities each job gets when running a thread safe process, changes are also tracked in ranges this size
+#define PROCESS_RANGE_SIZE 1024
+
+// while a thread is processing a range commands go into the range's buffer instead of the shared one
+typedef struct {
+	ECPS* ecps;
+	uint8_t** sbCommandBuffer;
+} CommandBufferOverride;
+static SDL_TLSID commandBufferOverrideID = 0;
 
 typedef enum {
 	CMD_INVALID,
@@ -25,10 +40,14 @@ typedef enum {
 } CommandType;
 
 // the data after this command will define the components added and the initial data for them
+//  the flags and total size are figured out when the command is added so running a batch of them can find where
+//  each entity goes without having to read through the component data
 typedef struct {
 	CommandType cmd;
 	EntityID id;
 	uint32_t numComps;
+	uint32_t size;
+	ComponentBitFlags flags;
 	//uint8_t* data;
 } CreateEntityCommand;
 
@@ -59,10 +78,19 @@ typedef union {
 	RemoveComponentCommand remove;
 } Command;
 
-static uint8_t* runCreateCommand( ECPS* ecps, uint8_t* commandData );
+static uint8_t* runCreateCommands( ECPS* ecps, uint8_t* commandData, uint8_t* bufferEnd );
 static uint8_t* runAddComponentCommand( ECPS* ecps, uint8_t* commandData );
 static uint8_t* runRemoveComponentCommand( ECPS* ecps, uint8_t* commandData );
-static uint8_t* runDestroyEntityCommand( ECPS* ecps, uint8_t* commandData );
+static uint8_t* runDestroyEntityCommands( ECPS* ecps, uint8_t* commandData, uint8_t* bufferEnd );
+
+static uint8_t** getCommandBuffer( ECPS* ecps )
+{
+	CommandBufferOverride* override = (CommandBufferOverride*)SDL_TLSGet( commandBufferOverrideID );
+	if( ( override != NULL ) && ( override->ecps == ecps ) ) {
+		return override->sbCommandBuffer;
+	}
+	return &( ecps->sbCommandBuffer );
+}
 
 //EntityIDSet idSet;
 
@@ -77,7 +105,13 @@ static bool createProcessVA( ECPS* ecps,
 {
 	outProcess->preProc = preProc;
 	outProcess->proc = proc;
+	outProcess->chunkProc = NULL;
 	outProcess->postProc = postProc;
+	outProcess->isThreadSafe = false;
+	outProcess->filterChanges = false;
+	memset( &( outProcess->changeFilter ), 0, sizeof( ComponentBitFlags ) );
+	outProcess->lastRunVersion = 0;
+	memset( &( outProcess->stats ), 0, sizeof( outProcess->stats ) );
 
 	if( name != NULL ) {
 		strncpy( outProcess->name, name, sizeof( outProcess->name ) );
@@ -97,75 +131,344 @@ static bool createProcessVA( ECPS* ecps,
 
 	outProcess->ecpsID = ecps->id;
 
+	// if the process is being recreated then it's already being tracked and has a list we can reuse
+	bool tracked = false;
+	for( size_t i = 0; ( i < sb_Count( ecps->sbProcesses ) ) && !tracked; ++i ) {
+		tracked = ( ecps->sbProcesses[i] == outProcess );
+	}
+
+	if( tracked ) {
+		sb_Clear( outProcess->sbMatchingArrays );
+	} else {
+		outProcess->sbMatchingArrays = NULL;
+		sb_Push( ecps->sbProcesses, outProcess );
+	}
+
+	// find any arrays that already exist, any created after this are added as they're created
+	for( size_t i = 0; i < sb_Count( ecps->componentData.sbBitFlags ); ++i ) {
+		if( ecps_cbf_CompareContains( &( outProcess->bitFlags ), &( ecps->componentData.sbBitFlags[i] ) ) ) {
+			sb_Push( outProcess->sbMatchingArrays, (uint32_t)i );
+		}
+	}
+
 	return true;
 }
 
-static void modifyEntityDirectoryEntry( ECPS* ecps, EntityID entityID, int32_t packedArrayIdx, size_t offset )
+// makes sure there's an entry for every entity index below count
+static void growEntityDirectory( ECPS* ecps, size_t count )
+{
+	size_t currCount = sb_Count( ecps->componentData.sbEntityDirectory );
+	if( count <= currCount ) {
+		return;
+	}
+
+	EntityDirectoryEntry* newEntries = sb_Add( ecps->componentData.sbEntityDirectory, count - currCount );
+	for( size_t i = 0; i < ( count - currCount ); ++i ) {
+		newEntries[i] = EMPTY_EDE;
+	}
+}
+
+static void modifyEntityDirectoryEntry( ECPS* ecps, EntityID entityID, int32_t packedArrayIdx, size_t index )
 {
 	size_t idx = (size_t)idSet_GetIndex( entityID );
-	int cnt = sb_Count( ecps->componentData.sbEntityDirectory );
 
 	// grow if necessary
-	while( idx >= sb_Count( ecps->componentData.sbEntityDirectory ) ) {
-		sb_Push( ecps->componentData.sbEntityDirectory, EMPTY_EDE );
-	}
+	growEntityDirectory( ecps, idx + 1 );
 
 	ecps->componentData.sbEntityDirectory[idx].packedArrayIdx = packedArrayIdx;
-	ecps->componentData.sbEntityDirectory[idx].positionOffset = offset;
+	ecps->componentData.sbEntityDirectory[idx].index = index;
+}
+
+static uint8_t* getComponentInArray( PackagedComponentArray* pca, size_t index, ComponentID componentID )
+{
+	const PackageStructureEntry* entry = &( pca->structure.entries[componentID] );
+	assert( entry->offset >= 0 );
+	return ( pca->sbData + entry->offset + ( index * entry->stride ) );
+}
+
+static EntityID getEntityIDInArray( PackagedComponentArray* pca, size_t index )
+{
+	return *( (EntityID*)getComponentInArray( pca, index, sharedComponent_ID ) );
+}
+
+// versions wrap around, so compare the difference instead of the values
+static bool isVersionNewer( uint32_t version, uint32_t than )
+{
+	return ( (int32_t)( version - than ) ) > 0;
+}
+
+// marks all the components for the entities in [start, end) as changed
+static void markRangeChanged( ECPS* ecps, PackagedComponentArray* pca, size_t start, size_t end )
+{
+	if( start >= end ) {
+		return;
+	}
+
+	uint32_t* versions = pca->sbChangeVersions + ( ( start / PROCESS_RANGE_SIZE ) * MAX_NUM_COMPONENT_TYPES );
+	uint32_t* last = pca->sbChangeVersions + ( ( ( ( end - 1 ) / PROCESS_RANGE_SIZE ) + 1 ) * MAX_NUM_COMPONENT_TYPES );
+	for( ; versions < last; ++versions ) {
+		(*versions) = ecps->changeVersion;
+	}
+}
+
+static void markEntityChanged( ECPS* ecps, PackagedComponentArray* pca, size_t index )
+{
+	markRangeChanged( ecps, pca, index, index + 1 );
+}
+
+static void markComponentChanged( uint32_t* changeVersions, uint32_t version, size_t index, ComponentID componentID )
+{
+	changeVersions[( ( index / PROCESS_RANGE_SIZE ) * MAX_NUM_COMPONENT_TYPES ) + componentID] = version;
+}
+
+// whether any of the components the process is filtering on have changed for the range that contains start
+static bool hasRangeChanged( const Process* process, PackagedComponentArray* pca, size_t start )
+{
+	const uint32_t* versions = pca->sbChangeVersions + ( ( start / PROCESS_RANGE_SIZE ) * MAX_NUM_COMPONENT_TYPES );
+	for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+		if( ecps_cbf_IsFlagOn( &( process->changeFilter ), i ) && isVersionNewer( versions[i], process->lastRunVersion ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void setupEntity( ECPS* ecps, PackagedComponentArray* pca, EntityID entityID, size_t index, Entity* outEntity )
+{
+	outEntity->id = entityID;
+	outEntity->data = pca->sbData;
+	outEntity->index = index;
+	outEntity->structure = &( pca->structure );
+	outEntity->changeVersions = pca->sbChangeVersions;
+	outEntity->version = ecps->changeVersion;
+}
+
+// sets up the offsets and strides for the components, for columnar arrays these depend on the capacity
+static void setupArrayStructure( ECPS* ecps, PackagedComponentArray* pca, const ComponentBitFlags* flags )
+{
+	size_t currentOffset = 0;
+	size_t cnt = ecps_ct_ComponentTypeCount( &( ecps->componentTypes ) );
+	for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+		// all packaged arrays need the component id
+		if( ( i < cnt ) && ( ( i == sharedComponent_ID ) || ecps_cbf_IsFlagOn( flags, i ) ) ) {
+			size_t size = ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i );
+			if( pca->columnar ) {
+				pca->structure.entries[i].offset = (ptrdiff_t)( currentOffset * pca->capacity );
+				pca->structure.entries[i].stride = (uint32_t)size;
+			} else {
+				pca->structure.entries[i].offset = (ptrdiff_t)currentOffset;
+			}
+			currentOffset += size;
+		} else {
+			pca->structure.entries[i].offset = -1;
+			pca->structure.entries[i].stride = 0;
+		}
+	}
+
+	pca->entitySize = currentOffset;
+
+	if( !pca->columnar ) {
+		for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+			if( pca->structure.entries[i].offset >= 0 ) {
+				pca->structure.entries[i].stride = (uint32_t)pca->entitySize;
+			}
+		}
+	}
 }
 
-static void entityCopy( ECPS* ecps,
-	uint8_t* fromData, const PackageStructure* fromStructure, uint8_t* toData, const PackageStructure* toStructure )
+// copies the components the two entities share and zeros the ones the to entity has that the from entity doesn't
+static void entityCopy( ECPS* ecps, PackagedComponentArray* fromPCA, size_t fromIdx, PackagedComponentArray* toPCA, size_t toIdx )
 {
 	size_t componentCount = ecps_ct_ComponentTypeCount( &( ecps->componentTypes ) );
 	for( size_t i = 0; i < componentCount; ++i ) {
 		size_t size = ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i );
-		int32_t fromOffset = fromStructure->entries[i].offset;
-		int32_t toOffset = toStructure->entries[i].offset;
+		if( ( size == 0 ) || ( toPCA->structure.entries[i].offset < 0 ) ) {
+			continue;
+		}
 
-		if( ( fromOffset >= 0 ) && ( toOffset >= 0 ) ) {
+		if( fromPCA->structure.entries[i].offset >= 0 ) {
 			// both the structures contain this component, copy over
-			memcpy( &( toData[toOffset] ), &( fromData[fromOffset] ), size );
-		} else if( toOffset >= 0 ) {
+			memcpy( getComponentInArray( toPCA, toIdx, i ), getComponentInArray( fromPCA, fromIdx, i ), size );
+		} else {
 			// the from structure doesn't contain this component, set to zero
-			memset( &( toData[toOffset] ), 0, size );
+			memset( getComponentInArray( toPCA, toIdx, i ), 0, size );
+		}
+	}
+}
+
+// makes sure the array has room for at least minCapacity entities
+static void growPackagedArray( ECPS* ecps, int32_t packedArrayIndex, size_t minCapacity )
+{
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIndex] );
+	if( minCapacity <= pca->capacity ) {
+		return;
+	}
+
+	// keep the capacity a multiple of 16 so the columns stay aligned
+	size_t newCapacity = ( pca->capacity == 0 ) ? 16 : ( pca->capacity * 2 );
+	while( newCapacity < minCapacity ) {
+		newCapacity *= 2;
+	}
+
+	// new ranges are marked when entities are added to them
+	size_t numVersions = ( ( newCapacity + PROCESS_RANGE_SIZE - 1 ) / PROCESS_RANGE_SIZE ) * MAX_NUM_COMPONENT_TYPES;
+	if( numVersions > sb_Count( pca->sbChangeVersions ) ) {
+		size_t currVersions = sb_Count( pca->sbChangeVersions );
+		uint32_t* newVersions = sb_Add( pca->sbChangeVersions, numVersions - currVersions );
+		memset( newVersions, 0, sizeof( newVersions[0] ) * ( numVersions - currVersions ) );
+	}
+
+	if( !pca->columnar ) {
+		sb_Add( pca->sbData, ( newCapacity - pca->capacity ) * pca->entitySize );
+		pca->capacity = newCapacity;
+		return;
+	}
+
+	// every column moves, so copy them over to a new block
+	PackagedComponentArray old = (*pca);
+	pca->sbData = NULL;
+	sb_Add( pca->sbData, newCapacity * pca->entitySize );
+	pca->capacity = newCapacity;
+	setupArrayStructure( ecps, pca, &( ecps->componentData.sbBitFlags[packedArrayIndex] ) );
+
+	for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+		if( ( pca->structure.entries[i].offset >= 0 ) && ( pca->structure.entries[i].stride > 0 ) && ( old.count > 0 ) ) {
+			memcpy( getComponentInArray( pca, 0, i ), getComponentInArray( &old, 0, i ), old.count * pca->structure.entries[i].stride );
 		}
 	}
+
+	sb_Release( old.sbData );
 }
 
+// the arrays are always kept packed, so new entities always go on the end
 static size_t allocateDataForEntity( ECPS* ecps, int32_t packedArrayIndex )
 {
 	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIndex] );
 
-	// find the first empty space
-	//  scan for an entity with a 0 as the entityID (should always be the first component
-	//  in every entity).
-	size_t currOffset = 0;
-	uint8_t* entityData = NULL;
-	size_t dataSize = sb_Count( pca->sbData );
-	while( ( entityData == NULL ) && ( currOffset < dataSize ) ) {
-		if( ( *( (EntityID*)( &( pca->sbData[currOffset] ) ) ) ) == 0 ) {
-			entityData = &( pca->sbData[currOffset] );
-		} else {
-			currOffset += pca->entitySize;
+	growPackagedArray( ecps, packedArrayIndex, pca->count + 1 );
+
+	size_t index = pca->count;
+	++( pca->count );
+	markEntityChanged( ecps, pca, index );
+
+	if( pca->columnar ) {
+		for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+			if( pca->structure.entries[i].offset >= 0 ) {
+				memset( getComponentInArray( pca, index, i ), 0, pca->structure.entries[i].stride );
+			}
+		}
+	} else {
+		memset( pca->sbData + ( index * pca->entitySize ), 0, pca->entitySize );
+	}
+
+	return index;
+}
+
+// moves the entity at fromIndex over whatever is at toIndex and updates where the directory says it is
+static void moveEntityInArray( ECPS* ecps, int32_t packedArrayIndex, size_t fromIndex, size_t toIndex )
+{
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIndex] );
+
+	if( pca->columnar ) {
+		for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+			if( ( pca->structure.entries[i].offset >= 0 ) && ( pca->structure.entries[i].stride > 0 ) ) {
+				memcpy( getComponentInArray( pca, toIndex, i ), getComponentInArray( pca, fromIndex, i ), pca->structure.entries[i].stride );
+			}
 		}
+	} else {
+		memcpy( pca->sbData + ( toIndex * pca->entitySize ), pca->sbData + ( fromIndex * pca->entitySize ), pca->entitySize );
 	}
+	markEntityChanged( ecps, pca, toIndex );
+
+	modifyEntityDirectoryEntry( ecps, getEntityIDInArray( pca, toIndex ), packedArrayIndex, toIndex );
+}
+
+// moves the last entity in the array into the freed up spot so the array doesn't end up with holes in it
+//  this will invalidate any pointers to the moved entity
+static void freeUpDataFromEntity( ECPS* ecps, int32_t packedArrayIndex, size_t index )
+{
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIndex] );
+	assert( index < pca->count );
+	size_t lastIndex = pca->count - 1;
 
-	if( entityData == NULL ) {
-		currOffset = sb_Count( pca->sbData );
-		sb_Add( pca->sbData, pca->entitySize );
-		entityData = &( pca->sbData[currOffset] );
-		memset( entityData, 0, pca->entitySize );
+	if( index != lastIndex ) {
+		moveEntityInArray( ecps, packedArrayIndex, lastIndex, index );
 	}
 
-	return currOffset;
+	markEntityChanged( ecps, pca, lastIndex );
+	--( pca->count );
 }
 
-static void freeUpDataFromEntity( ECPS* ecps, int32_t packedArrayIndex, size_t offset )
+// fills in the hole left by an entity that had it's id cleared, holes at the end of the array are dropped first so
+//  only entities that are still around are moved, holes can be filled in any order
+static void fillArrayHole( ECPS* ecps, int32_t packedArrayIndex, size_t index )
 {
 	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIndex] );
-	uint8_t* entityData = &( pca->sbData[offset] );
-	memset( entityData, 0, pca->entitySize );
+
+	// already dropped off the end or filled in
+	if( ( index >= pca->count ) || ( getEntityIDInArray( pca, index ) != INVALID_ENTITY_ID ) ) {
+		return;
+	}
+
+	size_t oldCount = pca->count;
+	while( ( pca->count > 0 ) && ( getEntityIDInArray( pca, pca->count - 1 ) == INVALID_ENTITY_ID ) ) {
+		--( pca->count );
+	}
+
+	if( index < pca->count ) {
+		moveEntityInArray( ecps, packedArrayIndex, pca->count - 1, index );
+		--( pca->count );
+	}
+	markRangeChanged( ecps, pca, pca->count, oldCount );
+}
+
+// makes sure there's a batch count for every packaged array, new ones start at zero
+static void growBatchCounts( ECPS* ecps )
+{
+	size_t numArrays = sb_Count( ecps->componentData.sbComponentArrays );
+	size_t currCount = sb_Count( ecps->sbBatchCounts );
+	if( numArrays > currCount ) {
+		uint32_t* newCounts = sb_Add( ecps->sbBatchCounts, numArrays - currCount );
+		memset( newCounts, 0, sizeof( newCounts[0] ) * ( numArrays - currCount ) );
+	}
+}
+
+// returns the spot in the lookup table where the array with the flags is, or the empty spot where it should go
+static size_t findArrayLookupSpot( ECPS* ecps, const ComponentBitFlags* flags )
+{
+	size_t mask = sb_Count( ecps->componentData.sbArrayLookup ) - 1;
+	size_t spot = ecps_cbf_Hash( flags ) & mask;
+	while( ( ecps->componentData.sbArrayLookup[spot] >= 0 ) &&
+		!ecps_cbf_CompareExact( flags, &( ecps->componentData.sbBitFlags[ecps->componentData.sbArrayLookup[spot]] ) ) ) {
+		spot = ( spot + 1 ) & mask;
+	}
+	return spot;
+}
+
+// makes sure there's room for another array while keeping the lookup table at most half full
+static void growArrayLookup( ECPS* ecps )
+{
+	size_t numArrays = sb_Count( ecps->componentData.sbBitFlags );
+	size_t size = sb_Count( ecps->componentData.sbArrayLookup );
+	if( ( ( numArrays + 1 ) * 2 ) <= size ) {
+		return;
+	}
+
+	size_t newSize = ( size == 0 ) ? 16 : ( size * 2 );
+	while( ( ( numArrays + 1 ) * 2 ) > newSize ) {
+		newSize *= 2;
+	}
+
+	sb_Release( ecps->componentData.sbArrayLookup );
+	sb_Add( ecps->componentData.sbArrayLookup, newSize );
+	for( size_t i = 0; i < newSize; ++i ) {
+		ecps->componentData.sbArrayLookup[i] = -1;
+	}
+
+	for( size_t i = 0; i < numArrays; ++i ) {
+		size_t spot = findArrayLookupSpot( ecps, &( ecps->componentData.sbBitFlags[i] ) );
+		ecps->componentData.sbArrayLookup[spot] = (int32_t)i;
+	}
 }
 
 static uint32_t createNewPackagedArray( ECPS* ecps,  const ComponentBitFlags* flags )
@@ -173,22 +476,15 @@ static uint32_t createNewPackagedArray( ECPS* ecps,  const ComponentBitFlags* fl
 	PackagedComponentArray newArray;
 	ComponentBitFlags newBitFlags;
 
-	// set up the structure
-	size_t currentOffset = 0;
-	size_t cnt = ecps_ct_ComponentTypeCount( &( ecps->componentTypes ) );
-	for( size_t i = 0; i < cnt; ++i ) {
-		// all packaged arrays need the component id
-		if( ( i == sharedComponent_ID ) || ecps_cbf_IsFlagOn( flags, i ) ) {
-			newArray.structure.entries[i].offset = currentOffset;
-			currentOffset += ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i );
-		} else {
-			newArray.structure.entries[i].offset = -1;
-		}
-	}
-
-	newArray.entitySize = currentOffset;
+	growArrayLookup( ecps );
 
+	// set up the structure, no space is allocated until the first entity is added
+	newArray.columnar = ecps->columnarLayout;
+	newArray.count = 0;
+	newArray.capacity = 0;
 	newArray.sbData = NULL;
+	newArray.sbChangeVersions = NULL;
+	setupArrayStructure( ecps, &newArray, flags );
 
 	// add the bit flags to the bit flags array
 	memcpy( &newBitFlags, flags, sizeof( ComponentBitFlags ) );
@@ -196,30 +492,73 @@ static uint32_t createNewPackagedArray( ECPS* ecps,  const ComponentBitFlags* fl
 	// add the matching packaged component array
 	sb_Push( ecps->componentData.sbComponentArrays, newArray );
 
-	return sb_Count( ecps->componentData.sbComponentArrays ) - 1;
+	// and the edges, which are filled in as they're used
+	PackagedArrayEdges* edges = sb_Add( ecps->componentData.sbEdges, 1 );
+	for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+		edges->add[i] = -1;
+		edges->remove[i] = -1;
+	}
+
+	uint32_t newIdx = sb_Count( ecps->componentData.sbComponentArrays ) - 1;
+
+	// let any process that wants this array know about it
+	for( size_t i = 0; i < sb_Count( ecps->sbProcesses ); ++i ) {
+		Process* process = ecps->sbProcesses[i];
+		if( ecps_cbf_CompareContains( &( process->bitFlags ), flags ) ) {
+			sb_Push( process->sbMatchingArrays, newIdx );
+		}
+	}
+
+	size_t spot = findArrayLookupSpot( ecps, flags );
+	assert( ecps->componentData.sbArrayLookup[spot] < 0 );
+	ecps->componentData.sbArrayLookup[spot] = (int32_t)newIdx;
+
+	return newIdx;
 }
 
 // finds the index for the packaged array that contains the set component bits
-//  if we find the array 
+//  if we don't find the array then a new one is created
 static uint32_t createOrFindPackagedArray( ECPS* ecps, const ComponentBitFlags* flags )
 {
-	PackagedComponentArray* componentArray = NULL;
-	uint32_t dataArrayIdx = 0;
-	uint32_t cnt = (uint32_t)sb_Count( ecps->componentData.sbBitFlags );
-	for( uint32_t i = 0; i < cnt; ++i ) {
-		if( ecps_cbf_CompareExact( flags, &( ecps->componentData.sbBitFlags[i] ) ) ) {
-			dataArrayIdx = i;
-			componentArray = &( ecps->componentData.sbComponentArrays[i] );
-			break;
+	if( sb_Count( ecps->componentData.sbArrayLookup ) > 0 ) {
+		size_t spot = findArrayLookupSpot( ecps, flags );
+		if( ecps->componentData.sbArrayLookup[spot] >= 0 ) {
+			return (uint32_t)ecps->componentData.sbArrayLookup[spot];
 		}
 	}
 
-	if( componentArray == NULL ) {
-		// didn't find a matching array, attempt to create a new one that matches
-		dataArrayIdx = createNewPackagedArray( ecps, flags );
+	// didn't find a matching array, attempt to create a new one that matches
+	return createNewPackagedArray( ecps, flags );
+}
+
+// finds the packaged array an entity in fromIdx goes to when the component is added or removed, the result is
+//  cached in both directions so toggling a component doesn't need to look anything up after the first time
+static uint32_t findPackagedArrayEdge( ECPS* ecps, uint32_t fromIdx, ComponentID componentID, bool add )
+{
+	PackagedArrayEdges* edges = &( ecps->componentData.sbEdges[fromIdx] );
+	int32_t cached = add ? edges->add[componentID] : edges->remove[componentID];
+	if( cached >= 0 ) {
+		return (uint32_t)cached;
+	}
+
+	ComponentBitFlags newBitFlags = ecps->componentData.sbBitFlags[fromIdx];
+	if( add ) {
+		ecps_cbf_SetFlagOn( &newBitFlags, componentID );
+	} else {
+		ecps_cbf_SetFlagOff( &newBitFlags, componentID );
+	}
+
+	// this can add to the edges, so we can't use the pointer we already have
+	uint32_t toIdx = createOrFindPackagedArray( ecps, &newBitFlags );
+	if( add ) {
+		ecps->componentData.sbEdges[fromIdx].add[componentID] = (int32_t)toIdx;
+		ecps->componentData.sbEdges[toIdx].remove[componentID] = (int32_t)fromIdx;
+	} else {
+		ecps->componentData.sbEdges[fromIdx].remove[componentID] = (int32_t)toIdx;
+		ecps->componentData.sbEdges[toIdx].add[componentID] = (int32_t)fromIdx;
 	}
 
-	return dataArrayIdx;
+	return toIdx;
 }
 
 static void removeEntityFromArray( ECPS* ecps, EntityID entityID )
@@ -228,10 +567,11 @@ static void removeEntityFromArray( ECPS* ecps, EntityID entityID )
 	uint32_t idx = idSet_GetIndex( entityID );
 	assert( idx < sb_Count( ecps->componentData.sbEntityDirectory ) );
 	int32_t packedArrayIdx = ecps->componentData.sbEntityDirectory[idx].packedArrayIdx;
-	EntityDirectoryEntry* removedEDE = &( ecps->componentData.sbEntityDirectory[idx] );
-	uint8_t* entityToRemoveData = &( ecps->componentData.sbComponentArrays[packedArrayIdx].sbData[removedEDE->positionOffset] );
+	if( packedArrayIdx < 0 ) {
+		return;
+	}
 
-	memset( entityToRemoveData, 0, ecps->componentData.sbComponentArrays[packedArrayIdx].entitySize );
+	freeUpDataFromEntity( ecps, packedArrayIdx, ecps->componentData.sbEntityDirectory[idx].index );
 
 	modifyEntityDirectoryEntry( ecps, entityID, -1, 0 );
 }
@@ -248,16 +588,32 @@ void ecps_StartInitialization( ECPS* ecps )
 
 	ecps->sbCommandBuffer = NULL;
 	ecps->isRunningProcess = true;
+	ecps->changeVersion = 1;
+
+	ecps->sbProcessRanges = NULL;
+	ecps->sbProcesses = NULL;
+	ecps->columnarLayout = false;
+	ecps->idLock = 0;
+	ecps->sbBatchArrays = NULL;
+	ecps->sbBatchCounts = NULL;
+	ecps->sbBatchSpots = NULL;
+	// the slot is shared by every ecps and SDL has no way to release one, so it's created once and kept until the
+	//  program exits, only the value set while running a range is cleared
+	if( commandBufferOverrideID == 0 ) {
+		commandBufferOverrideID = SDL_TLSCreate( );
+	}
 
 	ecps_ct_Init( &( ecps->componentTypes ) );
 	ecps->id = ecpsCurrID;
 	++ecpsCurrID;
 
-	idSet_Init( &( ecps->idSet ), ID_SET_SIZE );
+	idSet_Init( &( ecps->idSet ), ID_SET_START_SIZE );
 
 	ecps->componentData.sbBitFlags = NULL;
 	ecps->componentData.sbComponentArrays = NULL;
 	ecps->componentData.sbEntityDirectory = NULL;
+	ecps->componentData.sbEdges = NULL;
+	ecps->componentData.sbArrayLookup = NULL;
 }
 
 // Switches states, no way to change back to the initialization state
@@ -272,6 +628,17 @@ void ecps_CleanUp( ECPS* ecps )
 	assert( ecps != NULL );
 
 	sb_Release( ecps->sbCommandBuffer );
+	for( size_t i = 0; i < sb_Count( ecps->sbProcessRanges ); ++i ) {
+		sb_Release( ecps->sbProcessRanges[i].sbCommandBuffer );
+	}
+	sb_Release( ecps->sbProcessRanges );
+	for( size_t i = 0; i < sb_Count( ecps->sbProcesses ); ++i ) {
+		sb_Release( ecps->sbProcesses[i]->sbMatchingArrays );
+	}
+	sb_Release( ecps->sbProcesses );
+	sb_Release( ecps->sbBatchArrays );
+	sb_Release( ecps->sbBatchCounts );
+	sb_Release( ecps->sbBatchSpots );
 	ecps_ct_CleanUp( &( ecps->componentTypes ) );
 	idSet_Destroy( &( ecps->idSet ) );
 }
@@ -321,75 +688,209 @@ bool ecps_CreateProcess( ECPS* ecps,
 	return success;
 }
 
-// run a process, must have been created with the associated entity-component-process system
-void ecps_RunProcess( ECPS* ecps, Process* process )
+// same as ecps_CreateProcess( ), but chunkProc is called with all the entities in a range at once
+bool ecps_CreateChunkProcess( ECPS* ecps,
+	const char* name, PreProcFunc preProc, ChunkProcFunc chunkProc, PostProcFunc postProc,
+	Process* outProcess, size_t numComponents, ... )
 {
 	assert( ecps != NULL );
-	assert( ecps->isRunning );
+	assert( outProcess != NULL );
+	assert( chunkProc != NULL );
 
-	size_t presize = sb_Count( ecps->sbCommandBuffer );
+	bool success = false;
 
-	// verify the process is part of the entity-component-process system
-	assert( ( ecps->id ) == ( process->ecpsID ) );
+	va_list list;
+	va_start( list, numComponents );
+	success = createProcessVA( ecps, name, preProc, NULL, postProc, outProcess, numComponents, list );
+	va_end( list );
 
-	// then run the process, looping through all the entities
-	if( process->preProc != NULL ) {
-		process->preProc( ecps );
+	outProcess->chunkProc = chunkProc;
+
+	return success;
+}
+
+void ecps_SetProcessThreadSafe( Process* process, bool threadSafe )
+{
+	assert( process != NULL );
+	process->isThreadSafe = threadSafe;
+}
+
+void ecps_SetProcessChangeFilter( Process* process, size_t numComponents, ... )
+{
+	assert( process != NULL );
+
+	process->filterChanges = ( numComponents > 0 );
+	memset( &( process->changeFilter ), 0, sizeof( ComponentBitFlags ) );
+
+	va_list list;
+	va_start( list, numComponents ); {
+		for( size_t i = 0; i < numComponents; ++i ) {
+			ComponentID compID = va_arg( list, ComponentID );
+			assert( compID < MAX_NUM_COMPONENT_TYPES );
+			ecps_cbf_SetFlagOn( &( process->changeFilter ), compID );
+		}
+	} va_end( list );
+
+	// the first run after setting the filter sees everything
+	process->lastRunVersion = 0;
+}
+
+static void setupChunk( ECPS* ecps, PackagedComponentArray* pca, size_t start, size_t end, uint32_t sequence, EntityChunk* outChunk )
+{
+	outChunk->data = pca->sbData;
+	outChunk->start = start;
+	outChunk->count = end - start;
+	outChunk->structure = &( pca->structure );
+	outChunk->changeVersions = pca->sbChangeVersions;
+	outChunk->version = ecps->changeVersion;
+	outChunk->sequence = sequence;
+}
+
+// runs the process on the entities in the array in [start, end), sequence is only used for chunk processes
+static void runProcessOnArray( ECPS* ecps, Process* process, PackagedComponentArray* pca, size_t start, size_t end, uint32_t sequence )
+{
+	if( process->chunkProc != NULL ) {
+		EntityChunk chunk;
+		setupChunk( ecps, pca, start, end, sequence, &chunk );
+		process->chunkProc( ecps, &chunk );
+		return;
 	}
 
-	ecps->isRunningProcess = true;
-	if( process->proc != NULL ) {
-		// will need to iterate through all entities that have the components the process is looking for
-		size_t numCompArrays = sb_Count( ecps->componentData.sbComponentArrays );
-		for( size_t cai = 0; cai < numCompArrays; ++cai ) {
-			PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[cai] );
-			ComponentBitFlags* cbf = &( ecps->componentData.sbBitFlags[cai] );
-			if( ecps_cbf_CompareContains( &( process->bitFlags ), cbf ) ) {
-				// component data array matches, iterate through entities
-				size_t dataIdx = 0;
-				size_t dataArraySize = sb_Count( pca->sbData );
-				while( dataIdx < dataArraySize ) {
-					// first should always be the entity id
-					void* data = (void*)( &( pca->sbData[dataIdx] ) );
-					EntityID entityID = *( (EntityID*)data );
-					if( entityID != INVALID_ENTITY_ID ) {
-						Entity entity;
-						entity.id = entityID;
-						entity.data = data;
-						entity.structure = &( pca->structure );
-						process->proc( ecps, &entity );
-					}
-					dataIdx += pca->entitySize;
-				}
+	for( size_t i = start; i < end; ++i ) {
+		// the arrays are kept packed so every spot should have a valid entity in it
+		EntityID entityID = getEntityIDInArray( pca, i );
+		assert( entityID != INVALID_ENTITY_ID );
+
+		Entity entity;
+		setupEntity( ecps, pca, entityID, i, &entity );
+		process->proc( ecps, &entity );
+	}
+}
+
+// runs the process on the ranges in the array that have changed since it was last run, ranges next to each other
+//  are run together, sequence is advanced for each run
+static void runProcessOnChangedRanges( ECPS* ecps, Process* process, PackagedComponentArray* pca, uint32_t* sequence )
+{
+	size_t runStart = 0;
+	bool inRun = false;
+	for( size_t start = 0; start < pca->count; start += PROCESS_RANGE_SIZE ) {
+		bool changed = hasRangeChanged( process, pca, start );
+		if( changed && !inRun ) {
+			runStart = start;
+			inRun = true;
+		} else if( !changed && inRun ) {
+			process->stats.lastEntitiesVisited += (uint32_t)( start - runStart );
+			runProcessOnArray( ecps, process, pca, runStart, start, ( *sequence )++ );
+			inRun = false;
+		}
+	}
+
+	if( inRun ) {
+		process->stats.lastEntitiesVisited += (uint32_t)( pca->count - runStart );
+		runProcessOnArray( ecps, process, pca, runStart, pca->count, ( *sequence )++ );
+	}
+}
+
+typedef struct {
+	ECPS* ecps;
+	Process* process;
+} ProcessRangeContext;
+
+static void runProcessRanges( void* context, size_t start, size_t end )
+{
+	ProcessRangeContext* ctx = (ProcessRangeContext*)context;
+	ECPS* ecps = ctx->ecps;
+
+	for( size_t i = start; i < end; ++i ) {
+		ProcessRange* range = &( ecps->sbProcessRanges[i] );
+
+		CommandBufferOverride override;
+		override.ecps = ecps;
+		override.sbCommandBuffer = &( range->sbCommandBuffer );
+		SDL_TLSSet( commandBufferOverrideID, &override, NULL );
+
+		// the ranges are in the order they would be visited on a single thread, so the index works as the sequence
+		runProcessOnArray( ecps, ctx->process, &( ecps->componentData.sbComponentArrays[range->arrayIdx] ), range->start, range->end, (uint32_t)i );
+
+		SDL_TLSSet( commandBufferOverrideID, NULL, NULL );
+	}
+}
+
+// splits the matching arrays into ranges and runs them on the job queue, the command buffers for each range are
+//  added to the main one in order, so it ends up the same as if it was run on a single thread
+static void runProcessParallel( ECPS* ecps, Process* process )
+{
+	size_t numRanges = 0;
+	size_t numMatching = sb_Count( process->sbMatchingArrays );
+	for( size_t i = 0; i < numMatching; ++i ) {
+		uint32_t cai = process->sbMatchingArrays[i];
+		PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[cai] );
+		if( pca->count == 0 ) {
+			continue;
+		}
+
+		++( process->stats.lastArraysVisited );
+
+		for( size_t start = 0; start < pca->count; start += PROCESS_RANGE_SIZE ) {
+			if( process->filterChanges && !hasRangeChanged( process, pca, start ) ) {
+				continue;
+			}
+
+			if( numRanges >= sb_Count( ecps->sbProcessRanges ) ) {
+				ProcessRange newRange;
+				newRange.sbCommandBuffer = NULL;
+				sb_Push( ecps->sbProcessRanges, newRange );
 			}
+
+			ProcessRange* range = &( ecps->sbProcessRanges[numRanges] );
+			range->arrayIdx = (uint32_t)cai;
+			range->start = start;
+			range->end = ( ( pca->count - start ) > PROCESS_RANGE_SIZE ) ? ( start + PROCESS_RANGE_SIZE ) : pca->count;
+			process->stats.lastEntitiesVisited += (uint32_t)( range->end - range->start );
+			++numRanges;
 		}
 	}
-	ecps->isRunningProcess = false;
 
-	if( process->postProc != NULL ) {
-		process->postProc( ecps );
+	ProcessRangeContext ctx;
+	ctx.ecps = ecps;
+	ctx.process = process;
+	jq_ParallelFor( numRanges, 1, runProcessRanges, &ctx );
+
+	for( size_t i = 0; i < numRanges; ++i ) {
+		ProcessRange* range = &( ecps->sbProcessRanges[i] );
+		size_t size = sb_Count( range->sbCommandBuffer );
+		if( size > 0 ) {
+			uint8_t* cmdData = sb_Add( ecps->sbCommandBuffer, size );
+			memcpy( cmdData, range->sbCommandBuffer, size );
+			sb_Clear( range->sbCommandBuffer );
+		}
 	}
+}
 
+// runs all the structural changes that were put off while processes were running
+static void runCommandBuffer( ECPS* ecps )
+{
 	if( sb_Count( ecps->sbCommandBuffer ) > 0 ) {
 		// run the command buffer
 		uint8_t* cmdBuffer = ecps->sbCommandBuffer;
 		uint8_t* bufferEnd = &( sb_Last( ecps->sbCommandBuffer ) );
 
-		size_t size = sb_Count( ecps->sbCommandBuffer );
-		int numCmds = 0;
+		// creates and destroys that are next to each other are run together, they don't depend on each other
+		//  so the end result is the same as running them one at a time
 		while( cmdBuffer < bufferEnd ) {
+#if MEMORY_PROFILE == MEMORY_PROFILE_DEBUG
 			mem_Verify( );
-			++numCmds;
+#endif
 			CommandType cmdType = *( (CommandType*)cmdBuffer );
 			switch( cmdType ) {
 			case CMD_ADD_COMPONENT:
 				cmdBuffer = runAddComponentCommand( ecps, cmdBuffer );
 				break;
 			case CMD_CREATE_ENTITY:
-				cmdBuffer = runCreateCommand( ecps, cmdBuffer );
+				cmdBuffer = runCreateCommands( ecps, cmdBuffer, bufferEnd );
 				break;
 			case CMD_DESTROY_ENTITY:
-				cmdBuffer = runDestroyEntityCommand( ecps, cmdBuffer );
+				cmdBuffer = runDestroyEntityCommands( ecps, cmdBuffer, bufferEnd );
 				break;
 			case CMD_REMOVE_COMPONENT:
 				cmdBuffer = runRemoveComponentCommand( ecps, cmdBuffer );
@@ -398,7 +899,9 @@ void ecps_RunProcess( ECPS* ecps, Process* process )
 				assert( false && "Invalid command" );
 				break;
 			}
+#if MEMORY_PROFILE == MEMORY_PROFILE_DEBUG
 			mem_Verify( );
+#endif
 			assert( cmdBuffer <= ( bufferEnd + 1 ) );
 		}
 
@@ -406,37 +909,216 @@ void ecps_RunProcess( ECPS* ecps, Process* process )
 	}
 }
 
-static void createEntityVA( ECPS* ecps, EntityID entityID, size_t numComponents, va_list va )
+// run a process, must have been created with the associated entity-component-process system
+void ecps_RunProcess( ECPS* ecps, Process* process )
 {
-	va_list list;
+	assert( ecps != NULL );
+	assert( ecps->isRunning );
 
-	ComponentBitFlags entityBitFlags;
+	size_t presize = sb_Count( ecps->sbCommandBuffer );
 
-	va_copy( list, va ); {
-		memset( &entityBitFlags, 0, sizeof( ComponentBitFlags ) );
-		for( size_t i = 0; i < numComponents; ++i ) {
-			ComponentID compID = va_arg( list, ComponentID );
-			va_arg( list, void* );
-			//assert( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) );
-			if( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) ) {
-				ecps_cbf_SetFlagOn( &entityBitFlags, compID );
-			} else {
-				llog( LOG_DEBUG, "Creating an entity with invalid component at varg position: %i", i );
-			}
-		}
-	} va_end( list );
+	// verify the process is part of the entity-component-process system
+	assert( ( ecps->id ) == ( process->ecpsID ) );
 
-	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_ID );
+	Uint64 startTime = SDL_GetPerformanceCounter( );
+	process->stats.lastArraysVisited = 0;
+	process->stats.lastEntitiesVisited = 0;
+
+	// anything the process changes is marked with the new version, so it won't see it's own changes next time
+	++( ecps->changeVersion );
+
+	// then run the process, looping through all the entities
+	if( process->preProc != NULL ) {
+		process->preProc( ecps );
+	}
+
+	ecps->isRunningProcess = true;
+	if( ( process->proc != NULL ) || ( process->chunkProc != NULL ) ) {
+		if( process->isThreadSafe ) {
+			runProcessParallel( ecps, process );
+		} else {
+			// will need to iterate through all entities that have the components the process is looking for
+			uint32_t sequence = 0;
+			size_t numMatching = sb_Count( process->sbMatchingArrays );
+			for( size_t i = 0; i < numMatching; ++i ) {
+				PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[process->sbMatchingArrays[i]] );
+				if( pca->count == 0 ) {
+					continue;
+				}
+
+				++( process->stats.lastArraysVisited );
+				if( process->filterChanges ) {
+					runProcessOnChangedRanges( ecps, process, pca, &sequence );
+				} else {
+					process->stats.lastEntitiesVisited += (uint32_t)pca->count;
+					runProcessOnArray( ecps, process, pca, 0, pca->count, sequence++ );
+				}
+			}
+		}
+	}
+	ecps->isRunningProcess = false;
+
+	if( process->postProc != NULL ) {
+		process->postProc( ecps );
+	}
+
+	// everything after this, including the commands the process added, is newer than the process
+	process->lastRunVersion = ecps->changeVersion;
+	++( ecps->changeVersion );
+
+	runCommandBuffer( ecps );
+
+	Uint64 endTime = SDL_GetPerformanceCounter( );
+	double ms = (double)( endTime - startTime ) * 1000.0 / (double)SDL_GetPerformanceFrequency( );
+	process->stats.lastMS = (float)ms;
+	++( process->stats.totalRuns );
+	process->stats.totalEntitiesVisited += process->stats.lastEntitiesVisited;
+	process->stats.totalMS += ms;
+}
+
+void ecps_ForEachChunk( ECPS* ecps, Process* process, ChunkFunc func, void* context )
+{
+	assert( ecps != NULL );
+	assert( ecps->isRunning );
+	assert( process != NULL );
+	assert( func != NULL );
+	assert( ( ecps->id ) == ( process->ecpsID ) );
+
+	ecps->isRunningProcess = true;
+	uint32_t sequence = 0;
+	size_t numMatching = sb_Count( process->sbMatchingArrays );
+	for( size_t i = 0; i < numMatching; ++i ) {
+		PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[process->sbMatchingArrays[i]] );
+		if( pca->count == 0 ) {
+			continue;
+		}
+
+		EntityChunk chunk;
+		setupChunk( ecps, pca, 0, pca->count, sequence++, &chunk );
+		func( ecps, &chunk, context );
+	}
+	ecps->isRunningProcess = false;
+
+	runCommandBuffer( ecps );
+}
+
+bool ecps_GetChunkComponent( const EntityChunk* chunk, ComponentID componentID, void** outFirst, size_t* outStride )
+{
+	assert( chunk != NULL );
+	assert( outFirst != NULL );
+	assert( componentID < MAX_NUM_COMPONENT_TYPES );
+
+	const PackageStructureEntry* entry = &( chunk->structure->entries[componentID] );
+	if( entry->offset < 0 ) {
+		(*outFirst) = NULL;
+		if( outStride != NULL ) {
+			(*outStride) = 0;
+		}
+		return false;
+	}
+
+	(*outFirst) = ( (uint8_t*)( chunk->data ) ) + entry->offset + ( chunk->start * entry->stride );
+	if( outStride != NULL ) {
+		(*outStride) = entry->stride;
+	}
+
+	if( chunk->count > 0 ) {
+		size_t lastRange = ( chunk->start + chunk->count - 1 ) / PROCESS_RANGE_SIZE;
+		for( size_t r = chunk->start / PROCESS_RANGE_SIZE; r <= lastRange; ++r ) {
+			markComponentChanged( chunk->changeVersions, chunk->version, r * PROCESS_RANGE_SIZE, componentID );
+		}
+	}
+	return true;
+}
+
+bool ecps_ReadChunkComponent( const EntityChunk* chunk, ComponentID componentID, const void** outFirst, size_t* outStride )
+{
+	assert( chunk != NULL );
+	assert( outFirst != NULL );
+	assert( componentID < MAX_NUM_COMPONENT_TYPES );
+
+	const PackageStructureEntry* entry = &( chunk->structure->entries[componentID] );
+	if( entry->offset < 0 ) {
+		(*outFirst) = NULL;
+		if( outStride != NULL ) {
+			(*outStride) = 0;
+		}
+		return false;
+	}
+
+	(*outFirst) = ( (const uint8_t*)( chunk->data ) ) + entry->offset + ( chunk->start * entry->stride );
+	if( outStride != NULL ) {
+		(*outStride) = entry->stride;
+	}
+	return true;
+}
+
+EntityID ecps_GetChunkEntityID( const EntityChunk* chunk, size_t index )
+{
+	assert( chunk != NULL );
+	assert( index < chunk->count );
+
+	const PackageStructureEntry* entry = &( chunk->structure->entries[sharedComponent_ID] );
+	return *( (EntityID*)( ( (uint8_t*)( chunk->data ) ) + entry->offset + ( ( chunk->start + index ) * entry->stride ) ) );
+}
+
+void ecps_UseColumnarLayout( ECPS* ecps, bool columnar )
+{
+	assert( ecps != NULL );
+	// the arrays can't be switched once they've been made
+	assert( sb_Count( ecps->componentData.sbComponentArrays ) == 0 );
+	ecps->columnarLayout = columnar;
+}
+
+void ecps_ResetProcessStats( Process* process )
+{
+	assert( process != NULL );
+	memset( &( process->stats ), 0, sizeof( process->stats ) );
+}
+
+void ecps_LogProcessStats( const Process* process )
+{
+	assert( process != NULL );
+
+	const ProcessStats* stats = &( process->stats );
+	llog( LOG_INFO, "Process %s stats:", process->name );
+	llog( LOG_INFO, "  Matching arrays: %u", (uint32_t)sb_Count( process->sbMatchingArrays ) );
+	llog( LOG_INFO, "  Last run: %u arrays, %u entities, %.3f ms", stats->lastArraysVisited, stats->lastEntitiesVisited, stats->lastMS );
+	llog( LOG_INFO, "  Total: %u runs, %llu entities, %.3f ms, %.3f ms per run", stats->totalRuns, (unsigned long long)stats->totalEntitiesVisited,
+		stats->totalMS, ( stats->totalRuns > 0 ) ? ( stats->totalMS / (double)stats->totalRuns ) : 0.0 );
+}
+
+static void createEntityVA( ECPS* ecps, EntityID entityID, size_t numComponents, va_list va )
+{
+	va_list list;
+
+	ComponentBitFlags entityBitFlags;
+
+	va_copy( list, va ); {
+		memset( &entityBitFlags, 0, sizeof( ComponentBitFlags ) );
+		for( size_t i = 0; i < numComponents; ++i ) {
+			ComponentID compID = va_arg( list, ComponentID );
+			va_arg( list, void* );
+			//assert( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) );
+			if( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) ) {
+				ecps_cbf_SetFlagOn( &entityBitFlags, compID );
+			} else {
+				llog( LOG_DEBUG, "Creating an entity with invalid component at varg position: %i", i );
+			}
+		}
+	} va_end( list );
+
+	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_ID );
 	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_Enabled );
 
 	// find or create the packaged array for this entity
 	uint32_t pcaIdx = createOrFindPackagedArray( ecps, &entityBitFlags );
 
 	// add the entity to the list
-	size_t currOffset = allocateDataForEntity( ecps, pcaIdx );
-	uint8_t* baseData = (uint8_t*)( &( ecps->componentData.sbComponentArrays[pcaIdx].sbData[currOffset] ) );
-	( *(EntityID*)( baseData ) ) = entityID;
-	modifyEntityDirectoryEntry( ecps, entityID, pcaIdx, currOffset );
+	size_t index = allocateDataForEntity( ecps, pcaIdx );
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[pcaIdx] );
+	( *(EntityID*)getComponentInArray( pca, index, sharedComponent_ID ) ) = entityID;
+	modifyEntityDirectoryEntry( ecps, entityID, pcaIdx, index );
 
 	va_copy( list, va ); {
 		for( size_t i = 0; i < numComponents; ++i ) {
@@ -447,10 +1129,10 @@ static void createEntityVA( ECPS* ecps, EntityID entityID, size_t numComponents,
 			if( compSize > 0 ) {
 				if( compData != NULL ) {
 					// have data, copy it
-					memcpy( &( baseData[ecps->componentData.sbComponentArrays[pcaIdx].structure.entries[compID].offset] ), compData, compSize );
+					memcpy( getComponentInArray( pca, index, compID ), compData, compSize );
 				} else {
 					// no data, zero it out
-					memset( &( baseData[ecps->componentData.sbComponentArrays[pcaIdx].structure.entries[compID].offset] ), 0, compSize );
+					memset( getComponentInArray( pca, index, compID ), 0, compSize );
 				}
 			}
 		}
@@ -464,6 +1146,8 @@ static void pushCreateCommand( ECPS* ecps, EntityID entityID, size_t numComponen
 	// first gather how much memory we'll need to allocate, should be slightly faster to do a 
 	//  single allocation than multiple
 	size_t totalSize = sizeof( CreateEntityCommand );
+	ComponentBitFlags entityBitFlags;
+	memset( &entityBitFlags, 0, sizeof( ComponentBitFlags ) );
 	va_copy( list, va ); {
 		for( size_t i = 0; i < numComponents; ++i ) {
 			ComponentID compID = va_arg( list, ComponentID );
@@ -471,11 +1155,21 @@ static void pushCreateCommand( ECPS* ecps, EntityID entityID, size_t numComponen
 
 			totalSize += sizeof( ComponentID );
 			totalSize += ecps->componentTypes.sbTypes[compID].size;
+
+			if( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) ) {
+				ecps_cbf_SetFlagOn( &entityBitFlags, compID );
+			} else {
+				llog( LOG_DEBUG, "Creating an entity with invalid component at varg position: %i", i );
+			}
 		}
 	} va_end( list );
 
+	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_ID );
+	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_Enabled );
+
 	// allocate the space
-	uint8_t* currMem = sb_Add( ecps->sbCommandBuffer, totalSize );
+	uint8_t** sbCommandBuffer = getCommandBuffer( ecps );
+	uint8_t* currMem = sb_Add( (*sbCommandBuffer), totalSize );
 	
 	// now copy all the data over
 	//  first the command specific stuff
@@ -483,6 +1177,8 @@ static void pushCreateCommand( ECPS* ecps, EntityID entityID, size_t numComponen
 	cmd.cmd = CMD_CREATE_ENTITY;
 	cmd.id = entityID;
 	cmd.numComps = numComponents;
+	cmd.size = (uint32_t)totalSize;
+	cmd.flags = entityBitFlags;
 	memcpy( currMem, &cmd, sizeof( CreateEntityCommand ) );
 	currMem += sizeof( CreateEntityCommand );
 
@@ -510,45 +1206,82 @@ static void pushCreateCommand( ECPS* ecps, EntityID entityID, size_t numComponen
 	} va_end( list );
 }
 
-// returns past end of command
-static uint8_t* runCreateCommand( ECPS* ecps, uint8_t* commandData )
+// adds the entity from the create command to the packaged array, returns past the end of the command
+static uint8_t* placeCreatedEntity( ECPS* ecps, uint8_t* commandData, uint32_t pcaIdx )
 {
 	CreateEntityCommand* cmd = (CreateEntityCommand*)commandData;
-	uint8_t* data;
 
-	ComponentBitFlags entityBitFlags;
+	// every component the entity has is copied from the command, so unlike allocateDataForEntity( ) there's no need
+	//  to clear the data first
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[pcaIdx] );
+	growPackagedArray( ecps, pcaIdx, pca->count + 1 );
+	size_t index = pca->count;
+	++( pca->count );
 
-	memset( &entityBitFlags, 0, sizeof( ComponentBitFlags ) );
-	data = commandData + sizeof( CreateEntityCommand );
+	( *(EntityID*)getComponentInArray( pca, index, sharedComponent_ID ) ) = cmd->id;
+	modifyEntityDirectoryEntry( ecps, cmd->id, pcaIdx, index );
+
+	uint8_t* data = commandData + sizeof( CreateEntityCommand );
 	for( size_t i = 0; i < cmd->numComps; ++i ) {
 		ComponentID compID = *( (ComponentID*)( data ) ); data += sizeof( ComponentID );
-		data += ecps->componentTypes.sbTypes[compID].size; // skip past the data for now
-
-		if( ecps_ct_IsComponentTypeValid( &( ecps->componentTypes ), compID ) ) {
-			ecps_cbf_SetFlagOn( &entityBitFlags, compID );
-		} else {
-			llog( LOG_DEBUG, "Creating an entity with invalid component at varg position: %i", i );
+		size_t compSize = ecps->componentTypes.sbTypes[compID].size;
+		if( compSize > 0 ) {
+			memcpy( getComponentInArray( pca, index, compID ), (void*)data, compSize );
 		}
+		data += compSize;
 	}
 
-	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_ID );
-	ecps_cbf_SetFlagOn( &entityBitFlags, sharedComponent_Enabled );
+	return data;
+}
 
-	// find or create the packaged array for this entity
-	uint32_t pcaIdx = createOrFindPackagedArray( ecps, &entityBitFlags );
+// runs all the create commands in a row, first finding the packaged array each entity goes into so every array
+//  and the entity directory only have to grow once, returns past the end of the last create command
+static uint8_t* runCreateCommands( ECPS* ecps, uint8_t* commandData, uint8_t* bufferEnd )
+{
+	sb_Clear( ecps->sbBatchArrays );
+	growBatchCounts( ecps );
+
+	ComponentBitFlags lastFlags;
+	uint32_t lastPCAIdx = UINT32_MAX;
+	size_t directorySize = 0;
+
+	uint8_t* data = commandData;
+	while( ( data < bufferEnd ) && ( *( (CommandType*)data ) == CMD_CREATE_ENTITY ) ) {
+		CreateEntityCommand* cmd = (CreateEntityCommand*)data;
+		EntityID entityID = cmd->id;
+		data += cmd->size;
+
+		// spawning tends to create a lot of the same kind of entity in a row, so skip the look up when we can
+		if( ( lastPCAIdx == UINT32_MAX ) || !ecps_cbf_CompareExact( &( cmd->flags ), &lastFlags ) ) {
+			lastPCAIdx = createOrFindPackagedArray( ecps, &( cmd->flags ) );
+			lastFlags = cmd->flags;
+			growBatchCounts( ecps );
+		}
 
-	// add the entity to the list
-	size_t currOffset = allocateDataForEntity( ecps, pcaIdx );
-	uint8_t* baseData = (uint8_t*)( &( ecps->componentData.sbComponentArrays[pcaIdx].sbData[currOffset] ) );
-	( *(EntityID*)( baseData ) ) = cmd->id;
-	modifyEntityDirectoryEntry( ecps, cmd->id, pcaIdx, currOffset );
+		sb_Push( ecps->sbBatchArrays, lastPCAIdx );
+		++( ecps->sbBatchCounts[lastPCAIdx] );
 
-	data = commandData + sizeof( CreateEntityCommand );
-	for( size_t i = 0; i < cmd->numComps; ++i ) {
-		ComponentID compID = *( (ComponentID*)( data ) ); data += sizeof( ComponentID );
-		size_t compSize = ecps->componentTypes.sbTypes[compID].size;
-		memcpy( &( baseData[ecps->componentData.sbComponentArrays[pcaIdx].structure.entries[compID].offset] ), (void*)data, compSize );
-		data += compSize;
+		size_t idx = (size_t)idSet_GetIndex( entityID );
+		if( idx >= directorySize ) {
+			directorySize = idx + 1;
+		}
+	}
+
+	// make room for everything
+	growEntityDirectory( ecps, directorySize );
+	for( size_t i = 0; i < sb_Count( ecps->sbBatchCounts ); ++i ) {
+		if( ecps->sbBatchCounts[i] > 0 ) {
+			PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[i] );
+			growPackagedArray( ecps, (int32_t)i, pca->count + ecps->sbBatchCounts[i] );
+			markRangeChanged( ecps, pca, pca->count, pca->count + ecps->sbBatchCounts[i] );
+			ecps->sbBatchCounts[i] = 0;
+		}
+	}
+
+	// then add them in the same order they were created in
+	data = commandData;
+	for( size_t i = 0; i < sb_Count( ecps->sbBatchArrays ); ++i ) {
+		data = placeCreatedEntity( ecps, data, ecps->sbBatchArrays[i] );
 	}
 
 	return data;
@@ -564,7 +1297,19 @@ EntityID ecps_CreateEntity( ECPS* ecps, size_t numComponents, ... )
 {
 	assert( ecps != NULL );
 
-	EntityID entityID = idSet_ClaimID( &( ecps->idSet ) );
+	// thread safe processes can create entities from any thread
+	EntityID entityID;
+	SDL_AtomicLock( &( ecps->idLock ) ); {
+		entityID = idSet_ClaimID( &( ecps->idSet ) );
+		if( entityID == INVALID_ENTITY_ID ) {
+			size_t currSize = sb_Count( ecps->idSet.sbIDData );
+			if( currSize < ID_SET_MAX_SIZE ) {
+				size_t newSize = ( currSize > ( ID_SET_MAX_SIZE / 2 ) ) ? ID_SET_MAX_SIZE : ( currSize * 2 );
+				idSet_IncreaseMaximum( &( ecps->idSet ), newSize );
+				entityID = idSet_ClaimID( &( ecps->idSet ) );
+			}
+		}
+	} SDL_AtomicUnlock( &( ecps->idLock ) );
 	va_list list;
 
 	if( entityID == 0 ) {
@@ -599,19 +1344,17 @@ bool ecps_GetEntityByID( ECPS* ecps, EntityID entityID, Entity* outEntity )
 		return false;
 	}
 
-	size_t posOffset = ecps->componentData.sbEntityDirectory[idx].positionOffset;
+	size_t index = ecps->componentData.sbEntityDirectory[idx].index;
 	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[arrayIdx] );
 
 	// check to make sure the indexed entity found is the entity we're searching for
-	EntityID foundID = *( (EntityID*)( &( pca->sbData[posOffset] ) ) );
+	EntityID foundID = getEntityIDInArray( pca, index );
 	if( foundID != entityID ) {
 		return false;
 	}
 
 	if( outEntity != NULL ) {
-		outEntity->id = entityID;
-		outEntity->data = (void*)( &( pca->sbData[posOffset] ) );
-		outEntity->structure = &( pca->structure );
+		setupEntity( ecps, pca, entityID, index, outEntity );
 	}
 
 	return true;
@@ -619,15 +1362,6 @@ bool ecps_GetEntityByID( ECPS* ecps, EntityID entityID, Entity* outEntity )
 
 static int immediateAddComponentToEntity( ECPS* ecps, Entity* entity, ComponentID componentID, void* data )
 {
-	ComponentBitFlags oldBitFlags;
-	ComponentBitFlags newBitFlags;
-
-	PackageStructure* fromStructure = NULL;
-	uint8_t* fromData = NULL;
-
-	PackageStructure* toStructure = NULL;
-	uint8_t* toData = NULL;
-
 	int32_t toPackedArrayIndex = -1;
 
 	uint32_t idx = idSet_GetIndex( entity->id );
@@ -643,63 +1377,54 @@ static int immediateAddComponentToEntity( ECPS* ecps, Entity* entity, ComponentI
 	}
 
 	int32_t fromPackedArrayIndex = directoryEntry->packedArrayIdx;
-	size_t fromCompArrayPos = directoryEntry->positionOffset;
+	size_t fromIndex = directoryEntry->index;
 	assert( fromPackedArrayIndex >= 0 );
 
-	fromData = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex].sbData[fromCompArrayPos] );
-	fromStructure = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex].structure );
-
-	EntityID foundID = *( (EntityID*)fromData );
+	PackagedComponentArray* fromPCA = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex] );
+	EntityID foundID = getEntityIDInArray( fromPCA, fromIndex );
 	if( foundID != entity->id ) {
 		return -3;
 	}
 
-	size_t currOffset = 0;
+	PackagedComponentArray* toPCA = NULL;
+	size_t toIndex = 0;
 	// if the entity already has that component, then don't bother adding it
-	if( fromStructure->entries[componentID].offset >= 0 ) {
-		currOffset = fromCompArrayPos;
-
-		entity->structure = fromStructure;
-		entity->data = fromData;
+	if( fromPCA->structure.entries[componentID].offset >= 0 ) {
+		toPCA = fromPCA;
+		toIndex = fromIndex;
 	} else {
 		// entity shouldn't have desired component type, copy over to new array, initialize, and update
 
-		// get from bit flags and generate new bit flags
-		oldBitFlags = ecps->componentData.sbBitFlags[fromPackedArrayIndex];
-		newBitFlags = oldBitFlags;
-		ecps_cbf_SetFlagOn( &newBitFlags, componentID );
-
-		toPackedArrayIndex = createOrFindPackagedArray( ecps, &newBitFlags );
+		toPackedArrayIndex = findPackagedArrayEdge( ecps, fromPackedArrayIndex, componentID, true );
+		toIndex = allocateDataForEntity( ecps, toPackedArrayIndex );
 
-		int32_t currArrayIdx = -1;
-		currOffset = allocateDataForEntity( ecps, toPackedArrayIndex );
-		toData = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex].sbData[currOffset] );
-		toStructure = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex].structure );
+		// finding the new array can create it and move all the arrays, so we have to get them again
+		fromPCA = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex] );
+		toPCA = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex] );
 
 		// copy over
-		//  NOTE: We directly access the fromStructure here as teh allocateDataForEntity can invalidate our old pointer
-		entityCopy( ecps, fromData, &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex].structure ), toData, toStructure );
+		entityCopy( ecps, fromPCA, fromIndex, toPCA, toIndex );
 
 		// remove from old array and update entity directory entry
-		freeUpDataFromEntity( ecps, fromPackedArrayIndex, fromCompArrayPos );
+		freeUpDataFromEntity( ecps, fromPackedArrayIndex, fromIndex );
 
 		// update
 		directoryEntry->packedArrayIdx = toPackedArrayIndex;
-		directoryEntry->positionOffset = currOffset;
-
-		entity->structure = toStructure;
-		entity->data = toData;
+		directoryEntry->index = toIndex;
 	}
 
+	setupEntity( ecps, toPCA, entity->id, toIndex, entity );
+	markEntityChanged( ecps, toPCA, toIndex );
+
 	// set the data to use for initialization, as long as data needs to be set
 	if( ecps->componentTypes.sbTypes[componentID].size > 0 ) {
-		uint8_t* bytes = (uint8_t*)( entity->data );
+		uint8_t* compData = getComponentInArray( toPCA, toIndex, componentID );
 		if( data != NULL ) {
 			// copy the data
-			memcpy( &( bytes[ ( entity->structure )->entries[componentID].offset ] ), data, ecps->componentTypes.sbTypes[componentID].size );
+			memcpy( compData, data, ecps->componentTypes.sbTypes[componentID].size );
 		} else {
 			// set the data to 0
-			memset( &( bytes[ ( entity->structure )->entries[componentID].offset ] ), 0, ecps->componentTypes.sbTypes[componentID].size );
+			memset( compData, 0, ecps->componentTypes.sbTypes[componentID].size );
 		}
 	}
 
@@ -716,7 +1441,8 @@ static void pushAddComponentCommand( ECPS* ecps, Entity* entity, ComponentID com
 	size_t compSize = ecps->componentTypes.sbTypes[componentID].size;
 	size_t totalSize = sizeof( AddComponentCommand ) + compSize;
 
-	uint8_t* cmdData = sb_Add( ecps->sbCommandBuffer, totalSize );
+	uint8_t** sbCommandBuffer = getCommandBuffer( ecps );
+	uint8_t* cmdData = sb_Add( (*sbCommandBuffer), totalSize );
 
 	memcpy( cmdData, &cmd, sizeof( AddComponentCommand ) );
 	cmdData += sizeof( AddComponentCommand );
@@ -777,20 +1503,10 @@ int ecps_AddComponentToEntityByID( ECPS* ecps, EntityID entityID, ComponentID co
 
 static int immediateRemoveComponentFromEntity( ECPS* ecps, Entity* entity, ComponentID componentID )
 {
-	ComponentBitFlags oldBitFlags;
-	ComponentBitFlags newBitFlags;
-
-	PackageStructure* fromStructure = NULL;
-	uint8_t* fromData = NULL;
-
-	PackageStructure* toStructure = NULL;
-	uint8_t* toData = NULL;
-
 	int32_t toPackedArrayIndex = -1;
 
 	uint32_t idx = idSet_GetIndex( entity->id );
 
-	size_t entityDirectoryCount = sb_Count( ecps->componentData.sbEntityDirectory );
 	if( idx >= sb_Count( ecps->componentData.sbEntityDirectory ) ) {
 		return -2;
 	}
@@ -802,45 +1518,38 @@ static int immediateRemoveComponentFromEntity( ECPS* ecps, Entity* entity, Compo
 	}
 
 	int32_t fromPackedArrayIndex = directoryEntry->packedArrayIdx;
-	size_t fromCompArrayPos = directoryEntry->positionOffset;
+	size_t fromIndex = directoryEntry->index;
 	assert( fromPackedArrayIndex >= 0 );
 
-	fromData = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex].sbData[fromCompArrayPos] );
-	fromStructure = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex].structure );
-
-	EntityID foundID = *( (EntityID*)fromData );
+	PackagedComponentArray* fromPCA = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex] );
+	EntityID foundID = getEntityIDInArray( fromPCA, fromIndex );
 	if( foundID != entity->id ) {
 		return -3;
 	}
 
 	// no reason to remove the entity
-	if( fromStructure->entries[componentID].offset < 0 ) {
+	if( fromPCA->structure.entries[componentID].offset < 0 ) {
 		return 0;
 	}
 
-	// get from bit flags and generate new bit flags
-	oldBitFlags = ecps->componentData.sbBitFlags[fromPackedArrayIndex];
-	newBitFlags = oldBitFlags;
-	ecps_cbf_SetFlagOff( &newBitFlags, componentID );
-
 	// add spot to new array
-	toPackedArrayIndex = createOrFindPackagedArray( ecps, &newBitFlags );
-	size_t currOffset = allocateDataForEntity( ecps, toPackedArrayIndex );
+	toPackedArrayIndex = findPackagedArrayEdge( ecps, fromPackedArrayIndex, componentID, false );
+	size_t toIndex = allocateDataForEntity( ecps, toPackedArrayIndex );
 
-	toData = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex].sbData[currOffset] );
-	toStructure = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex].structure );
+	// finding the new array can create it and move all the arrays, so we have to get them again
+	fromPCA = &( ecps->componentData.sbComponentArrays[fromPackedArrayIndex] );
+	PackagedComponentArray* toPCA = &( ecps->componentData.sbComponentArrays[toPackedArrayIndex] );
 
 	// copy over
-	entityCopy( ecps, fromData, fromStructure, toData, toStructure );
+	entityCopy( ecps, fromPCA, fromIndex, toPCA, toIndex );
 
 	// remove from old array and update entity directory entry
-	freeUpDataFromEntity( ecps, fromPackedArrayIndex, fromCompArrayPos );
+	freeUpDataFromEntity( ecps, fromPackedArrayIndex, fromIndex );
 
 	directoryEntry->packedArrayIdx = toPackedArrayIndex;
-	directoryEntry->positionOffset = currOffset;
+	directoryEntry->index = toIndex;
 
-	entity->structure = toStructure;
-	entity->data = toData;
+	setupEntity( ecps, toPCA, entity->id, toIndex, entity );
 
 	return 0;
 }
@@ -852,7 +1561,8 @@ static void pushRemoveComponentCommand( ECPS* ecps, Entity* entity, ComponentID
 	cmd.id = entity->id;
 	cmd.compID = componentID;
 
-	uint8_t* cmdData = sb_Add( ecps->sbCommandBuffer, sizeof( RemoveComponentCommand ) );
+	uint8_t** sbCommandBuffer = getCommandBuffer( ecps );
+	uint8_t* cmdData = sb_Add( (*sbCommandBuffer), sizeof( RemoveComponentCommand ) );
 
 	memcpy( cmdData, &cmd, sizeof( RemoveComponentCommand ) );
 }
@@ -934,11 +1644,39 @@ bool ecps_GetComponentFromEntity( const Entity* entity, ComponentID componentID,
 		return false;
 	}
 
-	uint8_t* bytes = (uint8_t*)( entity->data );
-	(*outData) = &( bytes[ ( entity->structure )->entries[componentID].offset ] );
+	const PackageStructureEntry* entry = &( entity->structure->entries[componentID] );
+	(*outData) = ( (uint8_t*)( entity->data ) ) + entry->offset + ( entity->index * entry->stride );
+	markComponentChanged( entity->changeVersions, entity->version, entity->index, componentID );
 	return true;
 }
 
+bool ecps_ReadComponentFromEntity( const Entity* entity, ComponentID componentID, const void** outData )
+{
+	assert( entity != NULL );
+	assert( outData != NULL );
+
+	if( ( componentID == INVALID_COMPONENT_ID ) || ( entity->structure->entries[componentID].offset < 0 ) ) {
+		(*outData) = NULL;
+		return false;
+	}
+
+	const PackageStructureEntry* entry = &( entity->structure->entries[componentID] );
+	(*outData) = ( (const uint8_t*)( entity->data ) ) + entry->offset + ( entity->index * entry->stride );
+	return true;
+}
+
+bool ecps_ReadComponentFromEntityByID( ECPS* ecps, EntityID entityID, ComponentID componentID, const void** outData )
+{
+	assert( ecps != NULL );
+
+	Entity entity;
+	if( !ecps_GetEntityByID( ecps, entityID, &entity ) ) {
+		return false;
+	}
+
+	return ecps_ReadComponentFromEntity( &entity, componentID, outData );
+}
+
 bool ecps_GetComponentFromEntityByID( ECPS* ecps, EntityID entityID, ComponentID componentID, void** outData )
 {
 	assert( ecps != NULL );
@@ -965,6 +1703,11 @@ bool ecps_GetEntityAndComponentByID( ECPS* ecps, EntityID entityID, ComponentID
 
 static void immediateDestroyEntity( ECPS* ecps, EntityID entityID )
 {
+	// a stale id would tear down whatever entity is using the index now
+	if( !idSet_IsIDValid( &( ecps->idSet ), entityID ) ) {
+		return;
+	}
+
 	removeEntityFromArray( ecps, entityID );
 	idSet_ReleaseID( &( ecps->idSet ), entityID );
 }
@@ -975,18 +1718,52 @@ static void pushDestroyEntityCommand( ECPS* ecps, EntityID id )
 	cmd.cmd = CMD_DESTROY_ENTITY;
 	cmd.id = id;
 	
-	uint8_t* cmdData = sb_Add( ecps->sbCommandBuffer, sizeof( DestroyEntityCommand ) );
+	uint8_t** sbCommandBuffer = getCommandBuffer( ecps );
+	uint8_t* cmdData = sb_Add( (*sbCommandBuffer), sizeof( DestroyEntityCommand ) );
 
 	memcpy( cmdData, &cmd, sizeof( DestroyEntityCommand ) );
 }
 
-static uint8_t* runDestroyEntityCommand( ECPS* ecps, uint8_t* commandData )
+// runs all the destroy commands in a row, the entities are only marked as destroyed at first and the holes are
+//  filled in afterwards, so entities aren't moved into spots that are about to be freed up
+//  returns past the end of the last destroy command
+static uint8_t* runDestroyEntityCommands( ECPS* ecps, uint8_t* commandData, uint8_t* bufferEnd )
 {
-	DestroyEntityCommand* cmd = (DestroyEntityCommand*)commandData;
+	sb_Clear( ecps->sbBatchSpots );
 
-	immediateDestroyEntity( ecps, cmd->id );
+	uint8_t* data = commandData;
+	while( ( data < bufferEnd ) && ( *( (CommandType*)data ) == CMD_DESTROY_ENTITY ) ) {
+		EntityID entityID = ( (DestroyEntityCommand*)data )->id;
+		data += sizeof( DestroyEntityCommand );
 
-	return ( commandData + sizeof( DestroyEntityCommand ) );
+		// the entity may have been destroyed already, either by an earlier command in this batch or before the
+		//  command was run, in which case the index could belong to a different entity now
+		if( !idSet_IsIDValid( &( ecps->idSet ), entityID ) ) {
+			continue;
+		}
+
+		uint32_t idx = idSet_GetIndex( entityID );
+		assert( idx < sb_Count( ecps->componentData.sbEntityDirectory ) );
+		int32_t packedArrayIdx = ecps->componentData.sbEntityDirectory[idx].packedArrayIdx;
+		if( packedArrayIdx >= 0 ) {
+			PackagedArraySpot spot;
+			spot.arrayIdx = (uint32_t)packedArrayIdx;
+			spot.index = ecps->componentData.sbEntityDirectory[idx].index;
+			sb_Push( ecps->sbBatchSpots, spot );
+
+			PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[packedArrayIdx] );
+			( *(EntityID*)getComponentInArray( pca, spot.index, sharedComponent_ID ) ) = INVALID_ENTITY_ID;
+			modifyEntityDirectoryEntry( ecps, entityID, -1, 0 );
+		}
+
+		idSet_ReleaseID( &( ecps->idSet ), entityID );
+	}
+
+	for( size_t i = 0; i < sb_Count( ecps->sbBatchSpots ); ++i ) {
+		fillArrayHole( ecps, (int32_t)ecps->sbBatchSpots[i].arrayIdx, ecps->sbBatchSpots[i].index );
+	}
+
+	return data;
 }
 
 void ecps_DestroyEntity( ECPS* ecps, const Entity* entity )
@@ -1019,10 +1796,1168 @@ void ecps_DestroyAllEntities( ECPS* ecps )
 
 	for( size_t i = 0; i < sb_Count( ecps->componentData.sbComponentArrays ); ++i ) {
 		sb_Release( ecps->componentData.sbComponentArrays[i].sbData );
+		sb_Release( ecps->componentData.sbComponentArrays[i].sbChangeVersions );
 	}
 	sb_Release( ecps->componentData.sbComponentArrays );
 	ecps->componentData.sbComponentArrays = NULL;
 
 	sb_Release( ecps->componentData.sbEntityDirectory );
 	ecps->componentData.sbEntityDirectory = NULL;
-}
\ No newline at end of file
+
+	sb_Release( ecps->componentData.sbEdges );
+	ecps->componentData.sbEdges = NULL;
+
+	sb_Release( ecps->componentData.sbArrayLookup );
+	ecps->componentData.sbArrayLookup = NULL;
+
+	sb_Clear( ecps->sbBatchCounts );
+
+	// all the arrays are gone, so nothing matches anymore
+	for( size_t i = 0; i < sb_Count( ecps->sbProcesses ); ++i ) {
+		sb_Clear( ecps->sbProcesses[i]->sbMatchingArrays );
+	}
+}
+
+// ***** Snapshots
+// a snapshot is a SnapshotHeader, the size of each component type, each packaged array with a SnapshotArrayHeader
+//  followed by it's entities, the entity directory, and then the id set
+// the entities are stored the same way the array stores them, except columnar arrays only store the part of each
+//  column that's in use, so restoring into an array with the same layout is a single copy per column
+// every section is padded out to a multiple of 8 bytes
+#define SNAPSHOT_MAGIC 0x53504345 // "ECPS"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t idSize;
+	uint32_t numComponentTypes;
+	uint32_t numArrays;
+	uint32_t numDirectoryEntries;
+} SnapshotHeader;
+
+typedef struct {
+	ComponentBitFlags flags;
+	uint32_t columnar;
+	uint64_t count;
+} SnapshotArrayHeader;
+
+static size_t snapshotAlign( size_t size )
+{
+	return ( size + 7 ) & ~( (size_t)7 );
+}
+
+static size_t snapshotArrayDataSize( const PackagedComponentArray* pca, size_t count )
+{
+	return snapshotAlign( pca->entitySize * count );
+}
+
+static uint8_t* writeSnapshotArray( PackagedComponentArray* pca, uint8_t* out )
+{
+	if( pca->count == 0 ) {
+		return out;
+	}
+
+	if( !pca->columnar ) {
+		memcpy( out, pca->sbData, pca->entitySize * pca->count );
+	} else {
+		uint8_t* column = out;
+		for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+			const PackageStructureEntry* entry = &( pca->structure.entries[i] );
+			if( ( entry->offset >= 0 ) && ( entry->stride > 0 ) ) {
+				memcpy( column, getComponentInArray( pca, 0, (ComponentID)i ), entry->stride * pca->count );
+				column += entry->stride * pca->count;
+			}
+		}
+	}
+
+	return out + snapshotArrayDataSize( pca, pca->count );
+}
+
+// replaces the entities in the array with the ones in the snapshot, the snapshot array may have a different layout
+static void readSnapshotArray( ECPS* ecps, uint32_t arrayIdx, const uint8_t* data, size_t count, bool columnar )
+{
+	PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[arrayIdx] );
+
+	// nothing in the array needs to be kept if it has to grow
+	pca->count = 0;
+	growPackagedArray( ecps, (int32_t)arrayIdx, count );
+	pca = &( ecps->componentData.sbComponentArrays[arrayIdx] );
+	pca->count = count;
+	markRangeChanged( ecps, pca, 0, count );
+	if( count == 0 ) {
+		return;
+	}
+
+	if( !columnar && !pca->columnar ) {
+		memcpy( pca->sbData, data, pca->entitySize * count );
+		return;
+	}
+
+	// describe the snapshot data as a full array so we can use the same accessors
+	PackagedComponentArray snapshotPCA;
+	snapshotPCA.columnar = columnar;
+	snapshotPCA.count = count;
+	snapshotPCA.capacity = count;
+	snapshotPCA.sbData = (uint8_t*)data;
+	setupArrayStructure( ecps, &snapshotPCA, &( ecps->componentData.sbBitFlags[arrayIdx] ) );
+
+	for( size_t i = 0; i < MAX_NUM_COMPONENT_TYPES; ++i ) {
+		size_t size = pca->structure.entries[i].stride;
+		if( ( pca->structure.entries[i].offset < 0 ) || ( size == 0 ) ) {
+			continue;
+		}
+
+		if( columnar && pca->columnar ) {
+			memcpy( getComponentInArray( pca, 0, (ComponentID)i ), getComponentInArray( &snapshotPCA, 0, (ComponentID)i ), size * count );
+		} else {
+			size = ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i );
+			for( size_t e = 0; e < count; ++e ) {
+				memcpy( getComponentInArray( pca, e, (ComponentID)i ), getComponentInArray( &snapshotPCA, e, (ComponentID)i ), size );
+			}
+		}
+	}
+}
+
+size_t ecps_Snapshot( ECPS* ecps, uint8_t** sbOutSnapshot )
+{
+	assert( ecps != NULL );
+	assert( sbOutSnapshot != NULL );
+	assert( !( ecps->isRunningProcess ) );
+
+	SnapshotHeader header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.idSize = (uint32_t)sizeof( EntityID );
+	header.numComponentTypes = (uint32_t)ecps_ct_ComponentTypeCount( &( ecps->componentTypes ) );
+	header.numArrays = (uint32_t)sb_Count( ecps->componentData.sbComponentArrays );
+	header.numDirectoryEntries = (uint32_t)sb_Count( ecps->componentData.sbEntityDirectory );
+
+	// figure out the size first so it's all added at once
+	size_t totalSize = snapshotAlign( sizeof( header ) ) + snapshotAlign( sizeof( uint32_t ) * header.numComponentTypes );
+	for( uint32_t i = 0; i < header.numArrays; ++i ) {
+		PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[i] );
+		totalSize += snapshotAlign( sizeof( SnapshotArrayHeader ) ) + snapshotArrayDataSize( pca, pca->count );
+	}
+	totalSize += snapshotAlign( sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries );
+	totalSize += snapshotAlign( idSet_GetSnapshotSize( &( ecps->idSet ) ) );
+
+	sb_Clear( (*sbOutSnapshot) );
+	uint8_t* out = sb_Add( (*sbOutSnapshot), totalSize );
+	memset( out, 0, totalSize );
+
+	memcpy( out, &header, sizeof( header ) );
+	out += snapshotAlign( sizeof( header ) );
+
+	uint32_t* sizes = (uint32_t*)out;
+	for( uint32_t i = 0; i < header.numComponentTypes; ++i ) {
+		sizes[i] = (uint32_t)ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i );
+	}
+	out += snapshotAlign( sizeof( uint32_t ) * header.numComponentTypes );
+
+	for( uint32_t i = 0; i < header.numArrays; ++i ) {
+		PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[i] );
+		SnapshotArrayHeader arrayHeader;
+		memset( &arrayHeader, 0, sizeof( arrayHeader ) );
+		arrayHeader.flags = ecps->componentData.sbBitFlags[i];
+		arrayHeader.columnar = pca->columnar ? 1 : 0;
+		arrayHeader.count = pca->count;
+		memcpy( out, &arrayHeader, sizeof( arrayHeader ) );
+		out += snapshotAlign( sizeof( arrayHeader ) );
+
+		out = writeSnapshotArray( pca, out );
+	}
+
+	if( header.numDirectoryEntries > 0 ) {
+		memcpy( out, ecps->componentData.sbEntityDirectory, sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries );
+	}
+	out += snapshotAlign( sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries );
+
+	idSet_WriteSnapshot( &( ecps->idSet ), out );
+
+	return totalSize;
+}
+
+// if there are at least n bytes left in the snapshot after pos
+static bool snapshotHasRoom( size_t size, size_t pos, size_t n )
+{
+	return ( pos <= size ) && ( ( size - pos ) >= n );
+}
+
+// checks that everything in the snapshot matches and is in bounds without changing anything, fills in where the
+//  arrays, directory, and id set start
+//  returns -1 if the snapshot can't be restored
+static int checkSnapshot( ECPS* ecps, const uint8_t* snapshot, size_t size, SnapshotHeader* outHeader,
+	size_t* outArraysStart, size_t* outDirectoryStart, size_t* outIDSetStart )
+{
+	int result = -1;
+	uint64_t* sbArrayCounts = NULL;
+	ComponentBitFlags* sbArrayFlags = NULL;
+
+	SnapshotHeader header;
+	if( !snapshotHasRoom( size, 0, snapshotAlign( sizeof( header ) ) ) ) {
+		llog( LOG_ERROR, "Snapshot is too small." );
+		goto clean_up;
+	}
+	memcpy( &header, snapshot, sizeof( header ) );
+	if( ( header.magic != SNAPSHOT_MAGIC ) || ( header.version != SNAPSHOT_VERSION ) || ( header.idSize != sizeof( EntityID ) ) ) {
+		llog( LOG_ERROR, "Snapshot is from an incompatible version." );
+		goto clean_up;
+	}
+
+	size_t pos = snapshotAlign( sizeof( header ) );
+	size_t numTypes = ecps_ct_ComponentTypeCount( &( ecps->componentTypes ) );
+	if( ( header.numComponentTypes != numTypes ) || !snapshotHasRoom( size, pos, snapshotAlign( sizeof( uint32_t ) * numTypes ) ) ) {
+		llog( LOG_ERROR, "Snapshot component types don't match." );
+		goto clean_up;
+	}
+	for( uint32_t i = 0; i < header.numComponentTypes; ++i ) {
+		uint32_t compSize;
+		memcpy( &compSize, snapshot + pos + ( i * sizeof( uint32_t ) ), sizeof( compSize ) );
+		if( compSize != ecps_ct_GetComponentTypeSize( &( ecps->componentTypes ), i ) ) {
+			llog( LOG_ERROR, "Snapshot component types don't match." );
+			goto clean_up;
+		}
+	}
+	pos += snapshotAlign( sizeof( uint32_t ) * header.numComponentTypes );
+
+	(*outArraysStart) = pos;
+	for( uint32_t i = 0; i < header.numArrays; ++i ) {
+		SnapshotArrayHeader arrayHeader;
+		if( !snapshotHasRoom( size, pos, snapshotAlign( sizeof( arrayHeader ) ) ) ) {
+			llog( LOG_ERROR, "Snapshot is truncated." );
+			goto clean_up;
+		}
+		memcpy( &arrayHeader, snapshot + pos, sizeof( arrayHeader ) );
+		pos += snapshotAlign( sizeof( arrayHeader ) );
+
+		PackagedComponentArray sizing;
+		sizing.columnar = false;
+		sizing.capacity = 0;
+		setupArrayStructure( ecps, &sizing, &( arrayHeader.flags ) );
+		if( ( arrayHeader.count > ID_SET_MAX_SIZE ) || !snapshotHasRoom( size, pos, snapshotArrayDataSize( &sizing, (size_t)arrayHeader.count ) ) ) {
+			llog( LOG_ERROR, "Snapshot is truncated." );
+			goto clean_up;
+		}
+		pos += snapshotArrayDataSize( &sizing, (size_t)arrayHeader.count );
+
+		// two arrays with the same flags would be restored into the same array
+		for( size_t j = 0; j < sb_Count( sbArrayFlags ); ++j ) {
+			if( ecps_cbf_CompareExact( &( sbArrayFlags[j] ), &( arrayHeader.flags ) ) ) {
+				llog( LOG_ERROR, "Snapshot has more than one array with the same components." );
+				goto clean_up;
+			}
+		}
+		sb_Push( sbArrayFlags, arrayHeader.flags );
+		sb_Push( sbArrayCounts, arrayHeader.count );
+	}
+
+	(*outDirectoryStart) = pos;
+	if( !snapshotHasRoom( size, pos, snapshotAlign( sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries ) ) ) {
+		llog( LOG_ERROR, "Snapshot is truncated." );
+		goto clean_up;
+	}
+
+	// every entity has to be in one of the snapshot's arrays
+	for( uint32_t i = 0; i < header.numDirectoryEntries; ++i ) {
+		EntityDirectoryEntry entry;
+		memcpy( &entry, snapshot + pos + ( i * sizeof( EntityDirectoryEntry ) ), sizeof( entry ) );
+		if( ( entry.packedArrayIdx >= 0 ) &&
+			( ( (uint32_t)entry.packedArrayIdx >= header.numArrays ) || ( entry.index >= sbArrayCounts[entry.packedArrayIdx] ) ) ) {
+			llog( LOG_ERROR, "Snapshot entity directory isn't valid." );
+			goto clean_up;
+		}
+	}
+	pos += snapshotAlign( sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries );
+
+	(*outIDSetStart) = pos;
+	(*outHeader) = header;
+	result = 0;
+
+clean_up:
+	sb_Release( sbArrayCounts );
+	sb_Release( sbArrayFlags );
+	return result;
+}
+
+int ecps_Restore( ECPS* ecps, const uint8_t* snapshot, size_t size )
+{
+	assert( ecps != NULL );
+	assert( snapshot != NULL );
+	assert( !( ecps->isRunningProcess ) );
+
+	// check that everything matches and is in bounds before changing anything
+	SnapshotHeader header;
+	size_t arraysStart;
+	size_t directoryStart;
+	size_t idSetStart;
+	if( checkSnapshot( ecps, snapshot, size, &header, &arraysStart, &directoryStart, &idSetStart ) < 0 ) {
+		return -1;
+	}
+
+	// this is checked last since reading it in changes the id set
+	if( idSet_ReadSnapshot( &( ecps->idSet ), snapshot + idSetStart, size - idSetStart ) == 0 ) {
+		llog( LOG_ERROR, "Snapshot id set isn't valid." );
+		return -1;
+	}
+
+	// empty out every array, any that aren't in the snapshot stay that way
+	for( size_t i = 0; i < sb_Count( ecps->componentData.sbComponentArrays ); ++i ) {
+		ecps->componentData.sbComponentArrays[i].count = 0;
+	}
+
+	// the snapshot arrays are matched up by their flags, when restoring into the world the snapshot was taken from
+	//  they'll usually be in the same spots
+	bool sameArrays = true;
+	sb_Clear( ecps->sbBatchArrays );
+	size_t pos = arraysStart;
+	for( uint32_t i = 0; i < header.numArrays; ++i ) {
+		SnapshotArrayHeader arrayHeader;
+		memcpy( &arrayHeader, snapshot + pos, sizeof( arrayHeader ) );
+		pos += snapshotAlign( sizeof( arrayHeader ) );
+
+		uint32_t arrayIdx = createOrFindPackagedArray( ecps, &( arrayHeader.flags ) );
+		sb_Push( ecps->sbBatchArrays, arrayIdx );
+		sameArrays = sameArrays && ( arrayIdx == i );
+
+		readSnapshotArray( ecps, arrayIdx, snapshot + pos, (size_t)arrayHeader.count, arrayHeader.columnar != 0 );
+		pos += snapshotArrayDataSize( &( ecps->componentData.sbComponentArrays[arrayIdx] ), (size_t)arrayHeader.count );
+	}
+
+	growEntityDirectory( ecps, header.numDirectoryEntries );
+	EntityDirectoryEntry* directory = ecps->componentData.sbEntityDirectory;
+	if( header.numDirectoryEntries > 0 ) {
+		memcpy( directory, snapshot + directoryStart, sizeof( EntityDirectoryEntry ) * header.numDirectoryEntries );
+	}
+	if( !sameArrays ) {
+		for( uint32_t i = 0; i < header.numDirectoryEntries; ++i ) {
+			if( directory[i].packedArrayIdx >= 0 ) {
+				directory[i].packedArrayIdx = (int32_t)ecps->sbBatchArrays[directory[i].packedArrayIdx];
+			}
+		}
+	}
+	for( size_t i = header.numDirectoryEntries; i < sb_Count( directory ); ++i ) {
+		directory[i] = EMPTY_EDE;
+	}
+
+	return 0;
+}
+
+// ***** Churn benchmark
+typedef struct {
+	float x, y;
+} ChurnBenchmarkVec;
+
+static ComponentID churnPosCompID;
+static ComponentID churnVelCompID;
+
+static void churnBenchmarkProc( ECPS* ecps, const Entity* entity )
+{
+	ChurnBenchmarkVec* pos;
+	ChurnBenchmarkVec* vel;
+	ecps_GetComponentFromEntity( entity, churnPosCompID, (void**)&pos );
+	ecps_GetComponentFromEntity( entity, churnVelCompID, (void**)&vel );
+	pos->x += vel->x * 0.016f;
+	pos->y += vel->y * 0.016f;
+}
+
+static void churnBenchmarkSpawn( ECPS* ecps, RandomGroup* rand, EntityID** sbLiveIDs, uint32_t count )
+{
+	for( uint32_t i = 0; i < count; ++i ) {
+		ChurnBenchmarkVec pos = { rand_GetRangeFloat( rand, 0.0f, 800.0f ), rand_GetRangeFloat( rand, 0.0f, 600.0f ) };
+		ChurnBenchmarkVec vel = { rand_GetRangeFloat( rand, -10.0f, 10.0f ), rand_GetRangeFloat( rand, -10.0f, 10.0f ) };
+		EntityID id = ecps_CreateEntity( ecps, 2, churnPosCompID, &pos, churnVelCompID, &vel );
+		if( id != INVALID_ENTITY_ID ) {
+			sb_Push( (*sbLiveIDs), id );
+		}
+	}
+}
+
+static void churnBenchmarkDestroy( ECPS* ecps, RandomGroup* rand, EntityID** sbLiveIDs, uint32_t count )
+{
+	for( uint32_t i = 0; ( i < count ) && ( sb_Count( (*sbLiveIDs) ) > 0 ); ++i ) {
+		size_t idx = (size_t)rand_GetRangeS32( rand, 0, (int32_t)sb_Count( (*sbLiveIDs) ) - 1 );
+		ecps_DestroyEntityByID( ecps, (*sbLiveIDs)[idx] );
+		(*sbLiveIDs)[idx] = sb_Last( (*sbLiveIDs) );
+		sb_Pop( (*sbLiveIDs) );
+	}
+}
+
+static size_t churnBenchmarkSlotCount( ECPS* ecps )
+{
+	size_t slots = 0;
+	for( size_t i = 0; i < sb_Count( ecps->componentData.sbComponentArrays ); ++i ) {
+		PackagedComponentArray* pca = &( ecps->componentData.sbComponentArrays[i] );
+		slots += pca->count;
+	}
+	return slots;
+}
+
+// runs the process a number of times and returns the average time in milliseconds
+static double churnBenchmarkTimeProcess( ECPS* ecps, Process* process, int runs )
+{
+	// flush out anything waiting in the command buffer first
+	ecps_RunProcess( ecps, process );
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( int i = 0; i < runs; ++i ) {
+		ecps_RunProcess( ecps, process );
+	}
+	return test_MSSince( start ) / (double)runs;
+}
+
+// spawns and destroys entities for a while, the packaged array has to stay packed and every entity has to keep its
+//  own data when others are moved into the slots that were freed up
+static void churnTest( void )
+{
+	ECPS ecps;
+	Process process;
+	RandomGroup rand;
+	EntityID* sbLiveIDs = NULL;
+	float* sbLiveValues = NULL;
+
+	rand_Seed( &rand, 42 );
+
+	ecps_StartInitialization( &ecps );
+	churnPosCompID = ecps_AddComponentType( &ecps, "BM_POS", sizeof( ChurnBenchmarkVec ), NULL );
+	churnVelCompID = ecps_AddComponentType( &ecps, "BM_VEL", sizeof( ChurnBenchmarkVec ), NULL );
+	ecps_FinishInitialization( &ecps );
+	ecps_CreateProcess( &ecps, "BM_CHURN", NULL, churnBenchmarkProc, NULL, &process, 2, churnPosCompID, churnVelCompID );
+
+	bool dataMatches = true;
+	for( uint32_t frame = 0; frame < 20; ++frame ) {
+		for( uint32_t i = 0; i < 50; ++i ) {
+			float value = (float)( ( frame * 50 ) + i );
+			ChurnBenchmarkVec pos = { value, -value };
+			ChurnBenchmarkVec vel = { 0.0f, 0.0f };
+			EntityID id = ecps_CreateEntity( &ecps, 2, churnPosCompID, &pos, churnVelCompID, &vel );
+			if( id != INVALID_ENTITY_ID ) {
+				sb_Push( sbLiveIDs, id );
+				sb_Push( sbLiveValues, value );
+			}
+		}
+
+		for( uint32_t i = 0; ( i < 40 ) && ( sb_Count( sbLiveIDs ) > 0 ); ++i ) {
+			size_t idx = (size_t)rand_GetRangeS32( &rand, 0, (int32_t)sb_Count( sbLiveIDs ) - 1 );
+			ecps_DestroyEntityByID( &ecps, sbLiveIDs[idx] );
+			sbLiveIDs[idx] = sb_Last( sbLiveIDs );
+			sbLiveValues[idx] = sb_Last( sbLiveValues );
+			sb_Pop( sbLiveIDs );
+			sb_Pop( sbLiveValues );
+		}
+
+		// the first run applies anything still waiting in the command buffer
+		ecps_RunProcess( &ecps, &process );
+		ecps_RunProcess( &ecps, &process );
+		TEST_CHECK( process.stats.lastEntitiesVisited == sb_Count( sbLiveIDs ), "churned process visits only the live entities" );
+		TEST_CHECK( churnBenchmarkSlotCount( &ecps ) == sb_Count( sbLiveIDs ), "churned packaged array has no empty slots" );
+
+		for( size_t i = 0; i < sb_Count( sbLiveIDs ); ++i ) {
+			const ChurnBenchmarkVec* pos;
+			dataMatches = dataMatches && ecps_ReadComponentFromEntityByID( &ecps, sbLiveIDs[i], churnPosCompID, (const void**)&pos ) &&
+				( pos->x == sbLiveValues[i] ) && ( pos->y == -sbLiveValues[i] );
+		}
+	}
+	TEST_CHECK( dataMatches, "churned entities keep their own data" );
+
+	sb_Release( sbLiveIDs );
+	sb_Release( sbLiveValues );
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+void ecps_RunChurnBenchmark( uint32_t peakEntities, uint32_t liveEntities, uint32_t churnPerFrame, uint32_t numFrames )
+{
+	assert( liveEntities <= peakEntities );
+
+	llog( LOG_INFO, "ECPS churn benchmark: peak of %u entities, %u live, %u spawned and destroyed each frame for %u frames",
+		peakEntities, liveEntities, churnPerFrame, numFrames );
+
+	ECPS ecps;
+	Process process;
+	RandomGroup rand;
+	EntityID* sbLiveIDs = NULL;
+	const int TIMING_RUNS = 20;
+
+	rand_Seed( &rand, 42 );
+
+	ecps_StartInitialization( &ecps );
+	churnPosCompID = ecps_AddComponentType( &ecps, "BM_POS", sizeof( ChurnBenchmarkVec ), NULL );
+	churnVelCompID = ecps_AddComponentType( &ecps, "BM_VEL", sizeof( ChurnBenchmarkVec ), NULL );
+	ecps_FinishInitialization( &ecps );
+	ecps_CreateProcess( &ecps, "BM_CHURN", NULL, churnBenchmarkProc, NULL, &process, 2, churnPosCompID, churnVelCompID );
+
+	churnBenchmarkSpawn( &ecps, &rand, &sbLiveIDs, liveEntities );
+	double liveMS = churnBenchmarkTimeProcess( &ecps, &process, TIMING_RUNS );
+	llog( LOG_INFO, "  %u live: %.3f ms per run, %u slots", (uint32_t)sb_Count( sbLiveIDs ), liveMS, (uint32_t)churnBenchmarkSlotCount( &ecps ) );
+
+	churnBenchmarkSpawn( &ecps, &rand, &sbLiveIDs, peakEntities - liveEntities );
+	double peakMS = churnBenchmarkTimeProcess( &ecps, &process, TIMING_RUNS );
+	llog( LOG_INFO, "  %u live at peak: %.3f ms per run, %u slots", (uint32_t)sb_Count( sbLiveIDs ), peakMS, (uint32_t)churnBenchmarkSlotCount( &ecps ) );
+
+	churnBenchmarkDestroy( &ecps, &rand, &sbLiveIDs, peakEntities - liveEntities );
+	double afterMS = churnBenchmarkTimeProcess( &ecps, &process, TIMING_RUNS );
+	llog( LOG_INFO, "  %u live after destroying: %.3f ms per run, %u slots", (uint32_t)sb_Count( sbLiveIDs ), afterMS, (uint32_t)churnBenchmarkSlotCount( &ecps ) );
+
+	// each frame destroys and spawns the same number of entities and then runs the process, which also runs
+	//  the commands from the frame before
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint32_t i = 0; i < numFrames; ++i ) {
+		churnBenchmarkDestroy( &ecps, &rand, &sbLiveIDs, churnPerFrame );
+		churnBenchmarkSpawn( &ecps, &rand, &sbLiveIDs, churnPerFrame );
+		ecps_RunProcess( &ecps, &process );
+	}
+	double churnMS = test_MSSince( start );
+	llog( LOG_INFO, "  churning: %.3f ms per frame, including spawning and destroying", numFrames > 0 ? ( churnMS / (double)numFrames ) : 0.0 );
+
+	double steadyMS = churnBenchmarkTimeProcess( &ecps, &process, TIMING_RUNS );
+	llog( LOG_INFO, "  %u live after churning: %.3f ms per run, %u slots", (uint32_t)sb_Count( sbLiveIDs ), steadyMS, (uint32_t)churnBenchmarkSlotCount( &ecps ) );
+
+	sb_Release( sbLiveIDs );
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+// ***** Layout benchmark
+//  roughly matches the general components, with a process that only touches the position
+typedef struct {
+	ChurnBenchmarkVec currPos;
+	ChurnBenchmarkVec futurePos;
+} LayoutBenchmarkPos;
+
+typedef struct {
+	float currClr[4];
+	float futureClr[4];
+} LayoutBenchmarkColor;
+
+typedef struct {
+	ChurnBenchmarkVec currScale;
+	ChurnBenchmarkVec futureScale;
+} LayoutBenchmarkScale;
+
+typedef struct {
+	int img;
+	int8_t depth;
+	uint32_t camFlags;
+} LayoutBenchmarkSprite;
+
+static ComponentID layoutPosCompID;
+static ComponentID layoutClrCompID;
+static ComponentID layoutScaleCompID;
+static ComponentID layoutSpriteCompID;
+
+static void layoutBenchmarkLerp( LayoutBenchmarkPos* pos )
+{
+	pos->currPos.x += ( pos->futurePos.x - pos->currPos.x ) * 0.25f;
+	pos->currPos.y += ( pos->futurePos.y - pos->currPos.y ) * 0.25f;
+}
+
+static void layoutBenchmarkProc( ECPS* ecps, const Entity* entity )
+{
+	LayoutBenchmarkPos* pos;
+	ecps_GetComponentFromEntity( entity, layoutPosCompID, (void**)&pos );
+	layoutBenchmarkLerp( pos );
+}
+
+static void layoutBenchmarkChunk( ECPS* ecps, const EntityChunk* chunk )
+{
+	uint8_t* first;
+	size_t stride;
+	ecps_GetChunkComponent( chunk, layoutPosCompID, (void**)&first, &stride );
+
+	if( stride == sizeof( LayoutBenchmarkPos ) ) {
+		// a plain array, which the compiler can vectorize
+		LayoutBenchmarkPos* positions = (LayoutBenchmarkPos*)first;
+		for( size_t i = 0; i < chunk->count; ++i ) {
+			layoutBenchmarkLerp( &( positions[i] ) );
+		}
+	} else {
+		for( size_t i = 0; i < chunk->count; ++i ) {
+			layoutBenchmarkLerp( (LayoutBenchmarkPos*)( first + ( i * stride ) ) );
+		}
+	}
+}
+
+static void layoutBenchmarkStartPos( RandomGroup* rand, LayoutBenchmarkPos* outPos )
+{
+	outPos->currPos.x = rand_GetRangeFloat( rand, 0.0f, 800.0f );
+	outPos->currPos.y = rand_GetRangeFloat( rand, 0.0f, 600.0f );
+	outPos->futurePos.x = rand_GetRangeFloat( rand, 0.0f, 800.0f );
+	outPos->futurePos.y = rand_GetRangeFloat( rand, 0.0f, 600.0f );
+}
+
+static double layoutBenchmarkChecksum( ECPS* ecps, EntityID* ids, uint32_t numEntities )
+{
+	double sum = 0.0;
+	for( uint32_t i = 0; i < numEntities; ++i ) {
+		LayoutBenchmarkPos* pos;
+		if( ecps_GetComponentFromEntityByID( ecps, ids[i], layoutPosCompID, (void**)&pos ) ) {
+			sum += pos->currPos.x + pos->currPos.y;
+		}
+	}
+	return sum;
+}
+
+static void runLayoutBenchmark( bool columnar, uint32_t numEntities, uint32_t runs, double* outProcMS, double* outChunkMS, double* outChecksum )
+{
+	ECPS ecps;
+	Process process;
+	Process chunkProcess;
+	RandomGroup rand;
+	EntityID* ids = mem_Allocate( sizeof( EntityID ) * numEntities );
+	assert( ids != NULL );
+
+	rand_Seed( &rand, 1234 );
+
+	ecps_StartInitialization( &ecps );
+	layoutPosCompID = ecps_AddComponentType( &ecps, "BM_POS", sizeof( LayoutBenchmarkPos ), NULL );
+	layoutClrCompID = ecps_AddComponentType( &ecps, "BM_CLR", sizeof( LayoutBenchmarkColor ), NULL );
+	layoutScaleCompID = ecps_AddComponentType( &ecps, "BM_SCALE", sizeof( LayoutBenchmarkScale ), NULL );
+	layoutSpriteCompID = ecps_AddComponentType( &ecps, "BM_SPRITE", sizeof( LayoutBenchmarkSprite ), NULL );
+	ecps_UseColumnarLayout( &ecps, columnar );
+	ecps_FinishInitialization( &ecps );
+	ecps_CreateProcess( &ecps, "BM_LERP", NULL, layoutBenchmarkProc, NULL, &process, 1, layoutPosCompID );
+	ecps_CreateChunkProcess( &ecps, "BM_LERP_CHUNK", NULL, layoutBenchmarkChunk, NULL, &chunkProcess, 1, layoutPosCompID );
+
+	// the ecps starts out putting off changes until the first process is run
+	ecps_RunProcess( &ecps, &process );
+
+	for( uint32_t i = 0; i < numEntities; ++i ) {
+		LayoutBenchmarkPos pos;
+		layoutBenchmarkStartPos( &rand, &pos );
+		ids[i] = ecps_CreateEntity( &ecps, 4, layoutPosCompID, &pos, layoutClrCompID, NULL, layoutScaleCompID, NULL, layoutSpriteCompID, NULL );
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint32_t i = 0; i < runs; ++i ) {
+		ecps_RunProcess( &ecps, &process );
+	}
+	(*outProcMS) = test_MSSince( start ) / (double)runs;
+
+	start = SDL_GetPerformanceCounter( );
+	for( uint32_t i = 0; i < runs; ++i ) {
+		ecps_RunProcess( &ecps, &chunkProcess );
+	}
+	(*outChunkMS) = test_MSSince( start ) / (double)runs;
+
+	(*outChecksum) = layoutBenchmarkChecksum( &ecps, ids, numEntities );
+
+	mem_Release( ids );
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+void ecps_RunLayoutBenchmark( uint32_t numEntities, uint32_t runs )
+{
+	assert( runs > 0 );
+
+	llog( LOG_INFO, "ECPS layout benchmark: lerping the position of %u entities, %u runs each", numEntities, runs );
+
+	double interleavedProcMS, interleavedChunkMS, interleavedChecksum;
+	runLayoutBenchmark( false, numEntities, runs, &interleavedProcMS, &interleavedChunkMS, &interleavedChecksum );
+	llog( LOG_INFO, "  Interleaved, per entity: %.3f ms per run", interleavedProcMS );
+	llog( LOG_INFO, "  Interleaved, chunks: %.3f ms per run", interleavedChunkMS );
+
+	double columnarProcMS, columnarChunkMS, columnarChecksum;
+	runLayoutBenchmark( true, numEntities, runs, &columnarProcMS, &columnarChunkMS, &columnarChecksum );
+	llog( LOG_INFO, "  Columnar, per entity: %.3f ms per run", columnarProcMS );
+	llog( LOG_INFO, "  Columnar, chunks: %.3f ms per run", columnarChunkMS );
+
+	TEST_CHECK( interleavedChecksum == columnarChecksum, "interleaved and columnar layouts end up with the same positions" );
+}
+
+// both layouts and both kinds of process have to end up with the same positions as lerping them directly, each
+//  position is lerped once by the per entity process and once by the chunk process every run
+static void layoutTest( void )
+{
+	const uint32_t NUM_ENTITIES = 300;
+	const uint32_t RUNS = 3;
+
+	RandomGroup rand;
+	rand_Seed( &rand, 1234 );
+	double expectedChecksum = 0.0;
+	for( uint32_t i = 0; i < NUM_ENTITIES; ++i ) {
+		LayoutBenchmarkPos pos;
+		layoutBenchmarkStartPos( &rand, &pos );
+		for( uint32_t r = 0; r < RUNS * 2; ++r ) {
+			layoutBenchmarkLerp( &pos );
+		}
+		expectedChecksum += pos.currPos.x + pos.currPos.y;
+	}
+
+	double procMS, chunkMS, checksum;
+	runLayoutBenchmark( false, NUM_ENTITIES, RUNS, &procMS, &chunkMS, &checksum );
+	TEST_CHECK( checksum == expectedChecksum, "interleaved layout processes lerp every position" );
+	runLayoutBenchmark( true, NUM_ENTITIES, RUNS, &procMS, &chunkMS, &checksum );
+	TEST_CHECK( checksum == expectedChecksum, "columnar layout processes lerp every position" );
+}
+
+// ***** Command buffer benchmark
+//  one process spawns a bunch of entities in a few different arrays and another destroys them all, both through
+//  the command buffer
+static ComponentID cmdSpawnerCompID;
+static ComponentID cmdPosCompID;
+static ComponentID cmdVelCompID;
+static ComponentID cmdTagCompID;
+static uint32_t cmdBenchmarkSpawnCount;
+static Uint64 cmdBenchmarkPostTime;
+
+static void cmdBenchmarkSpawn( ECPS* ecps, const Entity* entity )
+{
+	for( uint32_t i = 0; i < cmdBenchmarkSpawnCount; ++i ) {
+		ChurnBenchmarkVec pos = { (float)i, 0.0f };
+		ChurnBenchmarkVec vel = { 1.0f, 1.0f };
+		switch( i % 3 ) {
+		case 0:
+			ecps_CreateEntity( ecps, 1, cmdPosCompID, &pos );
+			break;
+		case 1:
+			ecps_CreateEntity( ecps, 2, cmdPosCompID, &pos, cmdVelCompID, &vel );
+			break;
+		default:
+			ecps_CreateEntity( ecps, 3, cmdPosCompID, &pos, cmdVelCompID, &vel, cmdTagCompID, NULL );
+			break;
+		}
+	}
+}
+
+static void cmdBenchmarkDestroy( ECPS* ecps, const Entity* entity )
+{
+	ecps_DestroyEntity( ecps, entity );
+}
+
+// the post process is run right before the command buffer
+static void cmdBenchmarkPost( ECPS* ecps )
+{
+	cmdBenchmarkPostTime = SDL_GetPerformanceCounter( );
+}
+
+// creates the ecps with a single spawner entity, ready for the processes to be run
+static void cmdBenchmarkSetup( ECPS* ecps, Process* spawnProcess, Process* destroyProcess )
+{
+	ecps_StartInitialization( ecps );
+	cmdSpawnerCompID = ecps_AddComponentType( ecps, "BM_SPAWNER", 0, NULL );
+	cmdPosCompID = ecps_AddComponentType( ecps, "BM_POS", sizeof( ChurnBenchmarkVec ), NULL );
+	cmdVelCompID = ecps_AddComponentType( ecps, "BM_VEL", sizeof( ChurnBenchmarkVec ), NULL );
+	cmdTagCompID = ecps_AddComponentType( ecps, "BM_TAG", 0, NULL );
+	ecps_FinishInitialization( ecps );
+	ecps_CreateProcess( ecps, "BM_SPAWN", NULL, cmdBenchmarkSpawn, cmdBenchmarkPost, spawnProcess, 1, cmdSpawnerCompID );
+	ecps_CreateProcess( ecps, "BM_DESTROY", NULL, cmdBenchmarkDestroy, cmdBenchmarkPost, destroyProcess, 1, cmdPosCompID );
+
+	// the ecps starts out putting off changes until the first process is run
+	ecps_RunProcess( ecps, spawnProcess );
+	ecps_CreateEntity( ecps, 1, cmdSpawnerCompID, NULL );
+}
+
+void ecps_RunCommandBufferBenchmark( uint32_t numEntities, uint32_t runs )
+{
+	assert( runs > 0 );
+
+	ECPS ecps;
+	Process spawnProcess;
+	Process destroyProcess;
+	cmdBenchmarkSetup( &ecps, &spawnProcess, &destroyProcess );
+
+	llog( LOG_INFO, "ECPS command buffer benchmark: spawning and destroying %u entities, %u runs", numEntities, runs );
+
+	cmdBenchmarkSpawnCount = numEntities;
+	double bestSpawnMS = 0.0;
+	double bestDestroyMS = 0.0;
+	for( uint32_t i = 0; i < runs; ++i ) {
+		ecps_RunProcess( &ecps, &spawnProcess );
+		bestSpawnMS = test_Fastest( bestSpawnMS, test_MSSince( cmdBenchmarkPostTime ), i );
+		TEST_CHECK( churnBenchmarkSlotCount( &ecps ) == ( numEntities + 1 ), "every create in the command buffer applied" );
+
+		ecps_RunProcess( &ecps, &destroyProcess );
+		bestDestroyMS = test_Fastest( bestDestroyMS, test_MSSince( cmdBenchmarkPostTime ), i );
+		TEST_CHECK( churnBenchmarkSlotCount( &ecps ) == 1, "every destroy in the command buffer applied" );
+	}
+
+	llog( LOG_INFO, "  Applying creates: %.3f ms, %.1f ns per entity", bestSpawnMS, ( bestSpawnMS * 1000000.0 ) / (double)numEntities );
+	llog( LOG_INFO, "  Applying destroys: %.3f ms, %.1f ns per entity", bestDestroyMS, ( bestDestroyMS * 1000000.0 ) / (double)numEntities );
+
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+// entities created from inside a process have to end up with the components and data they were created with, and
+//  the ones destroyed from inside a process have to be gone without taking anything else with them
+static void commandBufferTest( void )
+{
+	ECPS ecps;
+	Process spawnProcess;
+	Process destroyProcess;
+	cmdBenchmarkSetup( &ecps, &spawnProcess, &destroyProcess );
+
+	uint8_t seen[100];
+	memset( seen, 0, sizeof( seen ) );
+	cmdBenchmarkSpawnCount = SDL_arraysize( seen );
+	ecps_RunProcess( &ecps, &spawnProcess );
+	TEST_CHECK( churnBenchmarkSlotCount( &ecps ) == ( SDL_arraysize( seen ) + 1 ), "every create in the command buffer applied" );
+
+	bool componentsMatch = true;
+	for( EntityID id = idSet_GetFirstValidID( &( ecps.idSet ) ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &( ecps.idSet ), id ) ) {
+		const ChurnBenchmarkVec* pos;
+		if( !ecps_ReadComponentFromEntityByID( &ecps, id, cmdPosCompID, (const void**)&pos ) ) {
+			componentsMatch = componentsMatch && ecps_DoesEntityHaveComponentByID( &ecps, id, cmdSpawnerCompID );
+			continue;
+		}
+
+		uint32_t i = (uint32_t)pos->x;
+		componentsMatch = componentsMatch && ( i < SDL_arraysize( seen ) ) &&
+			( ecps_DoesEntityHaveComponentByID( &ecps, id, cmdVelCompID ) == ( ( i % 3 ) != 0 ) ) &&
+			( ecps_DoesEntityHaveComponentByID( &ecps, id, cmdTagCompID ) == ( ( i % 3 ) == 2 ) );
+		if( i < SDL_arraysize( seen ) ) {
+			++seen[i];
+		}
+	}
+	bool allSeenOnce = true;
+	for( size_t i = 0; i < SDL_arraysize( seen ); ++i ) {
+		allSeenOnce = allSeenOnce && ( seen[i] == 1 );
+	}
+	TEST_CHECK( componentsMatch && allSeenOnce, "entities created in the command buffer have the right components" );
+
+	ecps_RunProcess( &ecps, &destroyProcess );
+	TEST_CHECK( churnBenchmarkSlotCount( &ecps ) == 1, "every destroy in the command buffer applied" );
+	EntityID spawnerID = idSet_GetFirstValidID( &( ecps.idSet ) );
+	TEST_CHECK( ( spawnerID != INVALID_ENTITY_ID ) && ( idSet_GetNextValidID( &( ecps.idSet ), spawnerID ) == INVALID_ENTITY_ID ) &&
+		ecps_DoesEntityHaveComponentByID( &ecps, spawnerID, cmdSpawnerCompID ), "only the spawner is left after destroying" );
+
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+// ***** Snapshot benchmark
+//  uses the churn components, with some entities destroyed so there are holes in the ids
+static ComponentID snapshotTagCompID;
+
+static void snapshotBenchmarkInit( ECPS* ecps, Process* process )
+{
+	ecps_StartInitialization( ecps );
+	churnPosCompID = ecps_AddComponentType( ecps, "BM_POS", sizeof( ChurnBenchmarkVec ), NULL );
+	churnVelCompID = ecps_AddComponentType( ecps, "BM_VEL", sizeof( ChurnBenchmarkVec ), NULL );
+	snapshotTagCompID = ecps_AddComponentType( ecps, "BM_TAG", sizeof( uint32_t ), NULL );
+	ecps_FinishInitialization( ecps );
+	ecps_CreateProcess( ecps, "BM_MOVE", NULL, churnBenchmarkProc, NULL, process, 2, churnPosCompID, churnVelCompID );
+
+	// the ecps starts out putting off changes until the first process is run
+	ecps_RunProcess( ecps, process );
+}
+
+// the live ids aren't tracked through restores, so get them from the ecps instead
+static void snapshotBenchmarkCollectIDs( ECPS* ecps, EntityID** sbLiveIDs )
+{
+	sb_Clear( (*sbLiveIDs) );
+	for( EntityID id = idSet_GetFirstValidID( &( ecps->idSet ) ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &( ecps->idSet ), id ) ) {
+		sb_Push( (*sbLiveIDs), id );
+	}
+}
+
+static double snapshotBenchmarkChecksum( ECPS* ecps )
+{
+	double sum = (double)churnBenchmarkSlotCount( ecps );
+	for( EntityID id = idSet_GetFirstValidID( &( ecps->idSet ) ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &( ecps->idSet ), id ) ) {
+		ChurnBenchmarkVec* pos;
+		if( ecps_GetComponentFromEntityByID( ecps, id, churnPosCompID, (void**)&pos ) ) {
+			sum += (double)id + pos->x + pos->y;
+		}
+		uint32_t* tag;
+		if( ecps_GetComponentFromEntityByID( ecps, id, snapshotTagCompID, (void**)&tag ) ) {
+			sum += (double)( *tag );
+		}
+	}
+	return sum;
+}
+
+typedef struct {
+	double snapshotMS;
+	size_t snapshotSize;
+	uint32_t liveCount;
+	double restoreMS;
+	double firstOtherMS;
+	double otherMS;
+} SnapshotBenchmarkResults;
+
+// the restores are checked against the checksum of the ecps when the snapshot was taken, the times are the best of
+//  the runs
+static void runSnapshotBenchmark( uint32_t numEntities, uint32_t runs, SnapshotBenchmarkResults* outResults )
+{
+	assert( runs > 0 );
+
+	ECPS ecps;
+	ECPS otherECPS;
+	Process process;
+	Process otherProcess;
+	RandomGroup rand;
+	EntityID* sbLiveIDs = NULL;
+	uint8_t* sbSnapshot = NULL;
+
+	rand_Seed( &rand, 99 );
+
+	snapshotBenchmarkInit( &ecps, &process );
+	snapshotBenchmarkInit( &otherECPS, &otherProcess );
+
+	// a quarter of the entities are tagged so there's more than one packaged array, and a fifth of them are
+	//  destroyed so the ids and arrays have been reused
+	churnBenchmarkSpawn( &ecps, &rand, &sbLiveIDs, numEntities + ( numEntities / 5 ) );
+	for( size_t i = 0; i < sb_Count( sbLiveIDs ); i += 4 ) {
+		uint32_t tag = (uint32_t)i;
+		ecps_AddComponentToEntityByID( &ecps, sbLiveIDs[i], snapshotTagCompID, &tag );
+	}
+	ecps_RunProcess( &ecps, &process );
+	churnBenchmarkDestroy( &ecps, &rand, &sbLiveIDs, numEntities / 5 );
+	ecps_RunProcess( &ecps, &process );
+
+	double expected = snapshotBenchmarkChecksum( &ecps );
+
+	for( uint32_t i = 0; i < runs; ++i ) {
+		Uint64 start = SDL_GetPerformanceCounter( );
+		outResults->snapshotSize = ecps_Snapshot( &ecps, &sbSnapshot );
+		outResults->snapshotMS = test_Fastest( outResults->snapshotMS, test_MSSince( start ), i );
+	}
+
+	// change things before each restore so it has something to undo
+	for( uint32_t i = 0; i < runs; ++i ) {
+		churnBenchmarkDestroy( &ecps, &rand, &sbLiveIDs, numEntities / 10 );
+		churnBenchmarkSpawn( &ecps, &rand, &sbLiveIDs, numEntities / 10 );
+		ecps_RunProcess( &ecps, &process );
+		ecps_RunProcess( &ecps, &process );
+
+		Uint64 start = SDL_GetPerformanceCounter( );
+		int result = ecps_Restore( &ecps, sbSnapshot, sb_Count( sbSnapshot ) );
+		outResults->restoreMS = test_Fastest( outResults->restoreMS, test_MSSince( start ), i );
+
+		TEST_CHECK( result == 0, "snapshot restored into the same ecps" );
+		TEST_CHECK( snapshotBenchmarkChecksum( &ecps ) == expected, "entities restored into the same ecps match the snapshot" );
+		snapshotBenchmarkCollectIDs( &ecps, &sbLiveIDs );
+	}
+
+	// the first restore into the other ecps has to create and size everything, after that it shouldn't allocate
+	Uint64 start = SDL_GetPerformanceCounter( );
+	int result = ecps_Restore( &otherECPS, sbSnapshot, sb_Count( sbSnapshot ) );
+	outResults->firstOtherMS = test_MSSince( start );
+	TEST_CHECK( result == 0, "snapshot restored into another ecps" );
+	TEST_CHECK( snapshotBenchmarkChecksum( &otherECPS ) == expected, "entities restored into another ecps match the snapshot" );
+
+	for( uint32_t i = 0; i < runs; ++i ) {
+		ecps_RunProcess( &otherECPS, &otherProcess );
+
+		start = SDL_GetPerformanceCounter( );
+		result = ecps_Restore( &otherECPS, sbSnapshot, sb_Count( sbSnapshot ) );
+		outResults->otherMS = test_Fastest( outResults->otherMS, test_MSSince( start ), i );
+		TEST_CHECK( result == 0, "snapshot restored into another ecps again" );
+	}
+	TEST_CHECK( snapshotBenchmarkChecksum( &otherECPS ) == expected, "entities restored into another ecps again match the snapshot" );
+
+	outResults->liveCount = (uint32_t)churnBenchmarkSlotCount( &ecps );
+
+	sb_Release( sbSnapshot );
+	sb_Release( sbLiveIDs );
+	ecps_DestroyAllEntities( &otherECPS );
+	ecps_CleanUp( &otherECPS );
+	ecps_DestroyAllEntities( &ecps );
+	ecps_CleanUp( &ecps );
+}
+
+void ecps_RunSnapshotBenchmark( uint32_t numEntities, uint32_t runs )
+{
+	llog( LOG_INFO, "ECPS snapshot benchmark: %u entities, %u runs", numEntities, runs );
+
+	SnapshotBenchmarkResults results;
+	memset( &results, 0, sizeof( results ) );
+	runSnapshotBenchmark( numEntities, runs, &results );
+
+	llog( LOG_INFO, "  Snapshot: %.3f ms, %u bytes, %.1f bytes per entity", results.snapshotMS, (uint32_t)results.snapshotSize, (double)results.snapshotSize / (double)results.liveCount );
+	llog( LOG_INFO, "  Restore into the same ecps: %.3f ms", results.restoreMS );
+	llog( LOG_INFO, "  Restore into another ecps: %.3f ms the first time, %.3f ms after that", results.firstOtherMS, results.otherMS );
+}
+
+// restoring a few hundred entities has to undo the changes made after the snapshot, and restoring into another ecps
+//  has to give the same entities
+static void snapshotTest( void )
+{
+	SnapshotBenchmarkResults results;
+	memset( &results, 0, sizeof( results ) );
+	runSnapshotBenchmark( 500, 3, &results );
+}
+
+// ***** Change filter benchmark
+//  copies positions out of the ecps, like something keeping a separate copy of the world up to date would
+static ChurnBenchmarkVec* changeFullMirror;
+static ChurnBenchmarkVec* changeFilteredMirror;
+
+static void changeBenchmarkSync( const EntityChunk* chunk, ChurnBenchmarkVec* mirror )
+{
+	const uint8_t* pos;
+	size_t stride;
+	ecps_ReadChunkComponent( chunk, churnPosCompID, (const void**)&pos, &stride );
+	for( size_t i = 0; i < chunk->count; ++i ) {
+		mirror[idSet_GetIndex( ecps_GetChunkEntityID( chunk, i ) )] = *( (const ChurnBenchmarkVec*)( pos + ( i * stride ) ) );
+	}
+}
+
+static void changeBenchmarkFullSync( ECPS* ecps, const EntityChunk* chunk )
+{
+	changeBenchmarkSync( chunk, changeFullMirror );
+}
+
+static void changeBenchmarkFilteredSync( ECPS* ecps, const EntityChunk* chunk )
+{
+	changeBenchmarkSync( chunk, changeFilteredMirror );
+}
+
+// changes count entities, every step entities starting at the first one
+static void changeBenchmarkMove( ECPS* ecps, EntityID* ids, uint32_t count, uint32_t step )
+{
+	for( uint32_t i = 0; i < count; ++i ) {
+		ChurnBenchmarkVec* pos;
+		if( ecps_GetComponentFromEntityByID( ecps, ids[i * step], churnPosCompID, (void**)&pos ) ) {
+			pos->x += 1.0f;
+		}
+	}
+}
+
+static bool changeBenchmarkMirrorMatches( ECPS* ecps, EntityID* ids, uint32_t numEntities )
+{
+	for( uint32_t i = 0; i < numEntities; ++i ) {
+		const ChurnBenchmarkVec* pos;
+		if( !ecps_ReadComponentFromEntityByID( ecps, ids[i], churnPosCompID, (const void**)&pos ) ) {
+			return false;
+		}
+		const ChurnBenchmarkVec* mirrored = &( changeFilteredMirror[idSet_GetIndex( ids[i] )] );
+		if( ( pos->x != mirrored->x ) || ( pos->y != mirrored->y ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// creates numEntities entities and gets them all copied into both mirrors once
+static void changeBenchmarkSetup( ECPS* ecps, Process* fullProcess, Process* filteredProcess, EntityID** sbIDs, uint32_t numEntities )
+{
+	RandomGroup rand;
+	rand_Seed( &rand, 7 );
+
+	ecps_StartInitialization( ecps );
+	churnPosCompID = ecps_AddComponentType( ecps, "BM_POS", sizeof( ChurnBenchmarkVec ), NULL );
+	churnVelCompID = ecps_AddComponentType( ecps, "BM_VEL", sizeof( ChurnBenchmarkVec ), NULL );
+	ecps_FinishInitialization( ecps );
+	ecps_CreateChunkProcess( ecps, "BM_FULL_SYNC", NULL, changeBenchmarkFullSync, NULL, fullProcess, 1, churnPosCompID );
+	ecps_CreateChunkProcess( ecps, "BM_FILTERED_SYNC", NULL, changeBenchmarkFilteredSync, NULL, filteredProcess, 1, churnPosCompID );
+	ecps_SetProcessChangeFilter( filteredProcess, 1, churnPosCompID );
+
+	// the ecps starts out putting off changes until the first process is run
+	ecps_RunProcess( ecps, fullProcess );
+	churnBenchmarkSpawn( ecps, &rand, sbIDs, numEntities );
+
+	// nothing has been destroyed, so the id indices all fit in [0, numEntities)
+	changeFullMirror = mem_Allocate( sizeof( ChurnBenchmarkVec ) * numEntities );
+	changeFilteredMirror = mem_Allocate( sizeof( ChurnBenchmarkVec ) * numEntities );
+	assert( ( changeFullMirror != NULL ) && ( changeFilteredMirror != NULL ) );
+
+	ecps_RunProcess( ecps, fullProcess );
+	ecps_RunProcess( ecps, filteredProcess );
+}
+
+static void changeBenchmarkCleanUp( ECPS* ecps, EntityID** sbIDs )
+{
+	mem_Release( changeFullMirror );
+	changeFullMirror = NULL;
+	mem_Release( changeFilteredMirror );
+	changeFilteredMirror = NULL;
+	sb_Release( (*sbIDs) );
+	ecps_DestroyAllEntities( ecps );
+	ecps_CleanUp( ecps );
+}
+
+void ecps_RunChangeFilterBenchmark( uint32_t numEntities, uint32_t runs )
+{
+	assert( runs > 0 );
+	assert( numEntities >= 100 );
+
+	ECPS ecps;
+	Process fullProcess;
+	Process filteredProcess;
+	EntityID* sbIDs = NULL;
+	changeBenchmarkSetup( &ecps, &fullProcess, &filteredProcess, &sbIDs, numEntities );
+
+	llog( LOG_INFO, "ECPS change filter benchmark: syncing %u entities, %u runs", numEntities, runs );
+
+	// the entities are in the array in the order they were created, so changing a run of them in a row only
+	//  touches a few ranges, while spreading the same number out over the array touches all of them
+	struct {
+		const char* name;
+		uint32_t count;
+		uint32_t step;
+	} cases[] = {
+		{ "nothing changed", 0, 1 },
+		{ "1% changed, together", numEntities / 100, 1 },
+		{ "10% changed, together", numEntities / 10, 1 },
+		{ "1% changed, spread out", numEntities / 100, 100 },
+		{ "everything changed", numEntities, 1 },
+	};
+
+	for( size_t c = 0; c < ( sizeof( cases ) / sizeof( cases[0] ) ); ++c ) {
+		double bestFullMS = 0.0;
+		double bestFilteredMS = 0.0;
+		for( uint32_t i = 0; i < runs; ++i ) {
+			changeBenchmarkMove( &ecps, sbIDs, cases[c].count, cases[c].step );
+			Uint64 start = SDL_GetPerformanceCounter( );
+			ecps_RunProcess( &ecps, &fullProcess );
+			bestFullMS = test_Fastest( bestFullMS, test_MSSince( start ), i );
+
+			start = SDL_GetPerformanceCounter( );
+			ecps_RunProcess( &ecps, &filteredProcess );
+			bestFilteredMS = test_Fastest( bestFilteredMS, test_MSSince( start ), i );
+		}
+
+		TEST_CHECK( changeBenchmarkMirrorMatches( &ecps, sbIDs, numEntities ), "the filtered process saw every change" );
+		llog( LOG_INFO, "  %s: %.3f ms every entity, %.3f ms filtered, %u entities visited", cases[c].name,
+			bestFullMS, bestFilteredMS, filteredProcess.stats.lastEntitiesVisited );
+	}
+
+	changeBenchmarkCleanUp( &ecps, &sbIDs );
+}
+
+// the filtered process has to see every change while only visiting the ranges that have any
+static void changeFilterTest( void )
+{
+	const uint32_t NUM_ENTITIES = PROCESS_RANGE_SIZE * 4;
+
+	ECPS ecps;
+	Process fullProcess;
+	Process filteredProcess;
+	EntityID* sbIDs = NULL;
+	changeBenchmarkSetup( &ecps, &fullProcess, &filteredProcess, &sbIDs, NUM_ENTITIES );
+
+	ecps_RunProcess( &ecps, &filteredProcess );
+	TEST_CHECK( filteredProcess.stats.lastEntitiesVisited == 0, "filtered process visits nothing when nothing changed" );
+
+	// the entities are in the array in the order they were created, so this is only in the third range
+	changeBenchmarkMove( &ecps, &( sbIDs[( PROCESS_RANGE_SIZE * 2 ) + 10] ), 1, 1 );
+	ecps_RunProcess( &ecps, &filteredProcess );
+	TEST_CHECK( filteredProcess.stats.lastEntitiesVisited == PROCESS_RANGE_SIZE, "filtered process visits only the changed range" );
+	TEST_CHECK( changeBenchmarkMirrorMatches( &ecps, sbIDs, NUM_ENTITIES ), "filtered process saw a single change" );
+
+	changeBenchmarkMove( &ecps, sbIDs, NUM_ENTITIES / 100, 100 );
+	ecps_RunProcess( &ecps, &filteredProcess );
+	TEST_CHECK( changeBenchmarkMirrorMatches( &ecps, sbIDs, NUM_ENTITIES ), "filtered process saw changes spread through the array" );
+
+	// a change has to follow the entity when it's moved to another packaged array before the process is run
+	ChurnBenchmarkVec vel = { 0.0f, 0.0f };
+	changeBenchmarkMove( &ecps, &( sbIDs[5] ), 1, 1 );
+	ecps_AddComponentToEntityByID( &ecps, sbIDs[5], churnVelCompID, &vel );
+	ecps_RunProcess( &ecps, &filteredProcess );
+	TEST_CHECK( changeBenchmarkMirrorMatches( &ecps, sbIDs, NUM_ENTITIES ), "filtered process saw an entity moved to another array" );
+
+	changeBenchmarkCleanUp( &ecps, &sbIDs );
+}
+
+void ecps_RunTests( void )
+{
+	churnTest( );
+	layoutTest( );
+	commandBufferTest( );
+	snapshotTest( );
+	changeFilterTest( );
+}
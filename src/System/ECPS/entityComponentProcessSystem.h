@@ -20,13 +20,55 @@ void ecps_CleanUp( ECPS* ecps );
 ComponentID ecps_AddComponentType( ECPS* ecps, const char* name, size_t size, VerifyComponent verify );
 
 // this attempts to set up a process to be used by the passed in ecps
+//  the ecps keeps track of the process, so it needs to stay at the same address until the ecps is cleaned up
 bool ecps_CreateProcess( ECPS* ecps,
 	const char* name, PreProcFunc preProc, ProcFunc proc, PostProcFunc postProc,
 	Process* outProcess, size_t numComponents, ... );
 
+// same as ecps_CreateProcess( ) but chunkProc is called once with a whole range of entities that share the same
+//  packaged array instead of once for each entity, use ecps_GetChunkComponent( ) to get at the components
+//  a thread safe chunk process is called with ranges of at most 1024 entities
+bool ecps_CreateChunkProcess( ECPS* ecps,
+	const char* name, PreProcFunc preProc, ChunkProcFunc chunkProc, PostProcFunc postProc,
+	Process* outProcess, size_t numComponents, ... );
+
+void ecps_ResetProcessStats( Process* process );
+void ecps_LogProcessStats( const Process* process );
+
+// flags the process as safe to run across multiple threads, see Process::isThreadSafe
+void ecps_SetProcessThreadSafe( Process* process, bool threadSafe );
+
+// only run the process on ranges of entities where one of the listed components has changed since the last time it
+//  was run, components are marked as changed when they're gotten with ecps_GetComponentFromEntity( ) or
+//  ecps_GetChunkComponent( ), or when entities are added to, removed from, or moved in their packaged array
+//  changes are tracked for every 1024 entities, so changing one entity will run the process on the ones around it
+//  pass in 0 components to run on everything again
+void ecps_SetProcessChangeFilter( Process* process, size_t numComponents, ... );
+
 // run a process, must have been created with the associated entity-component-process system
+//  thread safe processes are split up and run on the job queue, this returns once they're all done
 void ecps_RunProcess( ECPS* ecps, Process* process );
 
+// calls func once for each packaged array with entities that the process would run on, the process's functions
+//  aren't called, it's only used to choose the arrays
+//  structural changes are put off until all the chunks are done, same as ecps_RunProcess( )
+void ecps_ForEachChunk( ECPS* ecps, Process* process, ChunkFunc func, void* context );
+
+// gets the component for the first entity in the chunk and how many bytes apart each entity's component is,
+//  returns false and puts NULL in outFirst if the chunk doesn't have the component
+//  with the columnar layout the stride is the size of the component, so the components form a plain array
+bool ecps_GetChunkComponent( const EntityChunk* chunk, ComponentID componentID, void** outFirst, size_t* outStride );
+
+// same as ecps_GetChunkComponent( ) but doesn't mark the component as changed, so the data shouldn't be modified
+bool ecps_ReadChunkComponent( const EntityChunk* chunk, ComponentID componentID, const void** outFirst, size_t* outStride );
+
+// gets the id of the entity at index in the chunk, for when a chunk process needs to make structural changes
+EntityID ecps_GetChunkEntityID( const EntityChunk* chunk, size_t index );
+
+// whether entities are stored with all their components together (the default), or with each component type in
+//  it's own array, must be set before any entities are created
+void ecps_UseColumnarLayout( ECPS* ecps, bool columnar );
+
 // creates an entity with the associated components, excepts the variable argument list to be
 //  interleaved { ComponentID id, void* compData } groupings
 //  the memory pointed to by compData is copied into the component specified by id for the
@@ -67,10 +109,54 @@ bool ecps_DoesEntityHaveComponentByID( ECPS* ecps, EntityID entityID, ComponentI
 bool ecps_GetComponentFromEntity( const Entity* entity, ComponentID componentID, void** outData );
 bool ecps_GetComponentFromEntityByID( ECPS* ecps, EntityID entityID, ComponentID componentID, void** outData );
 bool ecps_GetEntityAndComponentByID( ECPS* ecps, EntityID entityID, ComponentID componentID, Entity* outEntity, void** outData );
+
+// same as ecps_GetComponentFromEntity( ) but doesn't mark the component as changed, so the data shouldn't be modified
+bool ecps_ReadComponentFromEntity( const Entity* entity, ComponentID componentID, const void** outData );
+bool ecps_ReadComponentFromEntityByID( ECPS* ecps, EntityID entityID, ComponentID componentID, const void** outData );
 void ecps_DestroyEntity( ECPS* ecps, const Entity* entity );
 void ecps_DestroyEntityByID( ECPS* ecps, EntityID entityID );
 
 // clears out all entities, not ids will be valid after this is called
 void ecps_DestroyAllEntities( ECPS* ecps );
 
+// copies all the entities, the entity directory, and the ids into one block of memory, sbOutSnapshot is cleared and
+//  reused so taking a snapshot every frame into the same buffer won't allocate once it's large enough
+//  can't be done while a process is running, returns the size of the snapshot in bytes
+size_t ecps_Snapshot( ECPS* ecps, uint8_t** sbOutSnapshot );
+
+// replaces all the entities with the ones in a snapshot, the ecps must have the same component types as the one
+//  the snapshot was taken from, each packaged array grows at most once, so restoring into an ecps that's already
+//  large enough won't allocate
+//  can't be done while a process is running, returns 0 on success, -1 if the snapshot doesn't match
+int ecps_Restore( ECPS* ecps, const uint8_t* snapshot, size_t size );
+
+// runs small versions of what the benchmarks below do and checks the results, asserting if anything fails
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunTests( void );
+
+// spawns up to peakEntities, destroys down to liveEntities, and then spawns and destroys churnPerFrame entities
+//  for numFrames, logging how long a simple process takes to run at each point
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunChurnBenchmark( uint32_t peakEntities, uint32_t liveEntities, uint32_t churnPerFrame, uint32_t numFrames );
+
+// lerps the positions of numEntities entities that have a few other components as well, with both the interleaved
+//  and columnar layouts, using both a per entity process and a chunk process, and logs the timing of each
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunLayoutBenchmark( uint32_t numEntities, uint32_t runs );
+
+// spawns numEntities entities in a few different packaged arrays from inside a process and then destroys them all
+//  from another, logs the best time it took to apply the commands for each
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunCommandBufferBenchmark( uint32_t numEntities, uint32_t runs );
+
+// takes snapshots of numEntities entities, changes them, and then restores them, both into the same ecps and a
+//  separate one, logs the size of the snapshot and the best time for each
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunSnapshotBenchmark( uint32_t numEntities, uint32_t runs );
+
+// runs a process that copies the positions of numEntities entities out of the ecps, after changing different
+//  amounts of them, both with and without a change filter, logs the best time for each
+//  uses the main memory, so mem_Init( ) must have been called
+void ecps_RunChangeFilterBenchmark( uint32_t numEntities, uint32_t runs );
+
 #endif
\ No newline at end of file
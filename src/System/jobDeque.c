@@ -0,0 +1,101 @@
+#include "jobDeque.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "memory.h"
+
+int jd_Init( JobDeque* deque, size_t size )
+{
+	assert( deque != NULL );
+	assert( size > 0 );
+
+	size_t pow2Size = 1;
+	while( pow2Size < size ) {
+		pow2Size <<= 1;
+	}
+
+	deque->size = pow2Size;
+	deque->mask = pow2Size - 1;
+	deque->jobs = mem_Allocate( sizeof( deque->jobs[0] ) * pow2Size );
+	if( deque->jobs == NULL ) {
+		return -1;
+	}
+	memset( deque->jobs, 0, sizeof( deque->jobs[0] ) * pow2Size );
+	deque->top = 0;
+	deque->bottom = 0;
+	deque->lock = 0;
+
+	return 0;
+}
+
+void jd_CleanUp( JobDeque* deque )
+{
+	assert( deque != NULL );
+
+	mem_Release( deque->jobs );
+	deque->jobs = NULL;
+}
+
+bool jd_Push( JobDeque* deque, Job* jobby )
+{
+	assert( deque != NULL );
+	assert( jobby != NULL );
+
+	bool success = false;
+	SDL_AtomicLock( &( deque->lock ) ); {
+		if( ( deque->bottom - deque->top ) < deque->size ) {
+			deque->jobs[deque->bottom & deque->mask] = (*jobby);
+			++( deque->bottom );
+			success = true;
+		}
+	} SDL_AtomicUnlock( &( deque->lock ) );
+
+	return success;
+}
+
+bool jd_Pop( JobDeque* deque, Job* outJob )
+{
+	assert( deque != NULL );
+	assert( outJob != NULL );
+
+	bool success = false;
+	SDL_AtomicLock( &( deque->lock ) ); {
+		if( deque->bottom != deque->top ) {
+			--( deque->bottom );
+			(*outJob) = deque->jobs[deque->bottom & deque->mask];
+			success = true;
+		}
+	} SDL_AtomicUnlock( &( deque->lock ) );
+
+	return success;
+}
+
+bool jd_Steal( JobDeque* deque, Job* outJob )
+{
+	assert( deque != NULL );
+	assert( outJob != NULL );
+
+	// don't bother fighting over the lock if there's nothing to take
+	if( jd_IsEmpty( deque ) ) {
+		return false;
+	}
+
+	bool success = false;
+	SDL_AtomicLock( &( deque->lock ) ); {
+		if( deque->bottom != deque->top ) {
+			(*outJob) = deque->jobs[deque->top & deque->mask];
+			++( deque->top );
+			success = true;
+		}
+	} SDL_AtomicUnlock( &( deque->lock ) );
+
+	return success;
+}
+
+// not locked, only a hint for whether it's worth trying to take something
+bool jd_IsEmpty( JobDeque* deque )
+{
+	assert( deque != NULL );
+	return ( ( (volatile JobDeque*)deque )->bottom == ( (volatile JobDeque*)deque )->top );
+}
\ No newline at end of file
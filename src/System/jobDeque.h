@@ -0,0 +1,35 @@
+#ifndef JOB_DEQUE_H
+#define JOB_DEQUE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <SDL_atomic.h>
+
+#include "jobRingQueue.h"
+
+// fixed size double ended queue of jobs, the owning thread pushes and pops from the bottom while other threads
+//  steal from the top. the owner takes the most recently added job, which is the one most likely to still be in
+//  the cache, thieves take the oldest, which tend to be the larger pieces of work
+// protected by a spin lock, which is almost never contended since the owner is the only one using it unless
+//  another thread has run out of work
+typedef struct {
+	size_t size;
+	size_t mask;
+	Job* jobs;
+	size_t top;
+	size_t bottom;
+	SDL_SpinLock lock;
+} JobDeque;
+
+// size is rounded up to a power of two
+int jd_Init( JobDeque* deque, size_t size );
+void jd_CleanUp( JobDeque* deque );
+// owner only, returns false if the deque is full
+bool jd_Push( JobDeque* deque, Job* jobby );
+// owner only, takes the most recently pushed job, returns false if the deque is empty
+bool jd_Pop( JobDeque* deque, Job* outJob );
+// any thread, takes the oldest job, returns false if the deque is empty
+bool jd_Steal( JobDeque* deque, Job* outJob );
+bool jd_IsEmpty( JobDeque* deque );
+
+#endif /* inclusion guard */
\ No newline at end of file
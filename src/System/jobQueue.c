@@ -1,71 +1,276 @@
 #include "jobQueue.h"
 
 #include <stddef.h>
+#include <limits.h>
+#include <string.h>
 #include <SDL.h>
 #include <assert.h>
 
 #include "../System/platformLog.h"
+#include "../System/memory.h"
 #include "../Utils/stretchyBuffer.h"
+#include "jobDeque.h"
+#include "testing.h"
+#include "../Math/matrix4.h"
+#include "../Math/vector3.h"
 
 // TODO?: Give the option to create multiple job queues
 
-static JobRingQueue jobQueue;
+// how many jobs each worker can hold in it's own deque, once it's full new jobs go to the shared queue
+#define WORKER_DEQUE_SIZE 1024
 
-static JobRingQueue mainThreadQueue; // used for things that need to be done on the main thread
+// jobs added from threads that aren't workers go here, workers check it when their own deque is empty
+//  high and low priority jobs always go here so they can be done in the correct order, one queue for each priority
+static JobRingQueue jobQueues[NUM_JOB_PRIORITIES];
+
+static JobRingQueue mainThreadQueues[NUM_JOB_PRIORITIES]; // used for things that need to be done on the main thread
+static SDL_threadID mainThreadID;
+
+// how long the main thread can spend on jobs each frame, anything over it is taken out of the next frame's budget
+static Uint64 mainThreadBudget = 0; // in performance counter ticks, 0 means no limit
+static Uint64 mainThreadBudgetDebt = 0;
+static MainThreadJobStats mainThreadStats;
+
+// each worker pushes jobs it creates to it's own deque and takes from the bottom, when it runs out it
+//  steals from the top of the other workers deques
+static JobDeque* workerDeques = NULL;
+static size_t numWorkerDeques = 0;
+static bool useWorkStealing = true;
+
+// which worker deque belongs to the current thread, stored as the index + 1 so 0 means it's not a worker
+static SDL_TLSID workerIndexID = 0;
+
+// jobs that have been added but not finished, wherever they're stored
+static SDL_atomic_t jobsInFlight;
+
+static SDL_sem* jobQueueSemaphore = NULL;
+static SDL_atomic_t quitFlag;
+static SDL_atomic_t sleepingWorkers;
+static SDL_Thread** sbThreadPool = NULL;
 
 // returns if all the jobs are done or not
 bool jq_AllJobsDone( void )
 {
-	return ( jrq_IsEmpty( &jobQueue ) && !jrq_IsBusy( &jobQueue ) );
+	return ( SDL_AtomicGet( &jobsInFlight ) == 0 );
+}
+
+static int currentWorkerIndex( void )
+{
+	if( workerIndexID == 0 ) {
+		return -1;
+	}
+	return ( (int)(uintptr_t)SDL_TLSGet( workerIndexID ) ) - 1;
+}
+
+typedef struct JobContinuation {
+	Job job;
+	JobPriority priority;
+	bool mainThread;
+	struct JobContinuation* next;
+} JobContinuation;
+
+static void queueJob( Job* job, JobPriority priority, bool mainThread );
+
+static void finishCounter( JobCounter* counter )
+{
+	if( counter == NULL ) {
+		return;
+	}
+
+	// anything waiting on the counter can throw it away as soon as it sees zero, so the count only ever reaches zero
+	//  while holding the lock, and waiters take the lock before returning, see waitForCounterRelease( )
+	int count = SDL_AtomicGet( &( counter->count ) );
+	while( count > 1 ) {
+		if( SDL_AtomicCAS( &( counter->count ), count, count - 1 ) ) {
+			return;
+		}
+		count = SDL_AtomicGet( &( counter->count ) );
+	}
+
+	// we're probably the last one, something may have been added to it since we checked so only take what was
+	//  waiting on the counter if we were the one to bring it to zero
+	JobContinuation* continuations = NULL;
+	SDL_AtomicLock( &( counter->lock ) ); {
+		if( SDL_AtomicAdd( &( counter->count ), -1 ) == 1 ) {
+			continuations = counter->continuations;
+			counter->continuations = NULL;
+		}
+	} SDL_AtomicUnlock( &( counter->lock ) );
+
+	while( continuations != NULL ) {
+		JobContinuation* next = continuations->next;
+		queueJob( &( continuations->job ), continuations->priority, continuations->mainThread );
+		mem_Release( continuations );
+		continuations = next;
+	}
+}
+
+// the count reaching zero and the lock being released aren't done at the same time, once this returns the thread that
+//  finished the counter is done with it and the counter can be discarded
+static void waitForCounterRelease( JobCounter* counter )
+{
+	SDL_AtomicLock( &( counter->lock ) );
+	SDL_AtomicUnlock( &( counter->lock ) );
+}
+
+static void runJob( Job* job )
+{
+	if( job->process != NULL ) job->process( job->data );
+	finishCounter( job->counter );
+}
+
+static bool takeNextJob( int workerIdx, Job* outJob )
+{
+	if( jrq_Read( &( jobQueues[JOB_PRIORITY_HIGH] ), outJob ) ) {
+		return true;
+	}
+
+	if( ( workerIdx >= 0 ) && jd_Pop( &( workerDeques[workerIdx] ), outJob ) ) {
+		return true;
+	}
+
+	if( jrq_Read( &( jobQueues[JOB_PRIORITY_NORMAL] ), outJob ) ) {
+		return true;
+	}
+
+	// start looking at the worker after us so the thieves are spread out
+	for( size_t i = 1; i <= numWorkerDeques; ++i ) {
+		size_t victim = ( (size_t)( workerIdx + 1 ) + i ) % numWorkerDeques;
+		if( ( (int)victim != workerIdx ) && jd_Steal( &( workerDeques[victim] ), outJob ) ) {
+			return true;
+		}
+	}
+
+	// only do low priority jobs when there's nothing else
+	if( jrq_Read( &( jobQueues[JOB_PRIORITY_LOW] ), outJob ) ) {
+		return true;
+	}
+
+	return false;
+}
+
+// workerIdx is the deque that belongs to the calling thread, or -1 if it doesn't have one
+static bool processNextJob( int workerIdx )
+{
+	Job job;
+	if( !takeNextJob( workerIdx, &job ) ) {
+		return false;
+	}
+
+	runJob( &job );
+	SDL_AtomicAdd( &jobsInFlight, -1 );
+	return true;
 }
 
 // non-static version for if we want the main thread to process jobs as well
 bool jq_ProcessNextJob( void )
 {
-	return jrq_ProcessNext( &jobQueue );
+	return processNextJob( currentWorkerIndex( ) );
 }
 
-static SDL_sem* jobQueueSemaphore = NULL;
-static SDL_atomic_t quitFlag;
-static SDL_Thread** sbThreadPool = NULL;
+// runs the next main thread job with a priority of at least minPriority
+static bool processNextMainThreadJob( JobPriority minPriority )
+{
+	Job job;
+	for( int i = 0; i <= (int)minPriority; ++i ) {
+		if( jrq_Read( &( mainThreadQueues[i] ), &job ) ) {
+			runJob( &job );
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool anyJobsWaiting( void )
+{
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		if( !jrq_IsEmpty( &( jobQueues[i] ) ) ) {
+			return true;
+		}
+	}
+
+	for( size_t i = 0; i < numWorkerDeques; ++i ) {
+		if( !jd_IsEmpty( &( workerDeques[i] ) ) ) {
+			return true;
+		}
+	}
+
+	return false;
+}
 
-#include <stdio.h>
 static int jobThread( void* data )
 {
+	int workerIdx = (int)(uintptr_t)data;
+	if( useWorkStealing ) {
+		SDL_TLSSet( workerIndexID, (void*)(uintptr_t)( workerIdx + 1 ), NULL );
+	} else {
+		workerIdx = -1;
+	}
+
 	// check for new job
-	while( quitFlag.value == 0 ) {
-		if( !jrq_ProcessNext( &jobQueue ) ) {
-			// no job to process, wait until more jobs are added
-			SDL_SemWait( jobQueueSemaphore );
+	while( SDL_AtomicGet( &quitFlag ) == 0 ) {
+		if( !processNextJob( workerIdx ) ) {
+			// no job to process, let anyone adding jobs know we need to be woken up, then check again in case
+			//  one was added before they could see we were sleeping
+			SDL_AtomicAdd( &sleepingWorkers, 1 );
+			if( !anyJobsWaiting( ) && ( SDL_AtomicGet( &quitFlag ) == 0 ) ) {
+				SDL_SemWait( jobQueueSemaphore );
+			}
+			SDL_AtomicAdd( &sleepingWorkers, -1 );
 		}
 	}
 
+	// give back any memory this thread was holding on to
+	mem_ReleaseThreadCache( );
+
 	return 0;
 }
 
-int jq_Initialize( uint8_t numThreads )
+static int initialize( uint8_t numThreads, bool workStealing )
 {
 	assert( numThreads > 0 );
 
 	sbThreadPool = NULL;
-	jobQueue.ringBuffer = NULL;
-	mainThreadQueue.ringBuffer = NULL;
-
-	if( jrq_Init( &jobQueue, 256 ) < 0 ) {
-		llog( LOG_ERROR, "Unable to create job ring queue." );
-		jq_ShutDown( );
-		return -1;
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		jobQueues[i].ringBuffer = NULL;
+		mainThreadQueues[i].ringBuffer = NULL;
 	}
+	workerDeques = NULL;
+	numWorkerDeques = 0;
+	useWorkStealing = workStealing;
+	mainThreadID = SDL_ThreadID( );
+	SDL_AtomicSet( &jobsInFlight, 0 );
+	SDL_AtomicSet( &sleepingWorkers, 0 );
+
+	mainThreadBudgetDebt = 0;
+	memset( &mainThreadStats, 0, sizeof( mainThreadStats ) );
+
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		if( jrq_Init( &( jobQueues[i] ), 256 ) < 0 ) {
+			llog( LOG_ERROR, "Unable to create job ring queue." );
+			jq_ShutDown( );
+			return -1;
+		}
 
-	if( jrq_Init( &mainThreadQueue, 256 ) < 0 ) {
-		llog( LOG_ERROR, "Unable to create main thread job queue." );
-		jq_ShutDown( );
-		return -1;
+		if( jrq_Init( &( mainThreadQueues[i] ), 256 ) < 0 ) {
+			llog( LOG_ERROR, "Unable to create main thread job queue." );
+			jq_ShutDown( );
+			return -1;
+		}
 	}
 
 #ifdef THREAD_SUPPORT
 	SDL_AtomicSet( &quitFlag, 0 );
 
+	if( workerIndexID == 0 ) {
+		workerIndexID = SDL_TLSCreate( );
+		if( workerIndexID == 0 ) {
+			llog( LOG_ERROR, "Unable to create worker index thread local storage: %s", SDL_GetError( ) );
+			jq_ShutDown( );
+			return -1;
+		}
+	}
+
 	jobQueueSemaphore = SDL_CreateSemaphore( 0 );
 	if( jobQueueSemaphore == NULL ) {
 		llog( LOG_ERROR, "Unable to create job queue semaphore: %s", SDL_GetError( ) );
@@ -73,6 +278,23 @@ int jq_Initialize( uint8_t numThreads )
 		return -1;
 	}
 
+	if( workStealing ) {
+		workerDeques = mem_Allocate( sizeof( workerDeques[0] ) * numThreads );
+		if( workerDeques == NULL ) {
+			llog( LOG_ERROR, "Unable to create worker deques." );
+			jq_ShutDown( );
+			return -1;
+		}
+		for( uint8_t i = 0; i < numThreads; ++i ) {
+			if( jd_Init( &( workerDeques[i] ), WORKER_DEQUE_SIZE ) < 0 ) {
+				llog( LOG_ERROR, "Unable to create worker deque %i.", i );
+				jq_ShutDown( );
+				return -1;
+			}
+			++numWorkerDeques;
+		}
+	}
+
 	sb_Add( sbThreadPool, numThreads );
 	if( sbThreadPool == NULL ) {
 		llog( LOG_ERROR, "Unable to create thread pool!" );
@@ -84,7 +306,7 @@ int jq_Initialize( uint8_t numThreads )
 	for( size_t i = 0; i < sb_Count( sbThreadPool ); ++i ) {
 		char name[16];
 		SDL_snprintf( name, SDL_arraysize( name ), "Wrkr_%i", i );
-		sbThreadPool[i] = SDL_CreateThread( jobThread, name, NULL );
+		sbThreadPool[i] = SDL_CreateThread( jobThread, name, (void*)(uintptr_t)i );
 		if( sbThreadPool[i] == NULL ) {
 			llog( LOG_WARN, "Unable to create thread %i! Will continue with fewer threads. Reason: %s", i, SDL_GetError( ) );
 		} else {
@@ -104,18 +326,24 @@ int jq_Initialize( uint8_t numThreads )
 	return 0;
 }
 
+int jq_Initialize( uint8_t numThreads )
+{
+	return initialize( numThreads, true );
+}
+
 void jq_ShutDown( void )
 {
 #ifdef THREAD_SUPPORT
 	// signal to the threads that they need to shut down
 	SDL_AtomicSet( &quitFlag, 1 );
 
-	// wait for all the threads to shut down
+	// wait for all the threads to shut down, they need to finish so their memory caches are drained before
+	//  the memory is cleaned up
 	for( size_t i = 0; i < sb_Count( sbThreadPool ); ++i ) {
 		SDL_SemPost( jobQueueSemaphore ); // get the threads to wake up
-
-		// don't need the return value, so don't bother waiting
-		SDL_DetachThread( sbThreadPool[i] );
+	}
+	for( size_t i = 0; i < sb_Count( sbThreadPool ); ++i ) {
+		SDL_WaitThread( sbThreadPool[i], NULL );
 	}
 
 	// destroy the thread pool
@@ -123,19 +351,117 @@ void jq_ShutDown( void )
 
 	SDL_DestroySemaphore( jobQueueSemaphore );
 	jobQueueSemaphore = NULL;
+
+	for( size_t i = 0; i < numWorkerDeques; ++i ) {
+		jd_CleanUp( &( workerDeques[i] ) );
+	}
+	mem_Release( workerDeques );
+	workerDeques = NULL;
+	numWorkerDeques = 0;
 #endif
 
-	jrq_CleanUp( &mainThreadQueue );
-	jrq_CleanUp( &jobQueue );
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		jrq_CleanUp( &( mainThreadQueues[i] ) );
+		jrq_CleanUp( &( jobQueues[i] ) );
+	}
+}
+
+static void writeToQueue( Job* newJob, JobRingQueue* queue, bool mainThread )
+{
+	if( jrq_TryWrite( queue, newJob ) ) {
+		return;
+	}
+
+	// the queue is full, if this thread is allowed to run jobs from the queue then do that until there's room,
+	//  otherwise wait for another thread to make room
+	if( !mainThread ) {
+		int workerIdx = currentWorkerIndex( );
+		do {
+			processNextJob( workerIdx );
+		} while( !jrq_TryWrite( queue, newJob ) );
+	} else if( SDL_ThreadID( ) == mainThreadID ) {
+		do {
+			processNextMainThreadJob( JOB_PRIORITY_LOW );
+		} while( !jrq_TryWrite( queue, newJob ) );
+	} else {
+		jrq_Write( queue, newJob );
+	}
+}
+
+static void queueJob( Job* job, JobPriority priority, bool mainThread )
+{
+	assert( ( priority >= 0 ) && ( priority < NUM_JOB_PRIORITIES ) );
+
+	if( mainThread ) {
+		writeToQueue( job, &( mainThreadQueues[priority] ), true );
+		return;
+	}
+
+	SDL_AtomicAdd( &jobsInFlight, 1 );
+
+	// normal jobs added from inside a job stay with that worker unless someone else steals them
+	int workerIdx = currentWorkerIndex( );
+	if( ( priority != JOB_PRIORITY_NORMAL ) || ( workerIdx < 0 ) || !jd_Push( &( workerDeques[workerIdx] ), job ) ) {
+		writeToQueue( job, &( jobQueues[priority] ), false );
+	}
+
+	// only need to wake someone up if there's someone sleeping
+	if( SDL_AtomicGet( &sleepingWorkers ) > 0 ) {
+		SDL_SemPost( jobQueueSemaphore );
+	}
 }
 
-static void addJob( JobProcessFunc proc, void* data, JobRingQueue* queue )
+static bool addJob( JobProcessFunc proc, void* data, JobCounter* counter, JobPriority priority, bool mainThread )
 {
 	Job newJob;
 	newJob.process = proc;
 	newJob.data = data;
+	newJob.counter = counter;
 
-	jrq_Write( queue, &newJob );
+	if( counter != NULL ) {
+		SDL_AtomicAdd( &( counter->count ), 1 );
+	}
+
+	queueJob( &newJob, priority, mainThread );
+
+	return true;
+}
+
+static bool addJobAfter( JobCounter* dependency, JobProcessFunc proc, void* data, JobCounter* counter, bool mainThread )
+{
+	assert( dependency != NULL );
+
+	JobContinuation* continuation = mem_Allocate( sizeof( JobContinuation ) );
+	if( continuation == NULL ) {
+		llog( LOG_ERROR, "Unable to allocate job continuation." );
+		return false;
+	}
+	continuation->job.process = proc;
+	continuation->job.data = data;
+	continuation->job.counter = counter;
+	continuation->priority = JOB_PRIORITY_NORMAL;
+	continuation->mainThread = mainThread;
+
+	if( counter != NULL ) {
+		SDL_AtomicAdd( &( counter->count ), 1 );
+	}
+
+	// if the dependency is already done then there's nothing to wait for
+	bool waiting = false;
+	SDL_AtomicLock( &( dependency->lock ) ); {
+		if( SDL_AtomicGet( &( dependency->count ) ) > 0 ) {
+			continuation->next = dependency->continuations;
+			dependency->continuations = continuation;
+			waiting = true;
+		}
+	} SDL_AtomicUnlock( &( dependency->lock ) );
+
+	if( !waiting ) {
+		queueJob( &( continuation->job ), continuation->priority, mainThread );
+		mem_Release( continuation );
+	}
+
+	return true;
 }
 
 // TODO: Create a copy of the data so we don't have to worry about it disappearing while
@@ -148,27 +474,532 @@ bool jq_AddJob( JobProcessFunc proc, void* data )
 		llog( LOG_WARN, "Attempting to add job before job queue created." );
 		return false;
 	}//*/
-	addJob( proc, data, &jobQueue );
-	SDL_SemPost( jobQueueSemaphore );
-
-	return true;
+	return addJob( proc, data, NULL, JOB_PRIORITY_NORMAL, false );
 }
 
 bool jq_AddMainThreadJob( JobProcessFunc proc, void* data )
 {
-	addJob( proc, data, &mainThreadQueue );
+	return addJob( proc, data, NULL, JOB_PRIORITY_NORMAL, true );
+}
+
+void jq_InitCounter( JobCounter* counter )
+{
+	assert( counter != NULL );
+
+	SDL_AtomicSet( &( counter->count ), 0 );
+	counter->lock = 0;
+	counter->continuations = NULL;
+}
+
+bool jq_IsCounterDone( JobCounter* counter )
+{
+	assert( counter != NULL );
+	if( SDL_AtomicGet( &( counter->count ) ) > 0 ) {
+		return false;
+	}
+	waitForCounterRelease( counter );
 	return true;
 }
 
-// Goes through all the jobs added to the main thread and processes them
+bool jq_AddJobWithCounter( JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJob( proc, data, counter, JOB_PRIORITY_NORMAL, false );
+}
+
+bool jq_AddMainThreadJobWithCounter( JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJob( proc, data, counter, JOB_PRIORITY_NORMAL, true );
+}
+
+bool jq_AddPriorityJob( JobPriority priority, JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJob( proc, data, counter, priority, false );
+}
+
+bool jq_AddMainThreadPriorityJob( JobPriority priority, JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJob( proc, data, counter, priority, true );
+}
+
+bool jq_AddJobAfter( JobCounter* dependency, JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJobAfter( dependency, proc, data, counter, false );
+}
+
+bool jq_AddMainThreadJobAfter( JobCounter* dependency, JobProcessFunc proc, void* data, JobCounter* counter )
+{
+	return addJobAfter( dependency, proc, data, counter, true );
+}
+
+void jq_WaitForCounter( JobCounter* counter )
+{
+	assert( counter != NULL );
+
+	bool isMainThread = ( SDL_ThreadID( ) == mainThreadID );
+	int workerIdx = currentWorkerIndex( );
+	while( SDL_AtomicGet( &( counter->count ) ) > 0 ) {
+		// main thread jobs first, they're probably what's being waited on if we're loading something
+		bool didWork = isMainThread && processNextMainThreadJob( JOB_PRIORITY_LOW );
+		if( !didWork ) {
+			didWork = processNextJob( workerIdx );
+		}
+
+		if( !didWork ) {
+			SDL_Delay( 0 );
+		}
+	}
+
+	waitForCounterRelease( counter );
+}
+
+static uint32_t countWaitingMainThreadJobs( void )
+{
+	uint32_t count = 0;
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		count += jrq_Count( &( mainThreadQueues[i] ) );
+	}
+#ifndef THREAD_SUPPORT
+	for( int i = 0; i < NUM_JOB_PRIORITIES; ++i ) {
+		count += jrq_Count( &( jobQueues[i] ) );
+	}
+#endif
+	return count;
+}
+
+// Goes through the jobs added to the main thread and processes them until the budget is used up
 //  If there is no threading support then all other jobs are processed here as well
 void jq_ProcessMainThreadJobs( void )
 {
+	Uint64 start = SDL_GetPerformanceCounter( );
+	uint32_t jobsRun = 0;
+
+	// high priority jobs are always done
+	while( processNextMainThreadJob( JOB_PRIORITY_HIGH ) ) {
+		++jobsRun;
+	}
+
+	// if the last frame went over it's budget then we have less time this frame
+	Uint64 budget = 0;
+	if( mainThreadBudget > 0 ) {
+		budget = ( mainThreadBudgetDebt < mainThreadBudget ) ? ( mainThreadBudget - mainThreadBudgetDebt ) : 0;
+	}
+
+	bool outOfTime = false;
+	while( !outOfTime ) {
+		if( ( mainThreadBudget > 0 ) && ( ( SDL_GetPerformanceCounter( ) - start ) >= budget ) ) {
+			outOfTime = true;
+			break;
+		}
+
+		bool didWork = processNextMainThreadJob( JOB_PRIORITY_LOW );
 #ifndef THREAD_SUPPORT
-	while( jrq_ProcessNext( &jobQueue ) )
-		;
+		if( !didWork ) {
+			didWork = jq_ProcessNextJob( );
+		}
+#endif
+		if( !didWork ) {
+			break;
+		}
+		++jobsRun;
+	}
+
+	Uint64 spent = SDL_GetPerformanceCounter( ) - start;
+	if( mainThreadBudget > 0 ) {
+		// every frame earns a full budget, anything we went over gets taken out of the following frames
+		Uint64 owed = mainThreadBudgetDebt + spent;
+		mainThreadBudgetDebt = ( owed > mainThreadBudget ) ? ( owed - mainThreadBudget ) : 0;
+	}
+
+	double ticksToMS = 1000.0 / (double)SDL_GetPerformanceFrequency( );
+	mainThreadStats.lastJobsRun = jobsRun;
+	mainThreadStats.lastJobsDeferred = outOfTime ? countWaitingMainThreadJobs( ) : 0;
+	mainThreadStats.lastMS = (float)( (double)spent * ticksToMS );
+	mainThreadStats.debtMS = (float)( (double)mainThreadBudgetDebt * ticksToMS );
+	mainThreadStats.totalJobsRun += jobsRun;
+	if( mainThreadStats.lastJobsDeferred > 0 ) {
+		++( mainThreadStats.framesDeferred );
+		mainThreadStats.totalJobsDeferred += mainThreadStats.lastJobsDeferred;
+		if( mainThreadStats.lastJobsDeferred > mainThreadStats.peakJobsDeferred ) {
+			mainThreadStats.peakJobsDeferred = mainThreadStats.lastJobsDeferred;
+		}
+	}
+}
+
+void jq_SetMainThreadJobBudget( float ms )
+{
+	if( ms <= 0.0f ) {
+		mainThreadBudget = 0;
+	} else {
+		mainThreadBudget = (Uint64)( ( (double)ms / 1000.0 ) * (double)SDL_GetPerformanceFrequency( ) );
+	}
+	mainThreadBudgetDebt = 0;
+}
+
+void jq_GetMainThreadJobStats( MainThreadJobStats* outStats )
+{
+	assert( outStats != NULL );
+	(*outStats) = mainThreadStats;
+}
+
+void jq_LogMainThreadJobStats( void )
+{
+	llog( LOG_INFO, "Main thread job stats:" );
+	llog( LOG_INFO, "  Last frame: %u run, %u deferred, %.3f ms", mainThreadStats.lastJobsRun, mainThreadStats.lastJobsDeferred, mainThreadStats.lastMS );
+	llog( LOG_INFO, "  Budget debt: %.3f ms", mainThreadStats.debtMS );
+	llog( LOG_INFO, "  Total run: %u", mainThreadStats.totalJobsRun );
+	llog( LOG_INFO, "  Frames with deferred jobs: %u", mainThreadStats.framesDeferred );
+	llog( LOG_INFO, "  Total deferred: %u, peak deferred in one frame: %u", mainThreadStats.totalJobsDeferred, mainThreadStats.peakJobsDeferred );
+}
+
+// ***** Parallel for
+typedef struct {
+	ParallelForFunc func;
+	void* context;
+	size_t count;
+	size_t grain;
+	int numChunks;
+	SDL_atomic_t nextChunk;
+	SDL_atomic_t chunksDone;
+	SDL_atomic_t refCount; // helper jobs may not start until after the loop is finished, so the last one out frees this
+} ParallelForData;
+
+static void releaseParallelFor( ParallelForData* pf )
+{
+	if( SDL_AtomicDecRef( &( pf->refCount ) ) ) {
+		mem_Release( pf );
+	}
+}
+
+static void runParallelForChunks( ParallelForData* pf )
+{
+	int chunk;
+	while( ( chunk = SDL_AtomicAdd( &( pf->nextChunk ), 1 ) ) < pf->numChunks ) {
+		size_t start = (size_t)chunk * pf->grain;
+		size_t end = start + pf->grain;
+		if( end > pf->count ) end = pf->count;
+		pf->func( pf->context, start, end );
+		SDL_AtomicAdd( &( pf->chunksDone ), 1 );
+	}
+}
+
+static void parallelForJob( void* data )
+{
+	ParallelForData* pf = (ParallelForData*)data;
+	runParallelForChunks( pf );
+	releaseParallelFor( pf );
+}
+
+void jq_ParallelFor( size_t count, size_t grain, ParallelForFunc func, void* context )
+{
+	assert( func != NULL );
+
+	if( count == 0 ) {
+		return;
+	}
+
+	if( grain == 0 ) {
+		grain = 1;
+	}
+
+	size_t numChunks = ( count + grain - 1 ) / grain;
+	assert( numChunks <= INT_MAX );
+
+	// one helper per worker at most, the calling thread works on it as well
+	size_t numHelpers = sb_Count( sbThreadPool );
+	if( numHelpers > ( numChunks - 1 ) ) {
+		numHelpers = numChunks - 1;
+	}
+
+	ParallelForData* pf = NULL;
+	if( numHelpers > 0 ) {
+		pf = mem_Allocate( sizeof( ParallelForData ) );
+	}
+
+	// not worth splitting up, or we can't
+	if( pf == NULL ) {
+		func( context, 0, count );
+		return;
+	}
+
+	pf->func = func;
+	pf->context = context;
+	pf->count = count;
+	pf->grain = grain;
+	pf->numChunks = (int)numChunks;
+	SDL_AtomicSet( &( pf->nextChunk ), 0 );
+	SDL_AtomicSet( &( pf->chunksDone ), 0 );
+	SDL_AtomicSet( &( pf->refCount ), (int)numHelpers + 1 );
+
+	for( size_t i = 0; i < numHelpers; ++i ) {
+		jq_AddJob( parallelForJob, pf );
+	}
+
+	runParallelForChunks( pf );
+
+	// everything has been handed out, just wait for the last chunks to finish, don't pick up any other jobs
+	//  since they could take much longer than what we're waiting on
+	while( SDL_AtomicGet( &( pf->chunksDone ) ) < pf->numChunks ) {
+		SDL_Delay( 0 );
+	}
+
+	releaseParallelFor( pf );
+}
+
+// ***** Scheduler benchmark
+static SDL_atomic_t benchmarkChecksum;
+
+// a tiny bit of work, about what updating a single particle or sprite would be
+static int benchmarkLeafValue( uint32_t x )
+{
+	for( int i = 0; i < 16; ++i ) {
+		x = ( x * 1664525 ) + 1013904223;
+	}
+	return (int)( x & 0xFF );
+}
+
+static void benchmarkLeafJob( void* data )
+{
+	SDL_AtomicAdd( &benchmarkChecksum, benchmarkLeafValue( (uint32_t)(uintptr_t)data ) );
+}
+
+static uint32_t benchmarkLeavesPerSpawner = 0;
+static JobCounter* benchmarkCounter = NULL; // the benchmark doesn't use one, the tests do
+static void benchmarkSpawnerJob( void* data )
+{
+	// fan out from inside a job, this is where the local deques should help
+	uint32_t base = (uint32_t)(uintptr_t)data;
+	for( uint32_t i = 0; i < benchmarkLeavesPerSpawner; ++i ) {
+		jq_AddJobWithCounter( benchmarkLeafJob, (void*)(uintptr_t)( base + i ), benchmarkCounter );
+	}
+}
+
+static int expectedBenchmarkChecksum( uint32_t numSpawners, uint32_t leavesPerSpawner )
+{
+	int checksum = 0;
+	for( uint32_t i = 0; i < numSpawners * leavesPerSpawner; ++i ) {
+		checksum += benchmarkLeafValue( i );
+	}
+	return checksum;
+}
+
+static double runSchedulerBenchmark( uint8_t numThreads, bool workStealing, uint32_t numSpawners, uint32_t leavesPerSpawner, int* checksumOut )
+{
+	if( initialize( numThreads, workStealing ) < 0 ) {
+		return -1.0;
+	}
+
+	SDL_AtomicSet( &benchmarkChecksum, 0 );
+	benchmarkLeavesPerSpawner = leavesPerSpawner;
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint32_t i = 0; i < numSpawners; ++i ) {
+		jq_AddJob( benchmarkSpawnerJob, (void*)(uintptr_t)( i * leavesPerSpawner ) );
+	}
+
+	// main thread helps out until everything is finished
+	while( !jq_AllJobsDone( ) ) {
+		if( !jq_ProcessNextJob( ) ) {
+			SDL_Delay( 0 );
+		}
+	}
+	double ms = test_MSSince( start );
+
+	jq_ShutDown( );
+
+	(*checksumOut) = SDL_AtomicGet( &benchmarkChecksum );
+	return ms;
+}
+
+void jq_RunSchedulerBenchmark( uint8_t numThreads, uint32_t numSpawners, uint32_t leavesPerSpawner )
+{
+#ifdef THREAD_SUPPORT
+	assert( sbThreadPool == NULL );
+	assert( numThreads > 0 );
+
+	double totalJobs = (double)numSpawners * (double)( leavesPerSpawner + 1 );
+	llog( LOG_INFO, "Job scheduler benchmark: %i threads, %u spawner jobs each adding %u jobs", numThreads, numSpawners, leavesPerSpawner );
+
+	int sharedChecksum = 0;
+	double sharedMS = runSchedulerBenchmark( numThreads, false, numSpawners, leavesPerSpawner, &sharedChecksum );
+	llog( LOG_INFO, "  Shared queue: %.3f ms, %.1f jobs per ms", sharedMS, totalJobs / sharedMS );
+
+	int stealingChecksum = 0;
+	double stealingMS = runSchedulerBenchmark( numThreads, true, numSpawners, leavesPerSpawner, &stealingChecksum );
+	llog( LOG_INFO, "  Work stealing: %.3f ms, %.1f jobs per ms", stealingMS, totalJobs / stealingMS );
+
+	int expectedChecksum = expectedBenchmarkChecksum( numSpawners, leavesPerSpawner );
+	TEST_CHECK( sharedChecksum == expectedChecksum, "shared queue ran every job exactly once" );
+	TEST_CHECK( stealingChecksum == expectedChecksum, "work stealing ran every job exactly once" );
+#else
+	llog( LOG_INFO, "Compiled without support for threads, job scheduler benchmark not run." );
 #endif
+}
+
+static SDL_atomic_t testGroupJobsLeft;
+static SDL_atomic_t testGroupGate; // group jobs don't finish until this is set
+static SDL_atomic_t testDependentJobState; // 0 hasn't run, 1 ran after the group, -1 ran before it was done
+static SDL_atomic_t testMainThreadJobState; // 0 hasn't run, 1 ran on the main thread, -1 ran somewhere else
 
-	while( jrq_ProcessNext( &mainThreadQueue ) )
-		;
-}
\ No newline at end of file
+static void testGroupJob( void* data )
+{
+	while( SDL_AtomicGet( &testGroupGate ) == 0 ) {
+		SDL_Delay( 0 );
+	}
+	SDL_AtomicAdd( &testGroupJobsLeft, -1 );
+}
+
+static void testDependentJob( void* data )
+{
+	SDL_AtomicSet( &testDependentJobState, ( SDL_AtomicGet( &testGroupJobsLeft ) == 0 ) ? 1 : -1 );
+}
+
+static void testMainThreadJob( void* data )
+{
+	SDL_AtomicSet( &testMainThreadJobState, ( SDL_ThreadID( ) == mainThreadID ) ? 1 : -1 );
+}
+
+static void testParallelForRange( void* context, size_t start, size_t end )
+{
+	uint8_t* runCounts = (uint8_t*)context;
+	for( size_t i = start; i < end; ++i ) {
+		++runCounts[i];
+	}
+}
+
+void jq_RunTests( void )
+{
+	// jobs added from inside other jobs on the running queue, the counter keeps going until the jobs the spawners
+	//  add are done as well and all of them have to be run exactly once
+	JobCounter counter;
+	jq_InitCounter( &counter );
+	SDL_AtomicSet( &benchmarkChecksum, 0 );
+	benchmarkLeavesPerSpawner = 64;
+	benchmarkCounter = &counter;
+	for( uint32_t i = 0; i < 16; ++i ) {
+		jq_AddJobWithCounter( benchmarkSpawnerJob, (void*)(uintptr_t)( i * benchmarkLeavesPerSpawner ), &counter );
+	}
+	jq_WaitForCounter( &counter );
+	benchmarkCounter = NULL;
+	TEST_CHECK( SDL_AtomicGet( &benchmarkChecksum ) == expectedBenchmarkChecksum( 16, 64 ), "jobs added from inside jobs run exactly once" );
+
+	// a job added after a group only runs once the whole group is done, the group is held open for a bit so any
+	//  worker that got the dependent job too early has time to run it, waiting on the main thread also runs the main
+	//  thread jobs
+	JobCounter group;
+	JobCounter all;
+	jq_InitCounter( &group );
+	jq_InitCounter( &all );
+	SDL_AtomicSet( &testGroupJobsLeft, 2 );
+	SDL_AtomicSet( &testGroupGate, 0 );
+	SDL_AtomicSet( &testDependentJobState, 0 );
+	SDL_AtomicSet( &testMainThreadJobState, 0 );
+	for( uint32_t i = 0; i < 2; ++i ) {
+		jq_AddJobWithCounter( testGroupJob, NULL, &group );
+	}
+	jq_AddJobAfter( &group, testDependentJob, NULL, &all );
+	jq_AddMainThreadJobWithCounter( testMainThreadJob, NULL, &all );
+	SDL_Delay( 10 );
+	SDL_AtomicSet( &testGroupGate, 1 );
+	jq_WaitForCounter( &all );
+	TEST_CHECK( SDL_AtomicGet( &testDependentJobState ) == 1, "job added after a group run once the group was done" );
+	TEST_CHECK( SDL_AtomicGet( &testMainThreadJobState ) == 1, "main thread job run while waiting on the main thread" );
+
+	// the continuation could still be getting released from the group counter
+	jq_WaitForCounter( &group );
+	TEST_CHECK( jq_IsCounterDone( &group ) && jq_IsCounterDone( &all ), "counters done once everything was waited on" );
+
+	// every element covered exactly once, including when the count isn't a multiple of the grain and when there's
+	//  only a single chunk
+	uint8_t runCounts[1000];
+	size_t testGrains[] = { 7, 64, 1000 };
+	for( size_t g = 0; g < SDL_arraysize( testGrains ); ++g ) {
+		memset( runCounts, 0, sizeof( runCounts ) );
+		jq_ParallelFor( SDL_arraysize( runCounts ), testGrains[g], testParallelForRange, runCounts );
+		bool allRunOnce = true;
+		for( size_t i = 0; ( i < SDL_arraysize( runCounts ) ) && allRunOnce; ++i ) {
+			allRunOnce = ( runCounts[i] == 1 );
+		}
+		TEST_CHECK( allRunOnce, "parallel for covered every element exactly once" );
+	}
+}
+
+// ***** Parallel for benchmark
+typedef struct {
+	Vector3* positions;
+	float* angles;
+	Vector3* outPositions;
+} ParallelForBenchmarkData;
+
+// about what placing a sprite in the world would cost
+static void parallelForBenchmarkTransform( void* context, size_t start, size_t end )
+{
+	static const Vector3 corner = { 1.0f, 1.0f, 0.0f };
+	ParallelForBenchmarkData* data = (ParallelForBenchmarkData*)context;
+	for( size_t i = start; i < end; ++i ) {
+		Matrix4 rot, trans, final;
+		mat4_CreateZRotation( data->angles[i], &rot );
+		mat4_CreateTranslation_v( &( data->positions[i] ), &trans );
+		mat4_Multiply( &trans, &rot, &final );
+		mat4_TransformVec3Pos( &final, &corner, &( data->outPositions[i] ) );
+	}
+}
+
+void jq_RunParallelForBenchmark( uint8_t maxThreads, uint32_t numElements, uint32_t grain )
+{
+	assert( sbThreadPool == NULL );
+	assert( maxThreads > 0 );
+	assert( numElements > 0 );
+
+	ParallelForBenchmarkData data;
+	data.positions = mem_Allocate( sizeof( data.positions[0] ) * numElements );
+	data.angles = mem_Allocate( sizeof( data.angles[0] ) * numElements );
+	data.outPositions = mem_Allocate( sizeof( data.outPositions[0] ) * numElements );
+	Vector3* expected = mem_Allocate( sizeof( expected[0] ) * numElements );
+	if( ( data.positions == NULL ) || ( data.angles == NULL ) || ( data.outPositions == NULL ) || ( expected == NULL ) ) {
+		llog( LOG_ERROR, "Unable to allocate data for parallel for benchmark." );
+		goto clean_up;
+	}
+
+	for( uint32_t i = 0; i < numElements; ++i ) {
+		data.positions[i].x = (float)( i % 1000 );
+		data.positions[i].y = (float)( i / 1000 );
+		data.positions[i].z = 0.0f;
+		data.angles[i] = (float)i * 0.001f;
+	}
+
+	llog( LOG_INFO, "Parallel for benchmark: %u elements, grain of %u", numElements, grain );
+
+	// single thread baseline, also what everything else is checked against
+	Uint64 start = SDL_GetPerformanceCounter( );
+	parallelForBenchmarkTransform( &data, 0, numElements );
+	double baseMS = test_MSSince( start );
+	memcpy( expected, data.outPositions, sizeof( expected[0] ) * numElements );
+	llog( LOG_INFO, "  1 thread: %.3f ms", baseMS );
+
+#ifdef THREAD_SUPPORT
+	// the calling thread also does work, so n threads is n-1 workers
+	for( uint8_t numThreads = 2; numThreads <= maxThreads; ++numThreads ) {
+		if( initialize( numThreads - 1, true ) < 0 ) {
+			break;
+		}
+
+		memset( data.outPositions, 0, sizeof( data.outPositions[0] ) * numElements );
+		start = SDL_GetPerformanceCounter( );
+		jq_ParallelFor( numElements, grain, parallelForBenchmarkTransform, &data );
+		double ms = test_MSSince( start );
+
+		jq_ShutDown( );
+
+		llog( LOG_INFO, "  %i threads: %.3f ms, %.2fx speed up", numThreads, ms, baseMS / ms );
+		TEST_CHECK( memcmp( expected, data.outPositions, sizeof( expected[0] ) * numElements ) == 0, "parallel for results match the single thread results" );
+	}
+#else
+	llog( LOG_INFO, "Compiled without support for threads, only the single thread version was run." );
+#endif
+
+clean_up:
+	mem_Release( data.positions );
+	mem_Release( data.angles );
+	mem_Release( data.outPositions );
+	mem_Release( expected );
+}
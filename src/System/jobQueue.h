@@ -7,23 +7,102 @@
 #include "jobRingQueue.h"
 
 // Simple job queue system to handle multithreading
-//  Primarily issue is how to handle data passing and allocation, will need to make memory manager thread safe
-//  Easy way may to be do a memory pool per thread
+//  Primarily issue is how to handle data passing and allocation, the memory manager gives each thread it's own
+//   cache of small blocks, worker threads give theirs back when the queue is shut down
 //  Initial test will be with threaded loading of assets
-// Stores the jobs in a priority queue
+// Each worker has it's own deque of jobs, jobs added from inside a job go to that worker's deque, jobs added from
+//  any other thread go into a shared queue. Workers that run out of jobs take from the shared queue and then steal
+//  from the other workers.
+// Counters let you wait on a specific group of jobs instead of everything. Every job added with a counter
+//  increases it and decreases it once the job is finished. A job that adds more jobs with the same counter keeps
+//  it above zero until those are finished as well, so a load job that adds a main thread job to bind what it
+//  loaded can be waited on as a single thing.
+// Jobs have a priority, high priority jobs are taken before anything else and low priority jobs are only taken
+//  when there's nothing else to do. Main thread jobs are limited to a time budget each frame, high priority main
+//  thread jobs ignore the budget, anything else that doesn't fit is left for the next frame.
+typedef enum {
+	JOB_PRIORITY_HIGH,
+	JOB_PRIORITY_NORMAL,
+	JOB_PRIORITY_LOW,
+	NUM_JOB_PRIORITIES
+} JobPriority;
+
+struct JobContinuation;
+typedef struct JobCounter {
+	SDL_atomic_t count;
+	SDL_SpinLock lock;
+	struct JobContinuation* continuations; // jobs waiting for the count to reach zero
+} JobCounter;
+
 int jq_Initialize( uint8_t numThreads );
 void jq_ShutDown( void );
 bool jq_AddJob( JobProcessFunc proc, void* data );
 bool jq_AddMainThreadJob( JobProcessFunc proc, void* data );
 
+void jq_InitCounter( JobCounter* counter );
+// once this returns true the queue is done with the counter and it can be discarded
+bool jq_IsCounterDone( JobCounter* counter );
+// counter can be NULL
+bool jq_AddJobWithCounter( JobProcessFunc proc, void* data, JobCounter* counter );
+bool jq_AddMainThreadJobWithCounter( JobProcessFunc proc, void* data, JobCounter* counter );
+// the functions above all use JOB_PRIORITY_NORMAL
+bool jq_AddPriorityJob( JobPriority priority, JobProcessFunc proc, void* data, JobCounter* counter );
+bool jq_AddMainThreadPriorityJob( JobPriority priority, JobProcessFunc proc, void* data, JobCounter* counter );
+// the job isn't added until the dependency reaches zero, if it's already zero it's added immediately
+//  counter is increased right away so waiting on it also waits for the dependency
+bool jq_AddJobAfter( JobCounter* dependency, JobProcessFunc proc, void* data, JobCounter* counter );
+bool jq_AddMainThreadJobAfter( JobCounter* dependency, JobProcessFunc proc, void* data, JobCounter* counter );
+// runs jobs until the counter reaches zero, the main thread will also run main thread jobs while waiting
+//  like jq_IsCounterDone( ) the counter can be discarded once this returns
+void jq_WaitForCounter( JobCounter* counter );
+
+// calls func on ranges of at most grain elements until [0,count) has been covered, the ranges are spread across
+//  the workers and the calling thread, returns once they've all been done
+//  the ranges are done in no particular order, so func must be safe to call on different ranges at the same time
+typedef void (*ParallelForFunc)( void* context, size_t start, size_t end );
+void jq_ParallelFor( size_t count, size_t grain, ParallelForFunc func, void* context );
+
 // gets the next job and runs it, used if you want the main thread running jobs as well
 bool jq_ProcessNextJob( void );
 
 // Returns if all the non-main thread jobs are done
 bool jq_AllJobsDone( void );
 
-// Goes through all the jobs added to the main thread and processes them
+// Goes through the jobs added to the main thread and processes them until the budget is used up
 //  If there is no threading support then all other jobs are processed here as well
 void jq_ProcessMainThreadJobs( void );
 
+// how many milliseconds jq_ProcessMainThreadJobs( ) can spend each frame, 0 means no limit
+//  time spent over the budget is taken out of the following frames
+void jq_SetMainThreadJobBudget( float ms );
+
+typedef struct {
+	uint32_t lastJobsRun;
+	uint32_t lastJobsDeferred; // jobs still waiting when the budget ran out
+	float lastMS;
+	float debtMS; // how much will be taken out of the next frame's budget
+	uint32_t totalJobsRun;
+	uint32_t totalJobsDeferred;
+	uint32_t framesDeferred;
+	uint32_t peakJobsDeferred;
+} MainThreadJobStats;
+
+void jq_GetMainThreadJobStats( MainThreadJobStats* outStats );
+void jq_LogMainThreadJobStats( void );
+
+// checks jobs added from inside jobs are all run exactly once on the running queue, that counters and jobs added
+//  after them wait for everything they should and that jq_ParallelFor( ) covers every element once, asserting if
+//  anything fails
+//  jq_Initialize( ) must have been called, and it must be called from the main thread
+void jq_RunTests( void );
+
+// runs the same set of small jobs through a single shared queue and then with work stealing, logs the timing
+//  of each, the job queue must not be running when this is called, uses the main memory so mem_Init( ) must have
+//  been called
+void jq_RunSchedulerBenchmark( uint8_t numThreads, uint32_t numSpawners, uint32_t leavesPerSpawner );
+
+// transforms numElements positions with 1 up to maxThreads threads and logs the timing of each, the job queue must
+//  not be running when this is called, uses the main memory so mem_Init( ) must have been called
+void jq_RunParallelForBenchmark( uint8_t maxThreads, uint32_t numElements, uint32_t grain );
+
 #endif /* inclusion guard */
\ No newline at end of file
@@ -2,20 +2,41 @@
 
 #include <assert.h>
 #include <string.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
 
 #include "memory.h"
+#include "platformLog.h"
+#include "testing.h"
+
+// how many times a blocked write will try again before giving up the rest of it's time slice
+#define WRITE_SPIN_COUNT 64
+
+// positions only ever increase and are allowed to wrap around, so compare them by their difference
+#define POSITION_DIFF( a, b ) ( (int32_t)( (uint32_t)( a ) - (uint32_t)( b ) ) )
 
 int jrq_Init( JobRingQueue* queue, size_t size )
 {
 	assert( queue != NULL );
 	assert( size > 0 );
 
-	queue->size = size;
-	queue->ringBuffer = mem_Allocate( sizeof( queue->ringBuffer[0] ) * size );
+	// need a power of two so we can mask the position instead of doing a modulo, and so the positions wrapping
+	//  around doesn't break anything
+	size_t pow2Size = 1;
+	while( pow2Size < size ) {
+		pow2Size <<= 1;
+	}
+
+	queue->size = pow2Size;
+	queue->mask = pow2Size - 1;
+	queue->ringBuffer = mem_Allocate( sizeof( queue->ringBuffer[0] ) * pow2Size );
 	if( queue->ringBuffer == NULL ) {
 		return -1;
 	}
-	memset( queue->ringBuffer, 0, size * sizeof( queue->ringBuffer[0] ) );
+	memset( queue->ringBuffer, 0, pow2Size * sizeof( queue->ringBuffer[0] ) );
+	for( size_t i = 0; i < pow2Size; ++i ) {
+		SDL_AtomicSet( &( queue->ringBuffer[i].sequence ), (int)i );
+	}
 	SDL_AtomicSet( &( queue->head ), 0 );
 	SDL_AtomicSet( &( queue->tail ), 0 );
 	SDL_AtomicSet( &( queue->busy ), 0 );
@@ -28,17 +49,79 @@ void jrq_CleanUp( JobRingQueue* queue )
 	assert( queue != NULL );
 
 	mem_Release( queue->ringBuffer );
+	queue->ringBuffer = NULL;
+}
+
+bool jrq_TryWrite( JobRingQueue* queue, Job* jobby )
+{
+	assert( queue != NULL );
+	assert( queue->ringBuffer != NULL );
+	assert( jobby != NULL );
+
+	int pos = SDL_AtomicGet( &( queue->head ) );
+	while( true ) {
+		JobRingQueueSlot* slot = &( queue->ringBuffer[(uint32_t)pos & queue->mask] );
+		int diff = POSITION_DIFF( SDL_AtomicGet( &( slot->sequence ) ), pos );
+
+		if( diff == 0 ) {
+			// slot is free, try to claim it
+			if( SDL_AtomicCAS( &( queue->head ), pos, pos + 1 ) ) {
+				slot->job = (*jobby);
+				// let the readers know the job is ready, the barrier makes sure the job is written before they see it
+				SDL_MemoryBarrierRelease( );
+				SDL_AtomicSet( &( slot->sequence ), pos + 1 );
+				return true;
+			}
+			pos = SDL_AtomicGet( &( queue->head ) );
+		} else if( diff < 0 ) {
+			// the slot still holds a job from the last time around, the queue is full
+			return false;
+		} else {
+			// another writer got here first
+			pos = SDL_AtomicGet( &( queue->head ) );
+		}
+	}
 }
 
 void jrq_Write( JobRingQueue* queue, Job* jobby )
 {
-	// TODO: Test to see if we're writing over the tail, and if we are then fail
-	bool writeSuccess = false;
-	while( !writeSuccess ) {
-		int idx = queue->head.value;
-		if( SDL_AtomicCAS( &( queue->head ), idx, ( idx + 1 ) % queue->size ) ) {
-			queue->ringBuffer[idx] = (*jobby);
-			writeSuccess = true;
+	int spins = 0;
+	while( !jrq_TryWrite( queue, jobby ) ) {
+		++spins;
+		if( spins >= WRITE_SPIN_COUNT ) {
+			SDL_Delay( 0 );
+			spins = 0;
+		}
+	}
+}
+
+bool jrq_Read( JobRingQueue* queue, Job* outJob )
+{
+	assert( queue != NULL );
+	assert( queue->ringBuffer != NULL );
+	assert( outJob != NULL );
+
+	int pos = SDL_AtomicGet( &( queue->tail ) );
+	while( true ) {
+		JobRingQueueSlot* slot = &( queue->ringBuffer[(uint32_t)pos & queue->mask] );
+		int diff = POSITION_DIFF( SDL_AtomicGet( &( slot->sequence ) ), pos + 1 );
+
+		if( diff == 0 ) {
+			// job is ready, try to claim it
+			if( SDL_AtomicCAS( &( queue->tail ), pos, pos + 1 ) ) {
+				(*outJob) = slot->job;
+				// let the writers know the slot can be used again the next time around
+				SDL_MemoryBarrierRelease( );
+				SDL_AtomicSet( &( slot->sequence ), pos + (int)queue->size );
+				return true;
+			}
+			pos = SDL_AtomicGet( &( queue->tail ) );
+		} else if( diff < 0 ) {
+			// nothing has been written here yet, the queue is empty
+			return false;
+		} else {
+			// another reader got here first
+			pos = SDL_AtomicGet( &( queue->tail ) );
 		}
 	}
 }
@@ -46,28 +129,239 @@ void jrq_Write( JobRingQueue* queue, Job* jobby )
 // do the next job available in the ring buffer, returns if anything was actually done
 bool jrq_ProcessNext( JobRingQueue* queue )
 {
-	int idx = queue->tail.value;
-	if( idx != queue->head.value ) {
-		if( SDL_AtomicCAS( &( queue->tail ), idx, ( idx + 1 ) % queue->size ) ) {
-			SDL_AtomicAdd( &( queue->busy ), 1 );
+	// mark as busy before the job is taken out so there's no point where the job isn't in the queue
+	//  but we're not counted as busy
+	SDL_AtomicAdd( &( queue->busy ), 1 );
 
-			if( queue->ringBuffer[idx].process != NULL ) queue->ringBuffer[idx].process( queue->ringBuffer[idx].data );
-			queue->ringBuffer[idx].process = NULL; // invalidate the job
+	// run the job after the slot has been given back so writers aren't waiting on it
+	Job job;
+	bool found = jrq_Read( queue, &job );
+	if( found && ( job.process != NULL ) ) {
+		job.process( job.data );
+	}
 
-			SDL_AtomicAdd( &( queue->busy ), -1 );
+	SDL_AtomicAdd( &( queue->busy ), -1 );
 
-			return true;
-		}
-	}
-	return false;
+	return found;
 }
 
 bool jrq_IsEmpty( JobRingQueue* queue )
 {
-	return ( queue->head.value == queue->tail.value );
+	return ( SDL_AtomicGet( &( queue->head ) ) == SDL_AtomicGet( &( queue->tail ) ) );
+}
+
+bool jrq_IsFull( JobRingQueue* queue )
+{
+	return ( POSITION_DIFF( SDL_AtomicGet( &( queue->head ) ), SDL_AtomicGet( &( queue->tail ) ) ) >= (int)queue->size );
 }
 
 bool jrq_IsBusy( JobRingQueue* queue )
 {
-	return ( queue->busy.value > 0 );
-}
\ No newline at end of file
+	return ( SDL_AtomicGet( &( queue->busy ) ) > 0 );
+}
+
+uint32_t jrq_Count( JobRingQueue* queue )
+{
+	int diff = POSITION_DIFF( SDL_AtomicGet( &( queue->head ) ), SDL_AtomicGet( &( queue->tail ) ) );
+	return ( diff > 0 ) ? (uint32_t)diff : 0;
+}
+
+// ***** Stress test
+typedef struct {
+	JobRingQueue* queue;
+	uint32_t firstJob;
+	uint32_t numJobs;
+	bool blocking;
+	uint32_t fullCount; // how many times a non-blocking write found the queue full
+} StressTestProducer;
+
+typedef struct {
+	JobRingQueue* queue;
+	SDL_atomic_t* jobsLeft;
+} StressTestConsumer;
+
+static uint8_t* stressTestRunCounts = NULL;
+static SDL_atomic_t stressTestJobsLeft;
+
+static void stressTestJob( void* data )
+{
+	// each job has it's own entry, so no other thread will be touching this
+	uint32_t idx = (uint32_t)(uintptr_t)data;
+	++( stressTestRunCounts[idx] );
+	SDL_AtomicAdd( &stressTestJobsLeft, -1 );
+}
+
+static int stressTestProducerThread( void* data )
+{
+	StressTestProducer* producer = (StressTestProducer*)data;
+
+	Job job;
+	job.process = stressTestJob;
+	job.counter = NULL;
+	for( uint32_t i = 0; i < producer->numJobs; ++i ) {
+		job.data = (void*)(uintptr_t)( producer->firstJob + i );
+		if( producer->blocking ) {
+			jrq_Write( producer->queue, &job );
+		} else {
+			while( !jrq_TryWrite( producer->queue, &job ) ) {
+				++( producer->fullCount );
+				SDL_Delay( 0 );
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int stressTestConsumerThread( void* data )
+{
+	StressTestConsumer* consumer = (StressTestConsumer*)data;
+
+	while( SDL_AtomicGet( consumer->jobsLeft ) > 0 ) {
+		if( !jrq_ProcessNext( consumer->queue ) ) {
+			SDL_Delay( 0 );
+		}
+	}
+
+	mem_ReleaseThreadCache( );
+
+	return 0;
+}
+
+#ifdef THREAD_SUPPORT
+// returns whether every job was run exactly once, how long it took and how many times the queue was full are put in
+//  outMS and outFullCount if they aren't NULL
+static bool runStressTest( uint8_t numProducers, uint8_t numConsumers, uint32_t jobsPerProducer, double* outMS, uint32_t* outFullCount )
+{
+	assert( numProducers > 0 );
+	assert( numConsumers > 0 );
+
+	JobRingQueue queue;
+	if( jrq_Init( &queue, 256 ) < 0 ) {
+		llog( LOG_ERROR, "Unable to create queue for stress test." );
+		return false;
+	}
+
+	uint32_t totalJobs = numProducers * jobsPerProducer;
+	stressTestRunCounts = mem_Allocate( totalJobs );
+	if( stressTestRunCounts == NULL ) {
+		llog( LOG_ERROR, "Unable to allocate run counts for stress test." );
+		jrq_CleanUp( &queue );
+		return false;
+	}
+	memset( stressTestRunCounts, 0, totalJobs );
+	SDL_AtomicSet( &stressTestJobsLeft, (int)totalJobs );
+
+	StressTestProducer producers[256];
+	StressTestConsumer consumers[256];
+	SDL_Thread* producerThreads[256];
+	SDL_Thread* consumerThreads[256];
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint8_t i = 0; i < numConsumers; ++i ) {
+		consumers[i].queue = &queue;
+		consumers[i].jobsLeft = &stressTestJobsLeft;
+		consumerThreads[i] = SDL_CreateThread( stressTestConsumerThread, "JRQ_Cnsmr", &( consumers[i] ) );
+		assert( consumerThreads[i] != NULL );
+	}
+
+	// half the producers block when the queue is full, the other half keep trying
+	for( uint8_t i = 0; i < numProducers; ++i ) {
+		producers[i].queue = &queue;
+		producers[i].firstJob = i * jobsPerProducer;
+		producers[i].numJobs = jobsPerProducer;
+		producers[i].blocking = ( ( i % 2 ) == 0 );
+		producers[i].fullCount = 0;
+		producerThreads[i] = SDL_CreateThread( stressTestProducerThread, "JRQ_Prdcr", &( producers[i] ) );
+		assert( producerThreads[i] != NULL );
+	}
+
+	for( uint8_t i = 0; i < numProducers; ++i ) {
+		SDL_WaitThread( producerThreads[i], NULL );
+	}
+	for( uint8_t i = 0; i < numConsumers; ++i ) {
+		SDL_WaitThread( consumerThreads[i], NULL );
+	}
+	if( outMS != NULL ) {
+		(*outMS) = test_MSSince( start );
+	}
+
+	bool allRunOnce = jrq_IsEmpty( &queue );
+	for( uint32_t i = 0; ( i < totalJobs ) && allRunOnce; ++i ) {
+		allRunOnce = ( stressTestRunCounts[i] == 1 );
+	}
+
+	if( outFullCount != NULL ) {
+		(*outFullCount) = 0;
+		for( uint8_t i = 0; i < numProducers; ++i ) {
+			(*outFullCount) += producers[i].fullCount;
+		}
+	}
+
+	mem_Release( stressTestRunCounts );
+	stressTestRunCounts = NULL;
+	jrq_CleanUp( &queue );
+
+	return allRunOnce;
+}
+#endif
+
+void jrq_RunTests( void )
+{
+	// fill a small queue and then empty it, the size is rounded up to a power of two
+	JobRingQueue queue;
+	TEST_CHECK( jrq_Init( &queue, 5 ) == 0, "job ring queue created" );
+	TEST_CHECK( queue.size == 8, "job ring queue size rounded up to a power of two" );
+	TEST_CHECK( jrq_IsEmpty( &queue ), "new job ring queue is empty" );
+
+	Job job;
+	job.process = NULL;
+	job.counter = NULL;
+	for( uintptr_t i = 0; i < 8; ++i ) {
+		job.data = (void*)i;
+		TEST_CHECK( jrq_TryWrite( &queue, &job ), "job written to job ring queue with room" );
+	}
+	TEST_CHECK( jrq_IsFull( &queue ), "job ring queue is full" );
+	TEST_CHECK( jrq_Count( &queue ) == 8, "job ring queue counts every job" );
+	TEST_CHECK( !jrq_TryWrite( &queue, &job ), "job not written to full job ring queue" );
+
+	for( uintptr_t i = 0; i < 8; ++i ) {
+		TEST_CHECK( jrq_Read( &queue, &job ) && ( job.data == (void*)i ), "jobs read from job ring queue in order" );
+	}
+	TEST_CHECK( jrq_IsEmpty( &queue ), "job ring queue is empty after reading everything" );
+	TEST_CHECK( !jrq_Read( &queue, &job ), "nothing read from empty job ring queue" );
+
+	// keep it partly full while the positions wrap around the buffer a few times
+	for( uintptr_t i = 0; i < 3; ++i ) {
+		job.data = (void*)i;
+		jrq_TryWrite( &queue, &job );
+	}
+	for( uintptr_t i = 3; i < 40; ++i ) {
+		job.data = (void*)i;
+		TEST_CHECK( jrq_TryWrite( &queue, &job ), "job written to wrapped job ring queue" );
+		TEST_CHECK( jrq_Read( &queue, &job ) && ( job.data == (void*)( i - 3 ) ), "jobs read from wrapped job ring queue in order" );
+	}
+	jrq_CleanUp( &queue );
+
+#ifdef THREAD_SUPPORT
+	TEST_CHECK( runStressTest( 2, 2, 10000, NULL, NULL ), "every job written from several threads run exactly once" );
+#endif
+}
+
+void jrq_RunStressTest( uint8_t numProducers, uint8_t numConsumers, uint32_t jobsPerProducer )
+{
+#ifdef THREAD_SUPPORT
+	double ms = 0.0;
+	uint32_t fullCount = 0;
+	bool allRunOnce = runStressTest( numProducers, numConsumers, jobsPerProducer, &ms, &fullCount );
+
+	uint32_t totalJobs = numProducers * jobsPerProducer;
+	llog( LOG_INFO, "Job ring queue stress test: %i producers, %i consumers, %u jobs", numProducers, numConsumers, totalJobs );
+	llog( LOG_INFO, "  Time: %.3f ms", ms );
+	llog( LOG_INFO, "  Jobs per ms: %.1f", (double)totalJobs / ms );
+	llog( LOG_INFO, "  Times queue was full: %u", fullCount );
+	TEST_CHECK( allRunOnce, "every job in the stress test run exactly once" );
+#else
+	llog( LOG_INFO, "Compiled without support for threads, job ring queue stress test not run." );
+#endif
+}
@@ -1,30 +1,72 @@
 #ifndef JOB_RING_QUEUE_H
 #define JOB_RING_QUEUE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <SDL_atomic.h>
 
 typedef void (*JobProcessFunc)( void* );
 
+struct JobCounter;
+
 typedef struct {
 	JobProcessFunc process;
 	void* data; // should we make a copy of the data to put in here?
+	struct JobCounter* counter; // counted down when the job is finished, can be NULL, handled by the job queue
 } Job;
 
-// fixed size, thread safe ring buffer based queue
+// the sequence says what state the slot is in, if it matches the position being written to then the slot is free,
+//  if it's one past the position being read from then a job has been written to it and is ready to be read
+typedef struct {
+	SDL_atomic_t sequence;
+	Job job;
+} JobRingQueueSlot;
+
+#define JRQ_CACHE_LINE_SIZE 64
+
+// fixed size, thread safe ring buffer based queue, any number of threads can write and read at the same time
+//  the size is rounded up to a power of two
 typedef struct {
 	size_t size;
-	Job* ringBuffer;
-	SDL_atomic_t head;
-	SDL_atomic_t tail;
+	size_t mask;
+	JobRingQueueSlot* ringBuffer;
+
+	// head and tail are on their own cache lines so readers and writers don't fight over them
+	uint8_t padding0[JRQ_CACHE_LINE_SIZE];
+	SDL_atomic_t head; // next position to write to
+	uint8_t padding1[JRQ_CACHE_LINE_SIZE - sizeof( SDL_atomic_t )];
+	SDL_atomic_t tail; // next position to read from
+	uint8_t padding2[JRQ_CACHE_LINE_SIZE - sizeof( SDL_atomic_t )];
 	SDL_atomic_t busy; // a count of how many jobs are currently being processed
 } JobRingQueue;
 
 int jrq_Init( JobRingQueue* queue, size_t size );
 void jrq_CleanUp( JobRingQueue* queue );
+// adds the job to the queue, returns false if the queue is full
+bool jrq_TryWrite( JobRingQueue* queue, Job* jobby );
+// adds the job to the queue, if the queue is full this will wait until another thread makes room
+//  don't call this from the only thread that reads from the queue
 void jrq_Write( JobRingQueue* queue, Job* jobby );
+// takes the next job out of the ring buffer without running it, returns false if the queue is empty
+bool jrq_Read( JobRingQueue* queue, Job* outJob );
 // do the next job available in the ring buffer, returns if anything was actually done
+//  this only runs the job, it doesn't touch the job's counter
 bool jrq_ProcessNext( JobRingQueue* queue );
 bool jrq_IsEmpty( JobRingQueue* queue );
+bool jrq_IsFull( JobRingQueue* queue );
 bool jrq_IsBusy( JobRingQueue* queue );
+// how many jobs are waiting, only a snapshot if other threads are using the queue
+uint32_t jrq_Count( JobRingQueue* queue );
+
+// checks the queue detects when it's full and empty and keeps jobs in order, and that jobs written and read from
+//  several threads at once are all run exactly once, asserting if anything fails
+//  uses the main memory, so mem_Init( ) must have been called
+void jrq_RunTests( void );
+
+// pushes jobsPerProducer jobs from each producer thread through a queue while the consumer threads process them,
+//  checks that every job was run exactly once and logs the timing
+//  uses the main memory, so mem_Init( ) must have been called
+void jrq_RunStressTest( uint8_t numProducers, uint8_t numConsumers, uint32_t jobsPerProducer );
 
 #endif /* inclusion guard */
\ No newline at end of file
@@ -5,8 +5,12 @@
 #include <string.h>
 #include <SDL_stdinc.h>
 #include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
 
 #include "platformLog.h"
+#include "random.h"
+#include "testing.h"
 
 /*
 If we know the initial address is aligned, and the address for the data is aligned, and the size is aligned
@@ -41,14 +45,43 @@ jump for the delete. Just need to align the size of the header.
 #define MIN_ALLOC_SIZE ( ALIGN ) // this needs to at least fit the alignment in bytes
 
 #define IN_USE_FLAG ( 1 << 31 )
+#define BINNED_FLAG ( 1 << 30 ) // not in use, but held in a size class bin so it won't be merged with it's neighbors
 
-// debug flags
+// allocations of this size or smaller are handed out from the size class bins instead of searching the block list
+//  each class is a multiple of ALIGN, so the bin index can be found directly from the aligned size
+#define SMALL_ALLOC_MAX 1024
+#define NUM_SIZE_CLASSES ( SMALL_ALLOC_MAX / ALIGN )
+#define SIZE_CLASS_IDX( s ) ( ( ( s ) / ALIGN ) - 1 )
+
+// when a bin is empty we carve roughly this many bytes worth of blocks for it at once
+#define BIN_REFILL_SIZE ( 16 * 1024 )
+
+// each thread keeps it's own small bins so it can allocate and release without taking the lock, blocks are moved
+//  between the thread and the shared bins in batches, when a thread is holding more than the max it gives half back
+#define THREAD_CACHE_BATCH 16
+#define THREAD_CACHE_MAX ( THREAD_CACHE_BATCH * 4 )
+
+// debug flags, the profile decides which of these are used, see memory.h
 //#define TEST_CLEAR_VALUES
-#define LOG_MEMORY_ALLOCATIONS
-#define TEST_EVERY_CHANGE
+#if MEMORY_PROFILE == MEMORY_PROFILE_DEBUG
+	#define LOG_MEMORY_ALLOCATIONS
+	#define TEST_EVERY_CHANGE
+	#define USE_GUARD_VALUES
+#elif MEMORY_PROFILE == MEMORY_PROFILE_CHECKED
+	#define TEST_CHANGED_BLOCKS
+	#define USE_GUARD_VALUES
+#endif
+
+// blocks only have their headers changed when they move in and out of a thread cache, while cached they look in use to
+//  everything else, so the debug profile skips the caches to keep exact allocation info and catch double releases
+#if defined( THREAD_SUPPORT ) && !defined( LOG_MEMORY_ALLOCATIONS )
+	#define USE_THREAD_CACHE
+#endif
 
 typedef struct MemoryBlockHeader {
+#ifdef USE_GUARD_VALUES
 	uint32_t guardValue;
+#endif
 
 	struct MemoryBlockHeader* next;
 	struct MemoryBlockHeader* prev;
@@ -56,6 +89,10 @@ typedef struct MemoryBlockHeader {
 	uint32_t flags;
 	size_t size; // the amount of memory this block stores
 
+	// links for the list of free blocks, only valid when the block isn't in use or binned
+	struct MemoryBlockHeader* nextFree;
+	struct MemoryBlockHeader* prevFree;
+
 	// last file and line in that file that modified this block
 #ifdef LOG_MEMORY_ALLOCATIONS
 	char file[256];
@@ -63,9 +100,19 @@ typedef struct MemoryBlockHeader {
 	char note[32];
 #endif
 
+#ifdef USE_GUARD_VALUES
 	uint32_t postGuardValue;
+#endif
 } MemoryBlockHeader;
 
+#ifdef USE_GUARD_VALUES
+	#define GUARDS_VALID( h ) ( ( ( h )->guardValue == GUARD_VALUE ) && ( ( h )->postGuardValue == GUARD_VALUE ) )
+	#define SET_GUARDS( h ) { ( h )->guardValue = GUARD_VALUE; ( h )->postGuardValue = GUARD_VALUE; }
+#else
+	#define GUARDS_VALID( h ) ( true )
+	#define SET_GUARDS( h )
+#endif
+
 #ifdef THREAD_SUPPORT
 	#define LOCK_MEMORY_MUTEX( ) SDL_LockMutex( memoryBlock.mutex )
 	#define UNLOCK_MEMORY_MUTEX( ) SDL_UnlockMutex( memoryBlock.mutex )
@@ -85,9 +132,27 @@ typedef struct {
 
 	void* watchedAddress;
 	MemoryBlockHeader* watchedHeader;
-} MemoryArena;
 
-static MemoryArena memoryBlock;
+	// all the blocks that are free, so searching for a spot doesn't have to step over blocks that are in use
+	MemoryBlockHeader* freeList;
+
+	// singly linked lists of free blocks for each size class, the link is stored in the data of the block
+	MemoryBlockHeader* bins[NUM_SIZE_CLASSES];
+
+	// changes every time the memory is initialized, lets threads know any blocks they're holding are no longer valid
+	uint32_t generation;
+} MemoryHeap;
+
+typedef struct {
+	MemoryBlockHeader* bins[NUM_SIZE_CLASSES];
+	uint32_t counts[NUM_SIZE_CLASSES];
+	uint32_t generation;
+} ThreadCache;
+
+static MemoryHeap memoryBlock;
+static uint32_t lastGeneration = 0; // kept outside the heap so restoring an old heap never reuses a generation
+
+MemoryArena frameArena;
 
 static void* watchedAddress = NULL;
 static MemoryBlockHeader* watchedHeader = NULL;
@@ -102,6 +167,39 @@ static void* alignAddress( void* addr )
 
 #define MEMORY_HEADER_SIZE ( ALIGN_SIZE( sizeof( MemoryBlockHeader ) ) )
 
+// a block that can be merged with others or claimed by the first fit search
+#define IS_BLOCK_FREE( h ) ( !( ( h )->flags & ( IN_USE_FLAG | BINNED_FLAG ) ) )
+
+// where the next block in a size class bin is stored
+#define BIN_NEXT( h ) ( *(MemoryBlockHeader**)( (uintptr_t)( h ) + MEMORY_HEADER_SIZE ) )
+
+static void addToFreeList( MemoryBlockHeader* header )
+{
+	header->prevFree = NULL;
+	header->nextFree = memoryBlock.freeList;
+	if( memoryBlock.freeList != NULL ) {
+		memoryBlock.freeList->prevFree = header;
+	}
+	memoryBlock.freeList = header;
+}
+
+static void removeFromFreeList( MemoryBlockHeader* header )
+{
+	if( header->prevFree != NULL ) {
+		header->prevFree->nextFree = header->nextFree;
+	} else {
+		assert( memoryBlock.freeList == header );
+		memoryBlock.freeList = header->nextFree;
+	}
+
+	if( header->nextFree != NULL ) {
+		header->nextFree->prevFree = header->prevFree;
+	}
+
+	header->nextFree = NULL;
+	header->prevFree = NULL;
+}
+
 static MemoryBlockHeader* findMemoryBlock( void* ptr, bool ensureInUse )
 {
 	MemoryBlockHeader* block = NULL;
@@ -126,18 +224,21 @@ static void memoryBlockLogDump( MemoryBlockHeader* header )
 {
 	if( header != NULL ) {
 		llog( LOG_DEBUG, " Memory header: 0x%p", header );
+#ifdef USE_GUARD_VALUES
 		if( header->guardValue != GUARD_VALUE ) {
 			llog( LOG_DEBUG, " ! Memory was corrupted from beginning" );
 		} else if( header->postGuardValue != GUARD_VALUE ) {
 			llog( LOG_DEBUG, " ! Memory was corrupted from end" );
-		} else {
+		} else
+#endif
+		{
 #ifdef LOG_MEMORY_ALLOCATIONS
 			llog( LOG_DEBUG, "  File: %s", header->file );
 			llog( LOG_DEBUG, "   Line: %i", header->line );
 			llog( LOG_DEBUG, "   Note: %s", header->note );
 #endif
 			llog( LOG_DEBUG, "  Size: %u", header->size );
-			llog( LOG_DEBUG, "  In Use: %s", ( header->flags & IN_USE_FLAG ) ? "YES" : "no" );
+			llog( LOG_DEBUG, "  In Use: %s", ( header->flags & IN_USE_FLAG ) ? "YES" : ( ( header->flags & BINNED_FLAG ) ? "binned" : "no" ) );
 			llog( LOG_DEBUG, "  Start addr: 0x" PRIxPTR "p", (uintptr_t)header + MEMORY_HEADER_SIZE );
 			llog( LOG_DEBUG, "  End addr: 0x" PRIxPTR "p", (uintptr_t)header + MEMORY_HEADER_SIZE + header->size );
 		}
@@ -146,6 +247,53 @@ static void memoryBlockLogDump( MemoryBlockHeader* header )
 	}
 }
 
+#ifdef TEST_CHANGED_BLOCKS
+static void reportBadBlock( MemoryBlockHeader* header, const char* problem, const char* fileName, int line )
+{
+	llog( LOG_ERROR, "Memory block problem found in %s at line %i: %s", fileName, line, problem );
+	memoryBlockLogDump( header );
+	assert( false );
+}
+
+// only looks at the guards of the block, used when the block belongs to the calling thread but the lock isn't held
+static void checkBlockGuards( MemoryBlockHeader* header, const char* fileName, int line )
+{
+	if( !GUARDS_VALID( header ) ) {
+		reportBadBlock( header, "guard values overwritten", fileName, line );
+	}
+}
+
+// looks at the block and the blocks next to it, much cheaper than verifying everything but will still catch most
+//  overruns and double releases close to where they happen, the memory lock must be held
+static void checkChangedBlock( MemoryBlockHeader* header, const char* fileName, int line )
+{
+	checkBlockGuards( header, fileName, line );
+
+	if( header->prev != NULL ) {
+		if( !GUARDS_VALID( header->prev ) ) {
+			reportBadBlock( header->prev, "guard values of previous block overwritten", fileName, line );
+		} else if( header->prev->next != header ) {
+			reportBadBlock( header, "previous block doesn't link to this block", fileName, line );
+		}
+	} else if( header != (MemoryBlockHeader*)memoryBlock.memory ) {
+		reportBadBlock( header, "block has no previous block but isn't the first block", fileName, line );
+	}
+
+	if( header->next != NULL ) {
+		if( !GUARDS_VALID( header->next ) ) {
+			reportBadBlock( header->next, "guard values of next block overwritten", fileName, line );
+		} else if( header->next->prev != header ) {
+			reportBadBlock( header, "next block doesn't link to this block", fileName, line );
+		}
+	}
+}
+	#define CHECK_BLOCK_GUARDS( h, f, l ) checkBlockGuards( (h), (f), (l) )
+	#define CHECK_CHANGED_BLOCK( h, f, l ) checkChangedBlock( (h), (f), (l) )
+#else
+	#define CHECK_BLOCK_GUARDS( h, f, l )
+	#define CHECK_CHANGED_BLOCK( h, f, l )
+#endif
+
 #ifdef TEST_CLEAR_VALUES
 static void testingSetMemory( void* start, size_t size, uint8_t val )
 {
@@ -209,17 +357,18 @@ static void logWatchedMemoryAddressChange( MemoryBlockHeader* header, void* ptr,
 static MemoryBlockHeader* condenseMemoryBlocks( MemoryBlockHeader* start, const char* fileName, int line )
 {
 	assert( start != NULL );
-	assert( !( start->flags & IN_USE_FLAG ) );
+	assert( IS_BLOCK_FREE( start ) );
 
 	// find the earliest block that's not in use
-	while( ( start->prev != NULL ) && !( start->prev->flags & IN_USE_FLAG ) ) {
+	while( ( start->prev != NULL ) && IS_BLOCK_FREE( start->prev ) ) {
 		start = start->prev;
 	}
 
 	// going to the right, merge unused blocks
-	while( ( start->next != NULL ) && !( start->next->flags & IN_USE_FLAG ) ) {
+	while( ( start->next != NULL ) && IS_BLOCK_FREE( start->next ) ) {
 		setMemoryBlockInfo( start, fileName, line, "Condense" );
 		MemoryBlockHeader* nextHeader = start->next;
+		removeFromFreeList( nextHeader );
 		start->size += nextHeader->size + MEMORY_HEADER_SIZE;
 		start->next = nextHeader->next;
 		if( start->next != NULL ) {
@@ -234,8 +383,7 @@ static MemoryBlockHeader* createNewBlock( void* start, MemoryBlockHeader* prev,
 {
 	MemoryBlockHeader* header = (MemoryBlockHeader*)start;
 
-	header->guardValue = GUARD_VALUE;
-	header->postGuardValue = GUARD_VALUE;
+	SET_GUARDS( header );
 	header->flags = 0;
 	header->size = size;
 
@@ -251,6 +399,8 @@ static MemoryBlockHeader* createNewBlock( void* start, MemoryBlockHeader* prev,
 
 	setMemoryBlockInfo( header, fileName, line, "Create" );
 
+	addToFreeList( header );
+
 	return header;
 }
 
@@ -269,7 +419,7 @@ static void* growBlock( MemoryBlockHeader* header, size_t newSize, const char* f
 	//  it allow enough space to expand
 	size_t sizeAllowed = header->size;
 	MemoryBlockHeader* scan = header->next;
-	while( ( scan != NULL ) && !( scan->flags & IN_USE_FLAG ) ) {
+	while( ( scan != NULL ) && IS_BLOCK_FREE( scan ) ) {
 		sizeAllowed += scan->size + MEMORY_HEADER_SIZE;
 		scan = scan->next;
 	}
@@ -278,8 +428,9 @@ static void* growBlock( MemoryBlockHeader* header, size_t newSize, const char* f
 		// claim all the next headers
 		result = (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE );
 		scan = header->next;
-		while( ( scan != NULL ) && !( scan->flags & IN_USE_FLAG ) ) {
+		while( ( scan != NULL ) && IS_BLOCK_FREE( scan ) ) {
 			// unlink the scan block
+			removeFromFreeList( scan );
 			if( scan->next != NULL ) scan->next->prev = scan->prev;
 			/*if( scan->prev != NULL ) scan->prev->next = scan->next; */
 			header->next = scan->next;
@@ -336,6 +487,329 @@ static void* shrinkBlock( MemoryBlockHeader* header, size_t newSize, const char*
 	return (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE );
 }
 
+// finds the first block that is free and can hold size bytes, returns NULL if there is none
+static MemoryBlockHeader* findFreeBlock( size_t size )
+{
+	MemoryBlockHeader* header = memoryBlock.freeList;
+	while( ( header != NULL ) && ( header->size < size ) ) {
+		header = header->nextFree;
+	}
+	return header;
+}
+
+// marks the block as in use, if there's enough room left then split it into it's own block
+static void* claimBlock( MemoryBlockHeader* header, size_t size, const char* fileName, int line )
+{
+	if( IS_BLOCK_FREE( header ) ) {
+		removeFromFreeList( header );
+	}
+	header->flags |= IN_USE_FLAG;
+
+	uint8_t* result = (uint8_t*)header;
+	result += MEMORY_HEADER_SIZE;
+
+	testingSetMemory( (void*)result, size, 0xCC );
+
+	if( header->size >= ( size + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE ) ) {
+		MemoryBlockHeader* nextHeader = createNewBlock( (void*)( result + size ),
+			header, header->next, header->size - size - MEMORY_HEADER_SIZE,
+			fileName, line );
+		testingSetMemory( (void*)( (uintptr_t)nextHeader + MEMORY_HEADER_SIZE ), nextHeader->size, 0xDD );
+		header->size = size;
+	} else {
+		// there's some left over memory, we'll just put it into the block
+		testingSetMemory( (void*)( result + size ), header->size - size, 0xEE );
+	}
+
+	setMemoryBlockInfo( header, fileName, line, "Allocate" );
+
+	return (void*)result;
+}
+
+static void pushToBin( MemoryBlockHeader* header )
+{
+	assert( header->size <= SMALL_ALLOC_MAX );
+	assert( ( header->size % ALIGN ) == 0 );
+
+	int idx = SIZE_CLASS_IDX( header->size );
+	if( IS_BLOCK_FREE( header ) ) {
+		removeFromFreeList( header );
+	}
+	header->flags = ( header->flags & ~IN_USE_FLAG ) | BINNED_FLAG;
+	BIN_NEXT( header ) = memoryBlock.bins[idx];
+	memoryBlock.bins[idx] = header;
+}
+
+static MemoryBlockHeader* popFromBin( size_t size )
+{
+	int idx = SIZE_CLASS_IDX( size );
+	MemoryBlockHeader* header = memoryBlock.bins[idx];
+	if( header != NULL ) {
+		assert( GUARDS_VALID( header ) );
+		assert( header->flags & BINNED_FLAG );
+		memoryBlock.bins[idx] = BIN_NEXT( header );
+		header->flags = ( header->flags & ~BINNED_FLAG ) | IN_USE_FLAG;
+	}
+	return header;
+}
+
+// carves a run of blocks of the passed in size out of a single free block and puts them all into the bin
+//  returns if any blocks were able to be created
+static bool refillBin( size_t size, const char* fileName, int line )
+{
+	size_t stride = size + MEMORY_HEADER_SIZE;
+	size_t count = BIN_REFILL_SIZE / stride;
+	if( count == 0 ) count = 1;
+
+	// ideally we get the whole run at once, but if memory is tight settle for what we can find
+	MemoryBlockHeader* source = findFreeBlock( ( count * stride ) - MEMORY_HEADER_SIZE );
+	if( source == NULL ) {
+		source = findFreeBlock( size );
+		if( source == NULL ) {
+			return false;
+		}
+		count = ( source->size + MEMORY_HEADER_SIZE ) / stride;
+	}
+
+	removeFromFreeList( source );
+	MemoryBlockHeader* prev = source->prev;
+	MemoryBlockHeader* next = source->next;
+	size_t remaining = source->size + MEMORY_HEADER_SIZE;
+	uint8_t* start = (uint8_t*)source;
+	for( size_t i = 0; i < count; ++i ) {
+		prev = createNewBlock( start, prev, NULL, size, fileName, line );
+		start += stride;
+		remaining -= stride;
+	}
+
+	if( remaining >= ( MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE ) ) {
+		// whatever is left is turned back into a free block
+		createNewBlock( start, prev, next, remaining - MEMORY_HEADER_SIZE, fileName, line );
+	} else {
+		// not enough for a block, the last one in the run takes it
+		prev->size += remaining;
+		prev->next = next;
+		if( next != NULL ) {
+			next->prev = prev;
+		}
+	}
+
+	// push them in reverse so the lowest address is handed out first, if the last one took the left over
+	//  memory and is no longer a small block it's just left as a free block
+	MemoryBlockHeader* header = prev;
+	for( size_t i = 0; i < count; ++i ) {
+		MemoryBlockHeader* before = header->prev;
+		if( header->size <= SMALL_ALLOC_MAX ) {
+			pushToBin( header );
+		}
+		header = before;
+	}
+
+	return true;
+}
+
+#ifdef USE_THREAD_CACHE
+static void internal_verify( void );
+static void drainThreadCache( ThreadCache* cache );
+
+static SDL_TLSID threadCacheID = 0;
+
+// called when a thread exits, anything it's still holding goes back to the shared bins
+static void destroyThreadCache( void* data )
+{
+	ThreadCache* cache = (ThreadCache*)data;
+	if( ( memoryBlock.memory != NULL ) && ( cache->generation == memoryBlock.generation ) ) {
+		LOCK_MEMORY_MUTEX( ); {
+			drainThreadCache( cache );
+		} UNLOCK_MEMORY_MUTEX( );
+	}
+	SDL_free( data );
+}
+
+// gets the cache for the calling thread, creating it if this is the first time the thread has used it
+static ThreadCache* getThreadCache( void )
+{
+	ThreadCache* cache = (ThreadCache*)SDL_TLSGet( threadCacheID );
+	if( cache == NULL ) {
+		cache = (ThreadCache*)SDL_malloc( sizeof( ThreadCache ) );
+		if( cache == NULL ) {
+			return NULL;
+		}
+		memset( cache, 0, sizeof( ThreadCache ) );
+		cache->generation = memoryBlock.generation;
+		SDL_TLSSet( threadCacheID, cache, destroyThreadCache );
+	}
+
+	// the memory was reinitialized since this thread last used it, anything it was holding is gone
+	if( cache->generation != memoryBlock.generation ) {
+		memset( cache, 0, sizeof( ThreadCache ) );
+		cache->generation = memoryBlock.generation;
+	}
+
+	return cache;
+}
+
+// moves up to count blocks from the thread cache back into the shared bins, assumes the lock is held
+static void returnCachedBlocks( ThreadCache* cache, int idx, uint32_t count )
+{
+	while( ( count > 0 ) && ( cache->bins[idx] != NULL ) ) {
+		MemoryBlockHeader* header = cache->bins[idx];
+		cache->bins[idx] = BIN_NEXT( header );
+		--( cache->counts[idx] );
+		--count;
+
+		header->flags |= BINNED_FLAG;
+		header->flags &= ~IN_USE_FLAG;
+		BIN_NEXT( header ) = memoryBlock.bins[idx];
+		memoryBlock.bins[idx] = header;
+	}
+}
+
+// moves a batch of blocks from the shared bins into the thread cache, assumes the lock is held
+static void fillThreadCache( ThreadCache* cache, size_t size, const char* fileName, int line )
+{
+	int idx = SIZE_CLASS_IDX( size );
+	for( int i = 0; i < THREAD_CACHE_BATCH; ++i ) {
+		if( ( memoryBlock.bins[idx] == NULL ) && !refillBin( size, fileName, line ) ) {
+			return;
+		}
+
+		// the refill can end up putting nothing in this bin if the block it carved from was too small
+		MemoryBlockHeader* header = memoryBlock.bins[idx];
+		if( header == NULL ) {
+			return;
+		}
+
+		// set in use before clearing binned so anyone looking at this block never sees it as free
+		header->flags |= IN_USE_FLAG;
+		header->flags &= ~BINNED_FLAG;
+		setMemoryBlockInfo( header, fileName, line, "Cached" );
+
+		memoryBlock.bins[idx] = BIN_NEXT( header );
+		BIN_NEXT( header ) = cache->bins[idx];
+		cache->bins[idx] = header;
+		++( cache->counts[idx] );
+	}
+}
+
+static void drainThreadCache( ThreadCache* cache )
+{
+	for( int i = 0; i < NUM_SIZE_CLASSES; ++i ) {
+		returnCachedBlocks( cache, i, cache->counts[i] );
+	}
+}
+
+// allocates a small block using only the calling thread's cache if possible, otherwise grabs a batch from the
+//  shared bins, the header isn't touched here since other threads can be reading it while holding the lock
+static void* threadCacheAllocate( ThreadCache* cache, size_t size, const char* fileName, int line )
+{
+	int idx = SIZE_CLASS_IDX( size );
+	if( cache->bins[idx] == NULL ) {
+		LOCK_MEMORY_MUTEX( ); {
+#ifdef TEST_EVERY_CHANGE
+			internal_verify( );
+#endif
+			fillThreadCache( cache, size, fileName, line );
+		} UNLOCK_MEMORY_MUTEX( );
+
+		if( cache->bins[idx] == NULL ) {
+			return NULL;
+		}
+	}
+
+	MemoryBlockHeader* header = cache->bins[idx];
+	assert( GUARDS_VALID( header ) );
+	assert( header->flags & IN_USE_FLAG );
+	cache->bins[idx] = BIN_NEXT( header );
+	--( cache->counts[idx] );
+
+	void* result = (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE );
+	testingSetMemory( result, header->size, 0xCC );
+	return result;
+}
+
+// the block stays marked in use until it's given back to the shared bins
+static void threadCacheRelease( ThreadCache* cache, MemoryBlockHeader* header )
+{
+	int idx = SIZE_CLASS_IDX( header->size );
+
+	testingSetMemory( (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE ), header->size, 0xAB );
+
+	BIN_NEXT( header ) = cache->bins[idx];
+	cache->bins[idx] = header;
+	++( cache->counts[idx] );
+
+	if( cache->counts[idx] > THREAD_CACHE_MAX ) {
+		LOCK_MEMORY_MUTEX( ); {
+			returnCachedBlocks( cache, idx, THREAD_CACHE_MAX / 2 );
+#ifdef TEST_EVERY_CHANGE
+			internal_verify( );
+#endif
+		} UNLOCK_MEMORY_MUTEX( );
+	}
+}
+#endif
+
+// releases everything held in the bins back to the block list and merges them with their neighbors
+//  used when the first fit search fails so cached small blocks can't starve large allocations
+static void flushBins( const char* fileName, int line )
+{
+#ifdef USE_THREAD_CACHE
+	// we can only safely take back what the calling thread is holding
+	ThreadCache* cache = getThreadCache( );
+	if( cache != NULL ) {
+		drainThreadCache( cache );
+	}
+#endif
+
+	for( int i = 0; i < NUM_SIZE_CLASSES; ++i ) {
+		MemoryBlockHeader* header = memoryBlock.bins[i];
+		while( header != NULL ) {
+			MemoryBlockHeader* next = BIN_NEXT( header );
+			header->flags &= ~BINNED_FLAG;
+			addToFreeList( header );
+			header = next;
+		}
+		memoryBlock.bins[i] = NULL;
+	}
+
+	MemoryBlockHeader* header = (MemoryBlockHeader*)( memoryBlock.memory );
+	while( header != NULL ) {
+		if( IS_BLOCK_FREE( header ) ) {
+			header = condenseMemoryBlocks( header, fileName, line );
+		}
+		header = header->next;
+	}
+}
+
+static void* internal_allocate_Data( size_t size, const char* fileName, const int line )
+{
+	size = ALIGN_SIZE( size );
+
+	MemoryBlockHeader* header = NULL;
+	if( size <= SMALL_ALLOC_MAX ) {
+		header = popFromBin( size );
+		if( ( header == NULL ) && refillBin( size, fileName, line ) ) {
+			header = popFromBin( size );
+		}
+	}
+
+	if( header == NULL ) {
+		// we'll just do first fit, if we can't find a spot we'll just return NULL
+		header = findFreeBlock( size );
+		if( header == NULL ) {
+			flushBins( fileName, line );
+			header = findFreeBlock( size );
+		}
+	}
+
+	if( header == NULL ) {
+		return NULL;
+	}
+
+	return claimBlock( header, size, fileName, line );
+}
+
 static void internal_log( void )
 {
 	llog( LOG_DEBUG, "=== Memory Use Log ===" );
@@ -363,9 +837,9 @@ static void internal_verify( void )
 	//  also make sure all the previous and next pointers are correct
 	MemoryBlockHeader* header = (MemoryBlockHeader*)( memoryBlock.memory );
 	bool firstBlock = true;
+	size_t numFree = 0;
 	while( header != NULL ) {
-		assert( header->guardValue == GUARD_VALUE );
-		assert( header->postGuardValue == GUARD_VALUE );
+		assert( GUARDS_VALID( header ) );
 
 		if( header->prev != NULL ) {
 			assert( header->prev->next == header );
@@ -377,9 +851,39 @@ static void internal_verify( void )
 			assert( header->next->prev == header );
 		}
 
+		if( IS_BLOCK_FREE( header ) ) {
+			++numFree;
+		}
+
 		header = header->next;
 		firstBlock = false;
 	}
+
+	// make sure the free list holds all the free blocks and nothing else
+	header = memoryBlock.freeList;
+	while( header != NULL ) {
+		assert( GUARDS_VALID( header ) );
+		assert( IS_BLOCK_FREE( header ) );
+		if( header->nextFree != NULL ) {
+			assert( header->nextFree->prevFree == header );
+		}
+		assert( numFree > 0 );
+		--numFree;
+		header = header->nextFree;
+	}
+	assert( numFree == 0 );
+
+	// make sure everything in the bins is in the correct bin and wasn't handed out
+	for( int i = 0; i < NUM_SIZE_CLASSES; ++i ) {
+		header = memoryBlock.bins[i];
+		while( header != NULL ) {
+			assert( GUARDS_VALID( header ) );
+			assert( header->flags & BINNED_FLAG );
+			assert( !( header->flags & IN_USE_FLAG ) );
+			assert( SIZE_CLASS_IDX( header->size ) == i );
+			header = BIN_NEXT( header );
+		}
+	}
 }
 
 static bool internal_getVerify( void )
@@ -387,10 +891,7 @@ static bool internal_getVerify( void )
 	// just follow the list, verifying that the guard value is correct
 	MemoryBlockHeader* header = (MemoryBlockHeader*)( memoryBlock.memory );
 	while( header != NULL ) {
-		if( header->guardValue != GUARD_VALUE ) {
-			return false;
-		}
-		if( header->postGuardValue != GUARD_VALUE ) {
+		if( !GUARDS_VALID( header ) ) {
 			return false;
 		}
 		header = header->next;
@@ -446,6 +947,13 @@ static void internal_report( void )
 	llog( LOG_DEBUG, "  In Use: %u", inUse );
 	llog( LOG_DEBUG, "  Overhead: %u", overhead );
 	llog( LOG_DEBUG, "  Fragments: %u", fragments );
+
+	if( frameArena.memory != NULL ) {
+		llog( LOG_DEBUG, "Frame Arena Report:" );
+		llog( LOG_DEBUG, "  Size: %u", frameArena.size );
+		llog( LOG_DEBUG, "  Last Frame High Water Mark: %u", frameArena.lastHighWaterMark );
+		llog( LOG_DEBUG, "  Peak High Water Mark: %u", frameArena.peakHighWaterMark );
+	}
 }
 
 static void internal_release_Data( void* memory, const char* fileName, const int line )
@@ -459,17 +967,25 @@ static void internal_release_Data( void* memory, const char* fileName, const int
 		return;
 	}
 	
-	// set the associated block as not in use, and merge with nearby blocks if they're
-	//  not in use
+	// small blocks go back into their size class bin, anything else is set as not in use and
+	//  merged with nearby blocks if they're not in use
 	MemoryBlockHeader* header = (MemoryBlockHeader*)( (uintptr_t)memory - MEMORY_HEADER_SIZE );
 	logWatchedMemoryAddressChange( header, "mem_Release_Data", NULL );
-	header->flags &= ~IN_USE_FLAG;
 
-	assert( header->guardValue == GUARD_VALUE );
-	assert( header->postGuardValue == GUARD_VALUE );
-	
-	header = condenseMemoryBlocks( header, fileName, line );
-	testingSetMemory( (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE ), header->size, 0xAB );
+	CHECK_CHANGED_BLOCK( header, fileName, line );
+	assert( GUARDS_VALID( header ) );
+	assert( header->flags & IN_USE_FLAG );
+
+	if( header->size <= SMALL_ALLOC_MAX ) {
+		testingSetMemory( (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE ), header->size, 0xAB );
+		setMemoryBlockInfo( header, fileName, line, "Binned" );
+		pushToBin( header );
+	} else {
+		header->flags &= ~IN_USE_FLAG;
+		addToFreeList( header );
+		header = condenseMemoryBlocks( header, fileName, line );
+		testingSetMemory( (void*)( (uintptr_t)header + MEMORY_HEADER_SIZE ), header->size, 0xAB );
+	}
 
 #ifdef TEST_EVERY_CHANGE
 	mem_Verify( );
@@ -502,6 +1018,9 @@ int mem_Init( size_t totalSize )
 	memoryBlock.mutex = NULL;
 	memoryBlock.watchedAddress = NULL;
 	memoryBlock.watchedHeader = NULL;
+	memoryBlock.freeList = NULL;
+	memset( memoryBlock.bins, 0, sizeof( memoryBlock.bins ) );
+	memoryBlock.generation = ++lastGeneration;
 
 	memoryBlock.memory = SDL_malloc(totalSize);
 	if( memoryBlock.memory == NULL ) {
@@ -521,6 +1040,16 @@ int mem_Init( size_t totalSize )
 	}
 #endif
 
+#ifdef USE_THREAD_CACHE
+	if( threadCacheID == 0 ) {
+		threadCacheID = SDL_TLSCreate( );
+		if( threadCacheID == 0 ) {
+			llog( LOG_CRITICAL, "Unable to create thread local storage for memory caches: %s", SDL_GetError( ) );
+			goto error_cleanup;
+		}
+	}
+#endif
+
 	return 0;
 
 error_cleanup:
@@ -533,6 +1062,8 @@ void mem_CleanUp( void )
 	// invalidates all the pointers
 	SDL_free( memoryBlock.memory );
 	memoryBlock.memory = NULL;
+	memoryBlock.freeList = NULL;
+	memset( memoryBlock.bins, 0, sizeof( memoryBlock.bins ) );
 
 #ifdef THREAD_SUPPORT
 	SDL_DestroyMutex( memoryBlock.mutex );
@@ -594,56 +1125,41 @@ void* mem_Allocate_Data( size_t size, const char* fileName, const int line )
 {
 	uint8_t* result = NULL;
 
+	// if the size is 0 malloc can return NULL or an unusable pointer, NULL works better for us as
+	//  it avoids littering the memory with zero sized headers
+	if( size == 0 ) {
+		return NULL;
+	}
+
+#ifdef USE_THREAD_CACHE
+	if( ALIGN_SIZE( size ) <= SMALL_ALLOC_MAX ) {
+		ThreadCache* cache = getThreadCache( );
+		if( cache != NULL ) {
+			result = (uint8_t*)threadCacheAllocate( cache, ALIGN_SIZE( size ), fileName, line );
+			if( result != NULL ) {
+				CHECK_BLOCK_GUARDS( (MemoryBlockHeader*)( result - MEMORY_HEADER_SIZE ), fileName, line );
+				logWatchedMemoryAddressChange( (MemoryBlockHeader*)( result - MEMORY_HEADER_SIZE ), "mem_Allocate_Data", NULL );
+				return (void*)result;
+			}
+		}
+	}
+#endif
+
 	LOCK_MEMORY_MUTEX( ); {
 #ifdef TEST_EVERY_CHANGE
 		internal_verify( );
 #endif
 		assert( memoryBlock.memory != NULL );
 
-		// if the size is 0 malloc can return NULL or an unusable pointer, NULL works better for us as
-		//  it avoids littering the memory with zero sized headers
-		if( size == 0 ) {
-			return NULL;
-		}
-
-		size = ALIGN_SIZE( size );
-
-		// we'll just do first fit, if we can't find a spot we'll just return NULL
-		MemoryBlockHeader* header = (MemoryBlockHeader*)( memoryBlock.memory );
-		while( ( header != NULL ) && ( ( header->flags & IN_USE_FLAG ) || ( header->size < size ) ) ) {
-			header = header->next;
-		}
-
-		if( header != NULL ) {
-			// found a large enough block that's not in use, split it up and set stuff up
-			header->flags |= IN_USE_FLAG;
-
-			result = (uint8_t*)header;
-			result += MEMORY_HEADER_SIZE;
+		result = (uint8_t*)internal_allocate_Data( size, fileName, line );
 
-			testingSetMemory( (void*)result, size, 0xCC );
-
-			// if there's enough room left then split it into it's own block
-
-			// how do we really want to do this?
-			if( header->size >= ( size + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE ) ) {
-				MemoryBlockHeader* nextHeader = createNewBlock( (void*)( result + size ),
-					header, header->next, header->size - size - MEMORY_HEADER_SIZE,
-					fileName, line );
-				testingSetMemory( (void*)( (uintptr_t)nextHeader + MEMORY_HEADER_SIZE ), nextHeader->size, 0xDD );
-			} else {
-				// there's some left over memory, we'll just put it into the block
-				testingSetMemory( (void*)( result + size ), header->size - size, 0xEE );
-				size = header->size;
-			}
-
-			header->size = size;
-			setMemoryBlockInfo( header, fileName, line, "Allocate" );
-		}
 	#ifdef TEST_EVERY_CHANGE
 		mem_Verify( );
 	#endif
 		assert( result != NULL );
+		if( result != NULL ) {
+			CHECK_CHANGED_BLOCK( (MemoryBlockHeader*)( result - MEMORY_HEADER_SIZE ), fileName, line );
+		}
 
 		logWatchedMemoryAddressChange( (MemoryBlockHeader*)( (uint8_t*)result - MEMORY_HEADER_SIZE ), "mem_Allocate_Data", NULL );
 
@@ -663,6 +1179,7 @@ void* mem_Resize_Data( void* memory, size_t newSize, const char* fileName, const
 
 		if( newSize == 0 ) {
 			internal_release_Data( memory, fileName, line );
+			UNLOCK_MEMORY_MUTEX( );
 			return NULL;
 		}
 
@@ -676,6 +1193,7 @@ void* mem_Resize_Data( void* memory, size_t newSize, const char* fileName, const
 		// or we could just assert
 		if( memory != NULL ) {
 			MemoryBlockHeader* header = (MemoryBlockHeader*)( (uintptr_t)memory - MEMORY_HEADER_SIZE );
+			CHECK_CHANGED_BLOCK( header, fileName, line );
 			if( newSize > header->size ) {
 				result = growBlock( header, newSize, fileName, line );
 			} else if( newSize < header->size ) {
@@ -689,6 +1207,9 @@ void* mem_Resize_Data( void* memory, size_t newSize, const char* fileName, const
 		mem_Verify( );
 #endif
 		assert( result != NULL );
+		if( result != NULL ) {
+			CHECK_CHANGED_BLOCK( (MemoryBlockHeader*)( (uintptr_t)result - MEMORY_HEADER_SIZE ), fileName, line );
+		}
 
 		logWatchedMemoryAddressChange( (MemoryBlockHeader*)( (uintptr_t)result - MEMORY_HEADER_SIZE ), "mem_Resize_Data", NULL );
 
@@ -699,11 +1220,42 @@ void* mem_Resize_Data( void* memory, size_t newSize, const char* fileName, const
 
 void mem_Release_Data( void* memory, const char* fileName, const int line )
 {
+#ifdef USE_THREAD_CACHE
+	if( memory != NULL ) {
+		MemoryBlockHeader* header = (MemoryBlockHeader*)( (uintptr_t)memory - MEMORY_HEADER_SIZE );
+		CHECK_BLOCK_GUARDS( header, fileName, line );
+		assert( GUARDS_VALID( header ) );
+		assert( header->flags & IN_USE_FLAG );
+		if( header->size <= SMALL_ALLOC_MAX ) {
+			ThreadCache* cache = getThreadCache( );
+			if( cache != NULL ) {
+				logWatchedMemoryAddressChange( header, "mem_Release_Data", NULL );
+				threadCacheRelease( cache, header );
+				return;
+			}
+		}
+	}
+#endif
+
 	LOCK_MEMORY_MUTEX( ); {
 		internal_release_Data( memory, fileName, line );
 	} UNLOCK_MEMORY_MUTEX( );
 }
 
+void mem_ReleaseThreadCache( void )
+{
+#ifdef USE_THREAD_CACHE
+	ThreadCache* cache = (ThreadCache*)SDL_TLSGet( threadCacheID );
+	if( ( cache == NULL ) || ( cache->generation != memoryBlock.generation ) ) {
+		return;
+	}
+
+	LOCK_MEMORY_MUTEX( ); {
+		drainThreadCache( cache );
+	} UNLOCK_MEMORY_MUTEX( );
+#endif
+}
+
 void mem_WatchAddress( void* ptr )
 {
 	LOCK_MEMORY_MUTEX( ); {
@@ -719,15 +1271,199 @@ void mem_UnWatchAddress( void* ptr )
 	} UNLOCK_MEMORY_MUTEX( );
 }
 
+// the arena is meant for lots of small short lived allocations, so we use a smaller alignment than the main memory
+#define ARENA_ALIGN ( sizeof( void* ) * 2 )
+#define ARENA_ALIGN_SIZE( s ) ( ( ( ( s ) + ( ARENA_ALIGN - 1 ) ) / ARENA_ALIGN ) * ARENA_ALIGN )
+
+// when the arena runs out we fall back to the main memory, these are chained together so they can be released
+//  when the arena is reset
+typedef struct ArenaOverflowHeader {
+	struct ArenaOverflowHeader* next;
+	size_t size;
+} ArenaOverflowHeader;
+
+#define ARENA_OVERFLOW_HEADER_SIZE ( ARENA_ALIGN_SIZE( sizeof( ArenaOverflowHeader ) ) )
+
+static void releaseArenaOverflow( MemoryArena* arena )
+{
+	ArenaOverflowHeader* overflow = (ArenaOverflowHeader*)arena->overflow;
+	while( overflow != NULL ) {
+		ArenaOverflowHeader* next = overflow->next;
+		mem_Release( overflow );
+		overflow = next;
+	}
+	arena->overflow = NULL;
+	arena->overflowUsed = 0;
+}
+
+static void updateArenaHighWaterMark( MemoryArena* arena )
+{
+	size_t total = arena->used + arena->overflowUsed;
+	if( total > arena->highWaterMark ) {
+		arena->highWaterMark = total;
+	}
+}
+
+int memArena_Init( MemoryArena* arena, size_t size )
+{
+	assert( arena != NULL );
+
+	memset( arena, 0, sizeof( MemoryArena ) );
+	arena->lastAllocation = SIZE_MAX;
+
+	arena->memory = (uint8_t*)mem_Allocate( size );
+	if( arena->memory == NULL ) {
+		llog( LOG_CRITICAL, "Unable to allocate memory arena." );
+		return -1;
+	}
+	arena->size = size;
+
+	return 0;
+}
+
+void memArena_CleanUp( MemoryArena* arena )
+{
+	assert( arena != NULL );
+
+	releaseArenaOverflow( arena );
+	mem_Release( arena->memory );
+	memset( arena, 0, sizeof( MemoryArena ) );
+}
+
+void* memArena_Allocate_Data( MemoryArena* arena, size_t size, const char* fileName, const int line )
+{
+	assert( arena != NULL );
+	assert( arena->memory != NULL );
+
+	if( size == 0 ) {
+		return NULL;
+	}
+
+	size = ARENA_ALIGN_SIZE( size );
+
+	void* result = NULL;
+	if( ( arena->size - arena->used ) >= size ) {
+		result = (void*)( arena->memory + arena->used );
+		arena->lastAllocation = arena->used;
+		arena->used += size;
+	} else {
+		// out of room, use the main memory until the next reset
+		if( arena->overflow == NULL ) {
+			llog( LOG_WARN, "Memory arena of size %u is full, falling back to main memory. Allocation from %s:%i", arena->size, fileName, line );
+		}
+
+		ArenaOverflowHeader* overflow = (ArenaOverflowHeader*)mem_Allocate_Data( ARENA_OVERFLOW_HEADER_SIZE + size, fileName, line );
+		if( overflow == NULL ) {
+			return NULL;
+		}
+		overflow->next = (ArenaOverflowHeader*)arena->overflow;
+		overflow->size = size;
+		arena->overflow = overflow;
+		arena->overflowUsed += size;
+		arena->lastAllocation = SIZE_MAX;
+
+		result = (void*)( (uint8_t*)overflow + ARENA_OVERFLOW_HEADER_SIZE );
+	}
+
+	updateArenaHighWaterMark( arena );
+
+	return result;
+}
+
+void* memArena_Resize_Data( MemoryArena* arena, void* memory, size_t newSize, const char* fileName, const int line )
+{
+	assert( arena != NULL );
+
+	if( memory == NULL ) {
+		return memArena_Allocate_Data( arena, newSize, fileName, line );
+	}
+
+	newSize = ARENA_ALIGN_SIZE( newSize );
+
+	if( ( (uint8_t*)memory >= arena->memory ) && ( (uint8_t*)memory < ( arena->memory + arena->size ) ) ) {
+		size_t offset = (size_t)( (uint8_t*)memory - arena->memory );
+
+		// the most recent allocation can just be bumped in place
+		if( ( offset == arena->lastAllocation ) && ( ( arena->size - offset ) >= newSize ) ) {
+			if( ( offset + newSize ) > arena->used ) {
+				arena->used = offset + newSize;
+				updateArenaHighWaterMark( arena );
+			}
+			return memory;
+		}
+
+		// we don't track the size of every allocation, anything after this could be other allocations so we can't
+		//  use it in place, just copy over as much as could belong to it
+		size_t copySize = ( newSize < ( arena->used - offset ) ) ? newSize : ( arena->used - offset );
+		void* result = memArena_Allocate_Data( arena, newSize, fileName, line );
+		if( result != NULL ) {
+			memcpy( result, memory, copySize );
+		}
+		return result;
+	}
+
+	ArenaOverflowHeader* overflow = (ArenaOverflowHeader*)( (uint8_t*)memory - ARENA_OVERFLOW_HEADER_SIZE );
+	size_t oldSize = overflow->size;
+	if( newSize <= oldSize ) {
+		return memory;
+	}
+
+	void* result = memArena_Allocate_Data( arena, newSize, fileName, line );
+	if( result != NULL ) {
+		memcpy( result, memory, oldSize );
+	}
+	return result;
+}
+
+void memArena_Reset( MemoryArena* arena )
+{
+	assert( arena != NULL );
+
+	arena->lastHighWaterMark = arena->highWaterMark;
+	if( arena->highWaterMark > arena->peakHighWaterMark ) {
+		arena->peakHighWaterMark = arena->highWaterMark;
+	}
+	arena->highWaterMark = 0;
+
+	releaseArenaOverflow( arena );
+	arena->used = 0;
+	arena->lastAllocation = SIZE_MAX;
+}
+
+#ifdef USE_THREAD_CACHE
+static int threadCacheTestThread( void* data )
+{
+	void* blocks[128];
+	for( int r = 0; r < 10; ++r ) {
+		for( int i = 0; i < 128; ++i ) {
+			blocks[i] = mem_Allocate( 1 + ( ( i * 37 ) % SMALL_ALLOC_MAX ) );
+			assert( blocks[i] != NULL );
+		}
+		for( int i = 0; i < 128; ++i ) {
+			mem_Release( blocks[i] );
+		}
+	}
+
+	// exits without calling mem_ReleaseThreadCache( )
+	return 0;
+}
+#endif
+
 void mem_RunTests( void )
 {
-	void* oldMemoryBlock = memoryBlock.memory;
+	// the tests create and destroy their own heaps, hand back anything this thread is holding and save the whole heap so
+	//  it can be put back exactly as it was
+	mem_ReleaseThreadCache( );
+	MemoryHeap oldHeap = memoryBlock;
 
 	uint8_t* testOne;
 	uint8_t* testTwo;
 	uint8_t* testThree;
 	uint8_t* backup;
 
+	// anything this size or larger bypasses the size class bins and uses the block list
+	const size_t large = ALIGN_SIZE( SMALL_ALLOC_MAX + 100 );
+
 	// test basic allocation and release
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
 		testOne = (uint8_t*)mem_Allocate( 100 );
@@ -755,6 +1491,39 @@ void mem_RunTests( void )
 		mem_Verify( );
 	} mem_CleanUp( );
 
+	// test small blocks are reused from their size class bin, both sizes round up to the same class
+	assert( mem_Init( 32 * 1024 ) == 0 ); {
+		testOne = (uint8_t*)mem_Allocate( ( ALIGN * 2 ) - ( ALIGN / 2 ) );
+		assert( testOne != NULL );
+		mem_Verify( );
+
+		testTwo = (uint8_t*)mem_Allocate( 20 );
+		assert( testTwo != NULL );
+		mem_Verify( );
+
+		backup = testOne;
+		mem_Release( testOne );
+		mem_Verify( );
+
+		testOne = (uint8_t*)mem_Allocate( ALIGN * 2 );
+		assert( testOne == backup );
+		mem_Verify( );
+	} mem_CleanUp( );
+
+	// test large allocations can claim memory held in the bins
+	assert( mem_Init( 32 * 1024 ) == 0 ); {
+		testOne = (uint8_t*)mem_Allocate( 100 );
+		assert( testOne != NULL );
+		mem_Verify( );
+
+		mem_Release( testOne );
+		mem_Verify( );
+
+		testTwo = (uint8_t*)mem_Allocate( 24 * 1024 );
+		assert( testTwo != NULL );
+		mem_Verify( );
+	} mem_CleanUp( );
+
 	// test basic resize
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
 		testOne = (uint8_t*)mem_Allocate( 1000 );
@@ -772,15 +1541,15 @@ void mem_RunTests( void )
 
 	// test resize grow with enough open space in next block to allocate data, and enough data to create new header
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
-		testOne = (uint8_t*)mem_Allocate( 100 );
+		testOne = (uint8_t*)mem_Allocate( large );
 		assert( testOne != NULL );
 		mem_Verify( );
 
-		testTwo = (uint8_t*)mem_Allocate( 100 + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE );
+		testTwo = (uint8_t*)mem_Allocate( large + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE );
 		assert( testTwo != NULL );
 		mem_Verify( );
 
-		testThree = (uint8_t*)mem_Allocate( 100 );
+		testThree = (uint8_t*)mem_Allocate( large );
 		assert( testThree != NULL );
 		mem_Verify( );
 
@@ -788,7 +1557,7 @@ void mem_RunTests( void )
 		mem_Verify( );
 
 		backup = testOne;
-		testOne = mem_Resize( testOne, 200 );
+		testOne = mem_Resize( testOne, large + 100 );
 		assert( testOne != NULL );
 		assert( testOne == backup );
 		mem_Verify( );
@@ -796,15 +1565,15 @@ void mem_RunTests( void )
 
 	// test resize grow with enough open space in next block to allocate data, and not enough space to create new header
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
-		testOne = (uint8_t*)mem_Allocate( 100 );
+		testOne = (uint8_t*)mem_Allocate( large );
 		assert( testOne != NULL );
 		mem_Verify( );
 
-		testTwo = (uint8_t*)mem_Allocate( 100 );
+		testTwo = (uint8_t*)mem_Allocate( large );
 		assert( testTwo != NULL );
 		mem_Verify( );
 
-		testThree = (uint8_t*)mem_Allocate( 100 );
+		testThree = (uint8_t*)mem_Allocate( large );
 		assert( testThree != NULL );
 		mem_Verify( );
 
@@ -812,7 +1581,7 @@ void mem_RunTests( void )
 		mem_Verify( );
 
 		backup = testOne;
-		testOne = mem_Resize( testOne, 199 );
+		testOne = mem_Resize( testOne, ( large * 2 ) + MEMORY_HEADER_SIZE - ALIGN );
 		assert( testOne != NULL );
 		assert( testOne == backup );
 		mem_Verify( );
@@ -820,15 +1589,15 @@ void mem_RunTests( void )
 
 	// test resize grow without enough open space in next block to allocate data
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
-		testOne = (uint8_t*)mem_Allocate( 100 );
+		testOne = (uint8_t*)mem_Allocate( large );
 		assert( testOne != NULL );
 		mem_Verify( );
 
-		testTwo = (uint8_t*)mem_Allocate( 100 );
+		testTwo = (uint8_t*)mem_Allocate( large );
 		assert( testTwo != NULL );
 		mem_Verify( );
 
-		testThree = (uint8_t*)mem_Allocate( 100 );
+		testThree = (uint8_t*)mem_Allocate( large );
 		assert( testThree != NULL );
 		mem_Verify( );
 
@@ -836,7 +1605,7 @@ void mem_RunTests( void )
 		mem_Verify( );
 
 		backup = testOne;
-		testOne = mem_Resize( testOne, 1000 );
+		testOne = mem_Resize( testOne, large * 3 );
 		assert( testOne != NULL );
 		assert( testOne != backup );
 		mem_Verify( );
@@ -844,10 +1613,10 @@ void mem_RunTests( void )
 
 	// test resize shrink where there is enough open space after to create new block
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
-		testOne = (uint8_t*)mem_Allocate( 100 + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE );
+		testOne = (uint8_t*)mem_Allocate( large + MEMORY_HEADER_SIZE + MIN_ALLOC_SIZE );
 		mem_Verify( );
 
-		testTwo = (uint8_t*)mem_Allocate( 100 );
+		testTwo = (uint8_t*)mem_Allocate( large );
 		mem_Verify( );
 
 		backup = testOne;
@@ -856,23 +1625,241 @@ void mem_RunTests( void )
 		assert( testOne == backup );
 		mem_Verify( );
 
+		// now small enough that releasing it should put it in a bin
+		mem_Release( testOne );
+		mem_Verify( );
+
 	} mem_CleanUp( );
 
 	// test resize shrink where there is not enough open space after to create new block
 	assert( mem_Init( 32 * 1024 ) == 0 ); {
-		testOne = (uint8_t*)mem_Allocate( 100 );
+		testOne = (uint8_t*)mem_Allocate( large );
 		mem_Verify( );
 
-		testTwo = (uint8_t*)mem_Allocate( 100 );
+		testTwo = (uint8_t*)mem_Allocate( large );
 		mem_Verify( );
 
 		backup = testOne;
-		testOne = (uint8_t*)mem_Resize( testOne, 99 );
+		testOne = (uint8_t*)mem_Resize( testOne, large - 1 );
 		assert( testOne != NULL );
 		assert( testOne == backup );
 		mem_Verify( );
 	} mem_CleanUp( );
 
-	// restore old memory block
-	memoryBlock.memory = oldMemoryBlock;
-}
\ No newline at end of file
+	// test arena allocation, resizing in place, overflow, and reset
+	assert( mem_Init( 32 * 1024 ) == 0 ); {
+		MemoryArena arena;
+		assert( memArena_Init( &arena, 1024 ) == 0 );
+
+		testOne = (uint8_t*)memArena_Allocate( &arena, 100 );
+		assert( testOne != NULL );
+
+		testTwo = (uint8_t*)memArena_Allocate( &arena, 100 );
+		assert( testTwo != NULL );
+		assert( testTwo > testOne );
+
+		backup = testTwo;
+		testTwo = (uint8_t*)memArena_Resize( &arena, testTwo, 500 );
+		assert( testTwo == backup );
+
+		// resizing something that isn't the last allocation has to leave the ones after it alone
+		memset( testOne, 0x11, 100 );
+		memset( testTwo, 0x22, 500 );
+		backup = testOne;
+		testOne = (uint8_t*)memArena_Resize( &arena, testOne, 200 );
+		assert( testOne != NULL );
+		assert( testOne != backup );
+		for( int i = 0; i < 100; ++i ) {
+			assert( testOne[i] == 0x11 );
+		}
+		for( int i = 0; i < 500; ++i ) {
+			assert( testTwo[i] == 0x22 );
+		}
+		memset( testOne, 0x33, 200 );
+		for( int i = 0; i < 500; ++i ) {
+			assert( testTwo[i] == 0x22 );
+		}
+
+		testThree = (uint8_t*)memArena_Allocate( &arena, 1024 );
+		assert( testThree != NULL );
+		assert( arena.overflow != NULL );
+		mem_Verify( );
+
+		memArena_Reset( &arena );
+		assert( arena.used == 0 );
+		assert( arena.overflow == NULL );
+		assert( arena.lastHighWaterMark >= 1600 );
+		mem_Verify( );
+
+		memArena_CleanUp( &arena );
+		mem_Verify( );
+	} mem_CleanUp( );
+
+#ifdef USE_THREAD_CACHE
+	// test threads that exit while holding cached blocks give them all back
+	assert( mem_Init( 1024 * 1024 ) == 0 ); {
+		SDL_Thread* threads[4];
+		for( int i = 0; i < 4; ++i ) {
+			threads[i] = SDL_CreateThread( threadCacheTestThread, "MemTest", NULL );
+			assert( threads[i] != NULL );
+		}
+		for( int i = 0; i < 4; ++i ) {
+			SDL_WaitThread( threads[i], NULL );
+		}
+		mem_Verify( );
+
+		size_t total = 0;
+		size_t inUse = 0;
+		size_t overhead = 0;
+		uint32_t fragments = 0;
+		LOCK_MEMORY_MUTEX( ); {
+			internal_getReportValues( &total, &inUse, &overhead, &fragments );
+		} UNLOCK_MEMORY_MUTEX( );
+		assert( inUse == 0 );
+	} mem_CleanUp( );
+#endif
+
+	// restore old memory heap
+	memoryBlock = oldHeap;
+}
+
+typedef struct {
+	uint32_t iterations;
+	uint32_t seed;
+} ContentionBenchmarkData;
+
+static int contentionBenchmarkThread( void* data )
+{
+	ContentionBenchmarkData* benchData = (ContentionBenchmarkData*)data;
+
+	// keep a working set of live allocations and randomly replace them, mostly small with the occasional large one
+	void* live[64];
+	memset( live, 0, sizeof( live ) );
+
+	RandomGroup rg;
+	rand_Seed( &rg, benchData->seed );
+	for( uint32_t i = 0; i < benchData->iterations; ++i ) {
+		uint32_t idx = rand_GetU32( &rg ) % ( sizeof( live ) / sizeof( live[0] ) );
+		mem_Release( live[idx] );
+
+		size_t size;
+		if( ( rand_GetU32( &rg ) % 8 ) == 0 ) {
+			size = SMALL_ALLOC_MAX + ( rand_GetU32( &rg ) % ( 8 * 1024 ) );
+		} else {
+			size = 1 + ( rand_GetU32( &rg ) % SMALL_ALLOC_MAX );
+		}
+		live[idx] = mem_Allocate( size );
+		assert( live[idx] != NULL );
+		( (uint8_t*)live[idx] )[0] = (uint8_t)i;
+	}
+
+	for( size_t i = 0; i < ( sizeof( live ) / sizeof( live[0] ) ); ++i ) {
+		mem_Release( live[i] );
+	}
+	mem_ReleaseThreadCache( );
+
+	return 0;
+}
+
+void mem_RunContentionBenchmark( uint8_t numThreads, uint32_t iterationsPerThread )
+{
+#ifdef THREAD_SUPPORT
+	assert( memoryBlock.memory != NULL );
+	assert( numThreads > 0 );
+
+	ContentionBenchmarkData benchData[256];
+	SDL_Thread* threads[256];
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint8_t i = 0; i < numThreads; ++i ) {
+		char name[16];
+		SDL_snprintf( name, SDL_arraysize( name ), "MemBench_%i", i );
+		benchData[i].iterations = iterationsPerThread;
+		benchData[i].seed = 1 + i;
+		threads[i] = SDL_CreateThread( contentionBenchmarkThread, name, &( benchData[i] ) );
+		if( threads[i] == NULL ) {
+			llog( LOG_WARN, "Unable to create memory benchmark thread %i: %s", i, SDL_GetError( ) );
+		}
+	}
+
+	for( uint8_t i = 0; i < numThreads; ++i ) {
+		SDL_WaitThread( threads[i], NULL );
+	}
+	double ms = test_MSSince( start );
+	double totalOps = 2.0 * (double)numThreads * (double)iterationsPerThread;
+	llog( LOG_INFO, "Memory contention benchmark: %i threads, %u allocations and releases per thread", numThreads, iterationsPerThread );
+	llog( LOG_INFO, "  Time: %.3f ms", ms );
+	llog( LOG_INFO, "  Operations per ms: %.1f", totalOps / ms );
+	mem_Report( );
+#else
+	llog( LOG_INFO, "Compiled without support for threads, memory contention benchmark not run." );
+#endif
+}
+
+static const char* profileName( void )
+{
+	switch( MEMORY_PROFILE ) {
+	case MEMORY_PROFILE_DEBUG:
+		return "debug";
+	case MEMORY_PROFILE_CHECKED:
+		return "checked";
+	case MEMORY_PROFILE_RELEASE:
+		return "release";
+	default:
+		return "unknown";
+	}
+}
+
+// allocates a batch of blocks of size between minSize and maxSize then releases them, repeated iterations times
+//  returns how many milliseconds it took
+static double profileBenchmarkRun( uint32_t iterations, size_t minSize, size_t maxSize )
+{
+	void* live[64];
+	RandomGroup rg;
+	rand_Seed( &rg, 42 );
+
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( uint32_t i = 0; i < iterations; ++i ) {
+		for( size_t a = 0; a < ( sizeof( live ) / sizeof( live[0] ) ); ++a ) {
+			size_t size = minSize + ( rand_GetU32( &rg ) % ( maxSize - minSize + 1 ) );
+			live[a] = mem_Allocate( size );
+			assert( live[a] != NULL );
+		}
+
+		// release in a different order than they were allocated so the blocks get mixed up
+		for( size_t a = 0; a < ( sizeof( live ) / sizeof( live[0] ) ); a += 2 ) {
+			mem_Release( live[a] );
+		}
+		for( size_t a = 1; a < ( sizeof( live ) / sizeof( live[0] ) ); a += 2 ) {
+			mem_Release( live[a] );
+		}
+	}
+
+	return test_MSSince( start );
+}
+
+void mem_RunProfileBenchmark( uint32_t iterations )
+{
+	assert( memoryBlock.memory != NULL );
+
+	llog( LOG_INFO, "Memory profile benchmark: %s profile, %u iterations", profileName( ), iterations );
+
+	// what each block costs on top of the requested size, the header plus whatever it takes to align the size
+	size_t requestSizes[] = { 1, 16, 100, 1000, 4000 };
+	llog( LOG_INFO, "  Block header size: %u", (uint32_t)MEMORY_HEADER_SIZE );
+	for( size_t i = 0; i < ( sizeof( requestSizes ) / sizeof( requestSizes[0] ) ); ++i ) {
+		size_t overhead = MEMORY_HEADER_SIZE + ALIGN_SIZE( requestSizes[i] ) - requestSizes[i];
+		llog( LOG_INFO, "  Overhead for a %u byte block: %u", (uint32_t)requestSizes[i], (uint32_t)overhead );
+	}
+
+	// 64 allocations and 64 releases per iteration
+	double totalOps = 128.0 * (double)iterations;
+
+	double ms = profileBenchmarkRun( iterations, 1, SMALL_ALLOC_MAX );
+	llog( LOG_INFO, "  Small blocks: %.3f ms, %.1f operations per ms", ms, totalOps / ms );
+
+	ms = profileBenchmarkRun( iterations, SMALL_ALLOC_MAX + 1, 16 * 1024 );
+	llog( LOG_INFO, "  Large blocks: %.3f ms, %.1f operations per ms", ms, totalOps / ms );
+
+	mem_ReleaseThreadCache( );
+}
@@ -5,6 +5,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// how much tracking and checking the memory does, define MEMORY_PROFILE in the build to override the default
+//  MEMORY_PROFILE_DEBUG: every block stores the file and line that last touched it and the whole heap is verified
+//   on every change, very slow but catches problems close to where they happen
+//  MEMORY_PROFILE_CHECKED: guard values and links are checked only on the blocks being allocated, resized, or
+//   released, problems are logged even if asserts are compiled out
+//  MEMORY_PROFILE_RELEASE: no tracking or checking, smallest block headers
+#define MEMORY_PROFILE_RELEASE 0
+#define MEMORY_PROFILE_CHECKED 1
+#define MEMORY_PROFILE_DEBUG 2
+
+#ifndef MEMORY_PROFILE
+	#if defined( _DEBUG )
+		#define MEMORY_PROFILE MEMORY_PROFILE_DEBUG
+	#elif defined( NDEBUG )
+		#define MEMORY_PROFILE MEMORY_PROFILE_RELEASE
+	#else
+		#define MEMORY_PROFILE MEMORY_PROFILE_CHECKED
+	#endif
+#endif
+
 // we'll make this the main memory thing, then we'll have memArena_* functions that that work with a MemoryArena struct.
 int mem_Init( size_t totalSize );
 void mem_CleanUp( void );
@@ -28,8 +48,57 @@ void* mem_Allocate_Data( size_t size, const char* fileName, const int line );
 void* mem_Resize_Data( void* memory, size_t newSize, const char* fileName, const int line );
 void mem_Release_Data( void* memory, const char* fileName, const int line );
 
+// each thread holds on to some small blocks so it can allocate and release them without locking, call this
+//  before a thread exits to give them back
+void mem_ReleaseThreadCache( void );
+
+// checks the heap, bins, thread caches, and arenas work, asserting if they don't
+//  creates and destroys its own heaps, the current one is saved and put back, but nothing else can be using the memory
+//  while it runs
 void mem_RunTests( void );
 
+// spawns numThreads threads that each allocate and release a mix of small and large blocks, logs the timing
+//  uses the main memory, so mem_Init( ) must have been called
+void mem_RunContentionBenchmark( uint8_t numThreads, uint32_t iterationsPerThread );
+
+// allocates and releases a mix of block sizes on the calling thread and logs the throughput along with how many
+//  bytes each block costs on top of what was asked for, only measures the profile the memory was built with
+//  uses the main memory, so mem_Init( ) must have been called
+void mem_RunProfileBenchmark( uint32_t iterations );
+
 #define MEM_VERIFY_BLOCK( f ) { mem_Verify( ); f; mem_Verify( ); }
 
+// Linear allocator that gets it's memory from the main memory, allocating just moves a position forward and everything
+//  is released at once when it's reset. If it runs out of room it falls back to the main memory until the next reset.
+//  Not thread safe.
+typedef struct {
+	uint8_t* memory;
+	size_t size;
+	size_t used;
+	size_t lastAllocation;		// offset of the most recent allocation, it can be resized in place
+
+	void* overflow;				// allocations from the main memory made when the arena was full
+	size_t overflowUsed;
+
+	size_t highWaterMark;		// the most used since the last reset, including any overflow
+	size_t lastHighWaterMark;	// the high water mark before the last reset
+	size_t peakHighWaterMark;	// largest high water mark seen
+} MemoryArena;
+
+int memArena_Init( MemoryArena* arena, size_t size );
+void memArena_CleanUp( MemoryArena* arena );
+
+#define memArena_Allocate( a, s ) memArena_Allocate_Data( (a), (s), __FILE__, __LINE__ )
+#define memArena_Resize( a, p, s ) memArena_Resize_Data( (a), (p), (s), __FILE__, __LINE__ )
+
+void* memArena_Allocate_Data( MemoryArena* arena, size_t size, const char* fileName, const int line );
+// if the memory is the most recent allocation this will grow it in place, otherwise it's copied to a new spot
+void* memArena_Resize_Data( MemoryArena* arena, void* memory, size_t newSize, const char* fileName, const int line );
+
+// releases everything allocated from the arena
+void memArena_Reset( MemoryArena* arena );
+
+// memory that's only valid until the end of the current frame, reset at the start of every frame
+extern MemoryArena frameArena;
+
 #endif // inclusion guard
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "testing.h"
+
+#include <assert.h>
+#include <SDL_timer.h>
+
+#include "platformLog.h"
+
+double test_MSSince( Uint64 start )
+{
+	return (double)( SDL_GetPerformanceCounter( ) - start ) * 1000.0 / (double)SDL_GetPerformanceFrequency( );
+}
+
+double test_Fastest( double fastestMS, double ms, uint32_t run )
+{
+	return ( ( run == 0 ) || ( ms < fastestMS ) ) ? ms : fastestMS;
+}
+
+bool test_Check( bool passed, const char* description, const char* fileName, int line )
+{
+	if( !passed ) {
+		llog( LOG_ERROR, "FAILED: %s (%s:%i)", description, fileName, line );
+	}
+	assert( passed );
+	return passed;
+}
@@ -0,0 +1,21 @@
+#ifndef TESTING_H
+#define TESTING_H
+
+#include <stdbool.h>
+#include <SDL_stdinc.h>
+
+// shared by the *_RunTests( ) and *_Run*Benchmark( ) functions the systems have, they're all run from main( ) when
+//  started with -tests or -benchmarks
+
+// returns how many milliseconds have passed since start, which should come from SDL_GetPerformanceCounter( )
+double test_MSSince( Uint64 start );
+
+// returns ms if it's the first of several runs or faster than fastestMS, otherwise fastestMS
+double test_Fastest( double fastestMS, double ms, uint32_t run );
+
+// logs an error with what was being checked if passed is false and then asserts, so failures still show up in the
+//  log when asserts are compiled out, returns passed
+#define TEST_CHECK( passed, description ) test_Check( ( passed ), ( description ), __FILE__, __LINE__ )
+bool test_Check( bool passed, const char* description, const char* fileName, int line );
+
+#endif // inclusion guard
@@ -32,9 +32,6 @@ typedef struct {
 
 static const uint32_t LINE_FEED = 0xA;
 
-// used for when we want to modify a string but don't want to change what was passed in
-static uint32_t* sbStringCodepointBuffer = NULL;
-
 #define MAX_FONTS 32
 typedef struct {
 	// this will be sorted by the codepoint entry in all the structs, make it easier to search
@@ -75,8 +72,6 @@ int txt_Init( void )
 		fonts[i].glyphsBuffer = NULL;
 	}
 
-	sb_Add( sbStringCodepointBuffer, 1024 );
-
 	return 0;
 }
 
@@ -285,6 +280,8 @@ typedef struct {
 	int bmpWidth;
 	int bmpHeight;
 	unsigned char* bmpBuffer;
+
+	JobCounter* counter;
 } LoadFontData;
 
 static void cleanUpLoadFontTaskData( LoadFontData* data )
@@ -466,7 +463,7 @@ static void loadFontTask( void* data )
 		goto failure;
 	}
 
-	if( !jq_AddMainThreadJob( bindFontTask, data ) ) {
+	if( !jq_AddMainThreadJobWithCounter( bindFontTask, data, fontData->counter ) ) {
 		goto failure;
 	} else {
 		goto clean_up;
@@ -485,7 +482,7 @@ Loads the font at file name on a seperate thread. Uses a height of pixelHeight.
 This will initialize a bunch of stuff but not do any of the loading.
  Puts the resulting font ID into outFontID.
 */
-void txt_ThreadedLoadFont( const char* fileName, float pixelHeight, int* outFontID )
+void txt_ThreadedLoadFont( const char* fileName, float pixelHeight, int* outFontID, JobCounter* counter )
 {
 	(*outFontID) = -1;
 
@@ -510,8 +507,9 @@ void txt_ThreadedLoadFont( const char* fileName, float pixelHeight, int* outFont
 	memcpy( data->packRange.array_of_unicode_codepoints, fontPackRange.array_of_unicode_codepoints, codePointsSize );
 
 	data->bmpBuffer = NULL;
+	data->counter = counter;
 
-	if( !jq_AddJob( loadFontTask, data ) ) {
+	if( !jq_AddJobWithCounter( loadFontTask, data, counter ) ) {
 		cleanUpLoadFontTaskData( data );
 	}
 }
@@ -707,18 +705,61 @@ bool isBreakableCodepoint( int codepoint )
 			 ( codepoint == 8205 ) );
 }
 
-void convertOutToBuffer( const uint8_t* utf8Str )
+#include <string.h>
+// the codepoints for a string being displayed, used for when we want to modify a string but don't want to change
+//  what was passed in, only needed while drawing so they're put in the frameArena
+typedef struct {
+	uint32_t* codepoints;
+	size_t count;
+	size_t capacity;
+} CodepointBuffer;
+
+// returns < 0 if there wasn't room for the codepoints
+static int convertOutToBuffer( const uint8_t* utf8Str, CodepointBuffer* outBuffer )
 {
 	const uint8_t* str = utf8Str;
-	uint32_t codepoint;
-	sb_Clear( sbStringCodepointBuffer );
-	do {
-		codepoint = getUTF8CodePoint( &str );
-		sb_Push( sbStringCodepointBuffer, codepoint );
-	} while( codepoint != 0 );
+	size_t count = 0;
+	while( getUTF8CodePoint( &str ) != 0 ) {
+		++count;
+	}
+	++count; // the terminating 0
+
+	// leave some room for the line breaks that get inserted when wrapping
+	outBuffer->capacity = count + ( count / 4 ) + 1;
+	outBuffer->codepoints = (uint32_t*)memArena_Allocate( &frameArena, outBuffer->capacity * sizeof( uint32_t ) );
+	if( outBuffer->codepoints == NULL ) {
+		return -1;
+	}
+
+	str = utf8Str;
+	for( outBuffer->count = 0; outBuffer->count < count; ++( outBuffer->count ) ) {
+		outBuffer->codepoints[outBuffer->count] = getUTF8CodePoint( &str );
+	}
+
+	return 0;
+}
+
+// returns < 0 if there wasn't room to insert the codepoint
+static int insertIntoBuffer( CodepointBuffer* buffer, size_t idx, uint32_t codepoint )
+{
+	if( buffer->count >= buffer->capacity ) {
+		// the buffer should be the last thing allocated from the arena, so this grows it in place
+		size_t newCapacity = buffer->capacity * 2;
+		uint32_t* newCodepoints = (uint32_t*)memArena_Resize( &frameArena, buffer->codepoints, newCapacity * sizeof( uint32_t ) );
+		if( newCodepoints == NULL ) {
+			return -1;
+		}
+		buffer->codepoints = newCodepoints;
+		buffer->capacity = newCapacity;
+	}
+
+	memmove( &( buffer->codepoints[idx + 1] ), &( buffer->codepoints[idx] ), ( buffer->count - idx ) * sizeof( uint32_t ) );
+	buffer->codepoints[idx] = codepoint;
+	++( buffer->count );
+
+	return 0;
 }
 
-#include <string.h>
 /*
 Draws a string on the screen to an area. Splits up lines and such. If outCharPos is not equal to NULL it will
  grab the position of the character at storeCharPos and put it in there. Returns if outCharPos is valid.
@@ -743,12 +784,15 @@ bool txt_DisplayTextArea( const uint8_t* utf8Str, Vector2 upperLeft, Vector2 siz
 		return false;
 	}
 
-	// puts the converted string int sbStringCodepointBuffer
-	convertOutToBuffer( (uint8_t*)utf8Str );
+	CodepointBuffer buffer;
+	if( convertOutToBuffer( (uint8_t*)utf8Str, &buffer ) < 0 ) {
+		llog( LOG_ERROR, "Unable to allocate codepoints to display text area." );
+		return false;
+	}
 
 	float currentLength = 0.0f;
 	float currentHeight = 0.0f;
-	uint32_t* stringPos = sbStringCodepointBuffer;
+	uint32_t* stringPos = buffer.codepoints;
 	size_t lastBreakPoint = SIZE_MAX;
 
 	// the height and width are dependent on each other, we'll also find the break
@@ -759,8 +803,8 @@ bool txt_DisplayTextArea( const uint8_t* utf8Str, Vector2 upperLeft, Vector2 siz
 	maxSize.y = fonts[fontID].nextLineDescent;
 	float lastBreakPointSize = 0.0f;
 	uint32_t maxLineCnt = 0;
-	for( size_t i = 0; i < sb_Count( sbStringCodepointBuffer ); ++i ) {
-		if( isBreakableCodepoint( sbStringCodepointBuffer[i] ) ) {
+	for( size_t i = 0; i < buffer.count; ++i ) {
+		if( isBreakableCodepoint( buffer.codepoints[i] ) ) {
 			// store the position for later use
 			lastBreakPoint = i;
 
@@ -770,30 +814,33 @@ bool txt_DisplayTextArea( const uint8_t* utf8Str, Vector2 upperLeft, Vector2 siz
 		}
 
 		if( storeCharPos == i ) {
-			charBufferPos = sb_Count( sbStringCodepointBuffer );
+			charBufferPos = buffer.count;
 		}
 
-		if( sbStringCodepointBuffer[i] != LINE_FEED ) {
-			Glyph* glyph = getCodepointGlyph( fontID, sbStringCodepointBuffer[i] );
+		if( buffer.codepoints[i] != LINE_FEED ) {
+			Glyph* glyph = getCodepointGlyph( fontID, buffer.codepoints[i] );
 			currentLength += glyph->advance;
 			
 			if( currentLength > size.x ) {
 				if( lastBreakPoint != SIZE_MAX ) {
 					// have a valid breakpoint, replace it with a new line
-					sbStringCodepointBuffer[lastBreakPoint] = LINE_FEED;
+					buffer.codepoints[lastBreakPoint] = LINE_FEED;
 					i = lastBreakPoint;
 				} else {
 					// no valid breakpoint, put the breakpoint in the middle
 					//  of the word
 					--i;
-					sb_Insert( sbStringCodepointBuffer, i, LINE_FEED );
+					if( insertIntoBuffer( &buffer, i, LINE_FEED ) < 0 ) {
+						llog( LOG_ERROR, "Unable to allocate codepoints to display text area." );
+						return false;
+					}
 					lastBreakPointSize = currentLength - glyph->advance;
 				}
 			}
 		}
 
 		// if we're at a line feed, or reached the max width
-		if( sbStringCodepointBuffer[i] == LINE_FEED ) {
+		if( buffer.codepoints[i] == LINE_FEED ) {
 			maxSize.x = MAX( maxSize.x, lastBreakPointSize );
 			currentLength = 0.0f;
 			lastBreakPoint = SIZE_MAX;
@@ -802,7 +849,7 @@ bool txt_DisplayTextArea( const uint8_t* utf8Str, Vector2 upperLeft, Vector2 siz
 			if( ( maxSize.y + fonts[fontID].nextLineDescent ) > size.y ) {
 				// past the bottom of the area we want to draw the text in
 				//  truncate the string here
-				sbStringCodepointBuffer[i] = 0;
+				buffer.codepoints[i] = 0;
 				break;
 			}
 			++maxLineCnt;
@@ -829,15 +876,15 @@ bool txt_DisplayTextArea( const uint8_t* utf8Str, Vector2 upperLeft, Vector2 siz
 		//renderPos.y += fonts[fontID].ascent - ( maxSize.y / 2.0f );
 		break;
 	}
-	positionCodepointsStartX( sbStringCodepointBuffer, fontID, hAlign, size.x, &renderPos );
-	for( size_t i = 0; ( i < sb_Count( sbStringCodepointBuffer ) ) && ( sbStringCodepointBuffer[i] != 0 ); ++i ) {
-		if( sbStringCodepointBuffer[i] == LINE_FEED ) {
+	positionCodepointsStartX( buffer.codepoints, fontID, hAlign, size.x, &renderPos );
+	for( size_t i = 0; ( i < buffer.count ) && ( buffer.codepoints[i] != 0 ); ++i ) {
+		if( buffer.codepoints[i] == LINE_FEED ) {
 			// new line
 			renderPos.x = upperLeft.x;
 			renderPos.y += fonts[fontID].nextLineDescent;
-			positionCodepointsStartX( &( sbStringCodepointBuffer[i+1] ), fontID, hAlign, size.x, &renderPos );
+			positionCodepointsStartX( &( buffer.codepoints[i+1] ), fontID, hAlign, size.x, &renderPos );
 		} else {
-			Glyph* glyph = getCodepointGlyph( fontID, sbStringCodepointBuffer[i] );
+			Glyph* glyph = getCodepointGlyph( fontID, buffer.codepoints[i] );
 			if( glyph != NULL ) {
 				img_Draw_c( glyph->imageID, camFlags, renderPos, renderPos, clr, clr, depth );
 				renderPos.x += glyph->advance;
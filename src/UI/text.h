@@ -5,6 +5,7 @@
 
 #include "../Graphics/color.h"
 #include "../Math/vector2.h"
+#include "../System/jobQueue.h"
 
 typedef enum {
 	HORIZ_ALIGN_LEFT,
@@ -40,8 +41,9 @@ int txt_LoadFont( const char* fileName, float pixelHeight );
 /*
 Loads the font at file name on a seperate thread. Uses a height of pixelHeight.
  Puts the resulting font ID into outFontID
+ If counter isn't NULL it won't reach zero until the font has been loaded and bound.
 */
-void txt_ThreadedLoadFont( const char* fileName, float pixelHeight, int* outFontID );
+void txt_ThreadedLoadFont( const char* fileName, float pixelHeight, int* outFontID, JobCounter* counter );
 
 /*
 Frees up the font specified by fontID.
@@ -1,41 +1,168 @@
 #include "idSet.h"
 
 #include <assert.h>
+#include <SDL_timer.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
 #include "stretchyBuffer.h"
+#include "../System/memory.h"
+#include "../System/platformLog.h"
+#include "../System/random.h"
+#include "../System/testing.h"
 
 // TODO: Merge this into entityIDs.c, the only difference is this one can handle a variable amount of ids and the other can't
 //  lets do this the other way, merge entityIDs into idSet, just need to figure out how it's different and adjust for any speed differences
 //  or could just leave them separate for strategic, untested optimization reasons (i.e. laziness)
 
 #define IS_IN_USE 0x1
+#define NO_FREE_ID UINT32_MAX
 
-typedef struct {
-	uint16_t idx;
-	uint16_t gen;
-} IDParts;
+#define INDEX_MASK ( ( ( (EntityID)1 ) << ID_SET_INDEX_BITS ) - 1 )
+#define GENERATION_MASK ( (uint32_t)( ( ( (uint64_t)1 ) << ID_SET_GENERATION_BITS ) - 1 ) )
+
+#define createID( index, generation ) ( ( (EntityID)( index ) ) | ( ( (EntityID)( generation ) ) << ID_SET_INDEX_BITS ) )
+#define getIDIndex( id ) ( (uint32_t)( ( id ) & INDEX_MASK ) )
+#define getIDGeneration( id ) ( (uint32_t)( ( id ) >> ID_SET_INDEX_BITS ) )
+
+#define BITS_PER_WORD 64
+#define WORD_SHIFT 6
+#define BIT_MASK ( BITS_PER_WORD - 1 )
+
+static uint32_t countTrailingZeros( uint64_t value )
+{
+	assert( value != 0 );
+#if defined( _MSC_VER )
+	unsigned long idx;
+	_BitScanForward64( &idx, value );
+	return (uint32_t)idx;
+#else
+	return (uint32_t)__builtin_ctzll( value );
+#endif
+}
+
+static void setInUse( IDSet* set, uint32_t idx )
+{
+	uint32_t word = idx >> WORD_SHIFT;
+	set->sbInUseBits[word] |= ( (uint64_t)1 ) << ( idx & BIT_MASK );
+	set->sbInUseWords[word >> WORD_SHIFT] |= ( (uint64_t)1 ) << ( word & BIT_MASK );
+}
+
+static void setNotInUse( IDSet* set, uint32_t idx )
+{
+	uint32_t word = idx >> WORD_SHIFT;
+	set->sbInUseBits[word] &= ~( ( (uint64_t)1 ) << ( idx & BIT_MASK ) );
+	if( set->sbInUseBits[word] == 0 ) {
+		set->sbInUseWords[word >> WORD_SHIFT] &= ~( ( (uint64_t)1 ) << ( word & BIT_MASK ) );
+	}
+}
+
+// finds the first index at or after start that's in use, returns NO_FREE_ID if there isn't one
+static uint32_t findInUse( IDSet* set, uint32_t start )
+{
+	size_t numWords = sb_Count( set->sbInUseBits );
+	uint32_t word = start >> WORD_SHIFT;
+	if( word >= numWords ) {
+		return NO_FREE_ID;
+	}
+
+	// check the rest of the starting word
+	uint64_t bits = set->sbInUseBits[word] & ( ~( (uint64_t)0 ) << ( start & BIT_MASK ) );
+	if( bits != 0 ) {
+		return ( word << WORD_SHIFT ) + countTrailingZeros( bits );
+	}
+
+	// then use the second level to find the next word with anything in it
+	++word;
+	size_t numSummaryWords = sb_Count( set->sbInUseWords );
+	uint32_t summary = word >> WORD_SHIFT;
+	if( summary >= numSummaryWords ) {
+		return NO_FREE_ID;
+	}
+
+	uint64_t words = set->sbInUseWords[summary] & ( ~( (uint64_t)0 ) << ( word & BIT_MASK ) );
+	while( words == 0 ) {
+		++summary;
+		if( summary >= numSummaryWords ) {
+			return NO_FREE_ID;
+		}
+		words = set->sbInUseWords[summary];
+	}
+
+	word = ( summary << WORD_SHIFT ) + countTrailingZeros( words );
+	return ( word << WORD_SHIFT ) + countTrailingZeros( set->sbInUseBits[word] );
+}
+
+// makes sure the bitsets have room for numIDs ids, any new bits are cleared
+static void growInUseBits( IDSet* set, size_t numIDs )
+{
+	size_t numWords = ( numIDs + BIT_MASK ) >> WORD_SHIFT;
+	size_t currWords = sb_Count( set->sbInUseBits );
+	if( numWords > currWords ) {
+		uint64_t* newWords = sb_Add( set->sbInUseBits, numWords - currWords );
+		memset( newWords, 0, sizeof( newWords[0] ) * ( numWords - currWords ) );
+	}
+
+	size_t numSummaryWords = ( numWords + BIT_MASK ) >> WORD_SHIFT;
+	size_t currSummaryWords = sb_Count( set->sbInUseWords );
+	if( numSummaryWords > currSummaryWords ) {
+		uint64_t* newWords = sb_Add( set->sbInUseWords, numSummaryWords - currSummaryWords );
+		memset( newWords, 0, sizeof( newWords[0] ) * ( numSummaryWords - currSummaryWords ) );
+	}
+}
+
+static void pushFree( IDSet* set, uint32_t idx )
+{
+	set->sbIDData[idx].nextFree = NO_FREE_ID;
+	if( set->lastFree == NO_FREE_ID ) {
+		set->firstFree = idx;
+	} else {
+		set->sbIDData[set->lastFree].nextFree = idx;
+	}
+	set->lastFree = idx;
+}
+
+// adds all the ids in [start, end) to the end of the free list in order
+static void pushFreeRange( IDSet* set, uint32_t start, uint32_t end )
+{
+	if( start >= end ) {
+		return;
+	}
 
-typedef union {
-	EntityID id;
-	IDParts idParts;
-} IDUnion;
+	for( uint32_t i = start; i < ( end - 1 ); ++i ) {
+		set->sbIDData[i].nextFree = i + 1;
+	}
+	set->sbIDData[end - 1].nextFree = NO_FREE_ID;
 
-#define createID( index, generation ) ( (uint32_t)index ) | ( ( (uint32_t)generation ) << 16 )
+	if( set->lastFree == NO_FREE_ID ) {
+		set->firstFree = start;
+	} else {
+		set->sbIDData[set->lastFree].nextFree = start;
+	}
+	set->lastFree = end - 1;
+}
 
 /*
 Initializes an IDSet, the maximum number of ids allowed is set in maxSize.
-Max size can never be larger than 2^16.
+Max size can never be larger than ID_SET_MAX_SIZE.
  Returns 0 if it was a success, a negative number otherwise.
 */
 int idSet_Init( IDSet* set, size_t maxSize )
 {
 	assert( set != NULL );
-	assert( maxSize <= (size_t)UINT16_MAX );
+	assert( maxSize <= ID_SET_MAX_SIZE );
 
-	sb_Add( set->sbIDData, maxSize );
+	set->sbIDData = NULL;
+	set->sbInUseBits = NULL;
+	set->sbInUseWords = NULL;
+	if( maxSize > 0 ) {
+		if( sb_Add( set->sbIDData, maxSize ) == NULL ) {
+			return -1;
+		}
+		growInUseBits( set, maxSize );
+	}
 	idSet_Clear( set );
 
-	set->currMaxCount = 0;
-
 	return 0;
 }
 
@@ -46,45 +173,50 @@ void idSet_Destroy( IDSet* set )
 {
 	assert( set != NULL );
 	sb_Release( set->sbIDData );
+	sb_Release( set->sbInUseBits );
+	sb_Release( set->sbInUseWords );
 	set->sbIDData = NULL;
+	set->firstFree = NO_FREE_ID;
+	set->lastFree = NO_FREE_ID;
 }
 
 /*
 Claims an id and returns it, returns a value of 0 if there were none available.
+ Constant time, takes the oldest released id.
 */
 EntityID idSet_ClaimID( IDSet* set )
 {
 	assert( set != NULL );
-	// attempt to find an unused id, 0 is always an invalid id
-	uint16_t idx = 0;
-	size_t count = sb_Count( set->sbIDData );
 
-	while( ( idx < count ) && ( ( set->sbIDData[idx].flags & IS_IN_USE ) != 0 ) ) {
-		++idx;
+	uint32_t idx = set->firstFree;
+	if( idx == NO_FREE_ID ) {
+		return 0;
 	}
 
-	if( idx >= count ) {
-		return 0;
+	IDStorage* storage = &( set->sbIDData[idx] );
+	assert( !( storage->flags & IS_IN_USE ) );
+
+	set->firstFree = storage->nextFree;
+	if( set->firstFree == NO_FREE_ID ) {
+		set->lastFree = NO_FREE_ID;
 	}
 
 	// found valid id, mark it as in use, advance the generation, and generate the id
-	set->sbIDData[idx].flags |= IS_IN_USE;
+	//  the generation is never 0 so no valid id is ever 0
+	storage->flags |= IS_IN_USE;
+	setInUse( set, idx );
 
-	if( set->sbIDData[idx].generation == UINT16_MAX ) {
-		set->sbIDData[idx].generation = 1;
+	if( storage->generation >= GENERATION_MASK ) {
+		storage->generation = 1;
 	} else {
-		++( set->sbIDData[idx].generation );
-	}
-
-	if( idx > set->currMaxCount ) {
-		set->currMaxCount = idx;
+		++( storage->generation );
 	}
 
-	return createID( idx, set->sbIDData[idx].generation );
+	return createID( idx, storage->generation );
 }
 
 /*
-Releases an id from use, allowing it to be used by something else.
+Releases an id from use, allowing it to be used by something else. Ids that aren't currently valid are ignored.
 */
 void idSet_ReleaseID( IDSet* set, EntityID id )
 {
@@ -94,14 +226,18 @@ void idSet_ReleaseID( IDSet* set, EntityID id )
 		return;
 	}
 
-	IDUnion idu;
-	idu.id = id;
-
-	set->sbIDData[idu.idParts.idx].flags &= ~IS_IN_USE;
+	uint32_t idx = getIDIndex( id );
+	assert( idx < sb_Count( set->sbIDData ) );
 
-	while( !( set->sbIDData[set->currMaxCount].flags & IS_IN_USE ) && ( set->currMaxCount > 0 ) ) {
-		--( set->currMaxCount );
+	// releasing an id twice would put it in the free list twice, and an id from an older generation would release
+	//  whatever is using the index now
+	if( !( set->sbIDData[idx].flags & IS_IN_USE ) || ( set->sbIDData[idx].generation != getIDGeneration( id ) ) ) {
+		return;
 	}
+
+	set->sbIDData[idx].flags &= ~IS_IN_USE;
+	setNotInUse( set, idx );
+	pushFree( set, idx );
 }
 
 /*
@@ -110,14 +246,18 @@ Sets a new maximum number of ids, will not shrink it if the new is less than the
 void idSet_IncreaseMaximum( IDSet* set, size_t newMax )
 {
 	assert( set != NULL );
+	assert( newMax <= ID_SET_MAX_SIZE );
 
-	if( newMax <= sb_Count( set->sbIDData ) ) {
+	size_t oldMax = sb_Count( set->sbIDData );
+	if( newMax <= oldMax ) {
 		return;
 	}
 
-	size_t growAmt = newMax - sb_Count( set->sbIDData );
+	size_t growAmt = newMax - oldMax;
 	IDStorage* startNew = sb_Add( set->sbIDData, growAmt );
 	memset( startNew, 0, sizeof( startNew[0] ) * growAmt );
+	growInUseBits( set, newMax );
+	pushFreeRange( set, (uint32_t)oldMax, (uint32_t)newMax );
 }
 
 /*
@@ -127,6 +267,12 @@ void idSet_Clear( IDSet* set )
 {
 	assert( set != NULL );
 	memset( set->sbIDData, 0, sizeof( set->sbIDData[0] ) * sb_Count( set->sbIDData ) );
+	memset( set->sbInUseBits, 0, sizeof( set->sbInUseBits[0] ) * sb_Count( set->sbInUseBits ) );
+	memset( set->sbInUseWords, 0, sizeof( set->sbInUseWords[0] ) * sb_Count( set->sbInUseWords ) );
+
+	set->firstFree = NO_FREE_ID;
+	set->lastFree = NO_FREE_ID;
+	pushFreeRange( set, 0, (uint32_t)sb_Count( set->sbIDData ) );
 }
 
 /*
@@ -140,9 +286,12 @@ bool idSet_IsIDValid( IDSet* set, EntityID id )
 		return false;
 	}
 
-	IDUnion idu;
-	idu.id = id;
-	if( ( set->sbIDData[idu.idParts.idx].flags & IS_IN_USE ) && ( set->sbIDData[idu.idParts.idx].generation == idu.idParts.gen ) ) {
+	uint32_t idx = getIDIndex( id );
+	if( idx >= sb_Count( set->sbIDData ) ) {
+		return false;
+	}
+
+	if( ( set->sbIDData[idx].flags & IS_IN_USE ) && ( set->sbIDData[idx].generation == getIDGeneration( id ) ) ) {
 		return true;
 	}
 
@@ -152,17 +301,15 @@ bool idSet_IsIDValid( IDSet* set, EntityID id )
 /*
 Returns an index associated with this id. Does no checking to see if it's valid.
 */
-uint16_t idSet_GetIndex( EntityID id )
+uint32_t idSet_GetIndex( EntityID id )
 {
-	IDUnion idu;
-	idu.id = id;
-	return idu.idParts.idx;
+	return getIDIndex( id );
 }
 
 /*
 Generates an id given an index. Does no checking to see if it's valid.
 */
-EntityID idSet_GetIDFromIndex( IDSet* set, uint16_t index )
+EntityID idSet_GetIDFromIndex( IDSet* set, uint32_t index )
 {
 	if( index >= sb_Count( set->sbIDData ) ) {
 		return 0;
@@ -178,14 +325,12 @@ EntityID idSet_GetFirstValidID( IDSet* set )
 {
 	assert( set != NULL );
 
-	uint16_t cnt = (uint16_t)sb_Count( set->sbIDData );
-	for( uint16_t i = 0; i < cnt; ++i ) {
-		if( set->sbIDData[i].flags & IS_IN_USE ) {
-			return createID( i, set->sbIDData[i].generation );
-		}
+	uint32_t idx = findInUse( set, 0 );
+	if( idx == NO_FREE_ID ) {
+		return INVALID_ENTITY_ID;
 	}
 
-	return 0;
+	return createID( idx, set->sbIDData[idx].generation );
 }
 
 /*
@@ -193,11 +338,289 @@ Returns the first valid id after the passed in id, returns INVALID_ENTITY_ID if
 */
 EntityID idSet_GetNextValidID( IDSet* set, EntityID id )
 {
-	for( uint16_t idx = idSet_GetIndex( id ) + 1; idx <= set->currMaxCount; ++idx ) {
-		if( set->sbIDData[idx].flags & IS_IN_USE ) {
-			return createID( idx, set->sbIDData[idx].generation );
+	assert( set != NULL );
+
+	uint32_t idx = findInUse( set, idSet_GetIndex( id ) + 1 );
+	if( idx == NO_FREE_ID ) {
+		return INVALID_ENTITY_ID;
+	}
+
+	return createID( idx, set->sbIDData[idx].generation );
+}
+
+// written at the start of a snapshot, followed by the id storage and then the two levels of in use bits
+typedef struct {
+	uint64_t count;
+	uint32_t firstFree;
+	uint32_t lastFree;
+} IDSetSnapshotHeader;
+
+static size_t bitWordsForIDs( size_t numIDs )
+{
+	return ( numIDs + BIT_MASK ) >> WORD_SHIFT;
+}
+
+/*
+Returns how many bytes idSet_WriteSnapshot( ) will write for the set.
+*/
+size_t idSet_GetSnapshotSize( IDSet* set )
+{
+	assert( set != NULL );
+
+	size_t count = sb_Count( set->sbIDData );
+	size_t numWords = bitWordsForIDs( count );
+	return sizeof( IDSetSnapshotHeader ) + ( sizeof( IDStorage ) * count ) + ( sizeof( uint64_t ) * ( numWords + bitWordsForIDs( numWords ) ) );
+}
+
+/*
+Copies the state of the set into out, which must have room for idSet_GetSnapshotSize( ) bytes.
+ Returns the number of bytes written.
+*/
+size_t idSet_WriteSnapshot( IDSet* set, void* out )
+{
+	assert( set != NULL );
+	assert( out != NULL );
+
+	IDSetSnapshotHeader header;
+	header.count = sb_Count( set->sbIDData );
+	header.firstFree = set->firstFree;
+	header.lastFree = set->lastFree;
+
+	size_t numWords = bitWordsForIDs( (size_t)header.count );
+	size_t numSummaryWords = bitWordsForIDs( numWords );
+
+	uint8_t* pos = (uint8_t*)out;
+	memcpy( pos, &header, sizeof( header ) );
+	pos += sizeof( header );
+	memcpy( pos, set->sbIDData, sizeof( IDStorage ) * (size_t)header.count );
+	pos += sizeof( IDStorage ) * (size_t)header.count;
+	memcpy( pos, set->sbInUseBits, sizeof( uint64_t ) * numWords );
+	pos += sizeof( uint64_t ) * numWords;
+	memcpy( pos, set->sbInUseWords, sizeof( uint64_t ) * numSummaryWords );
+	pos += sizeof( uint64_t ) * numSummaryWords;
+
+	return (size_t)( pos - (uint8_t*)out );
+}
+
+/*
+Sets the state of the set to what was written by idSet_WriteSnapshot( ), growing it if it's smaller than the one the
+ snapshot was taken from. If it's larger the extra ids are left unused but keep their generations, so ids for them
+ that are still around don't become valid again.
+ Returns the number of bytes read, 0 if the snapshot wasn't valid.
+*/
+size_t idSet_ReadSnapshot( IDSet* set, const void* data, size_t size )
+{
+	assert( set != NULL );
+	assert( data != NULL );
+
+	IDSetSnapshotHeader header;
+	if( size < sizeof( header ) ) {
+		return 0;
+	}
+	memcpy( &header, data, sizeof( header ) );
+	if( ( header.count > ID_SET_MAX_SIZE ) ||
+		( ( header.firstFree != NO_FREE_ID ) && ( header.firstFree >= header.count ) ) ||
+		( ( header.lastFree != NO_FREE_ID ) && ( header.lastFree >= header.count ) ) ) {
+		return 0;
+	}
+
+	size_t count = (size_t)header.count;
+	size_t numWords = bitWordsForIDs( count );
+	size_t numSummaryWords = bitWordsForIDs( numWords );
+	size_t totalSize = sizeof( header ) + ( sizeof( IDStorage ) * count ) + ( sizeof( uint64_t ) * ( numWords + numSummaryWords ) );
+	if( size < totalSize ) {
+		return 0;
+	}
+
+	size_t currCount = sb_Count( set->sbIDData );
+	if( currCount < count ) {
+		sb_Add( set->sbIDData, count - currCount );
+		growInUseBits( set, count );
+		currCount = count;
+	}
+
+	const uint8_t* pos = (const uint8_t*)data + sizeof( header );
+	memcpy( set->sbIDData, pos, sizeof( IDStorage ) * count );
+	pos += sizeof( IDStorage ) * count;
+
+	// the snapshot bits are copied over and anything past them is cleared
+	memcpy( set->sbInUseBits, pos, sizeof( uint64_t ) * numWords );
+	memset( set->sbInUseBits + numWords, 0, sizeof( uint64_t ) * ( sb_Count( set->sbInUseBits ) - numWords ) );
+	pos += sizeof( uint64_t ) * numWords;
+	memcpy( set->sbInUseWords, pos, sizeof( uint64_t ) * numSummaryWords );
+	memset( set->sbInUseWords + numSummaryWords, 0, sizeof( uint64_t ) * ( sb_Count( set->sbInUseWords ) - numSummaryWords ) );
+
+	set->firstFree = header.firstFree;
+	set->lastFree = header.lastFree;
+
+	// any ids the snapshot didn't have go on the end of the free list
+	for( size_t i = count; i < currCount; ++i ) {
+		set->sbIDData[i].flags &= ~IS_IN_USE;
+	}
+	pushFreeRange( set, (uint32_t)count, (uint32_t)currCount );
+
+	return totalSize;
+}
+
+/*
+Checks claiming, releasing, and iterating over the ids in a small set, asserting if anything fails.
+ Uses the main memory, so mem_Init( ) must have been called.
+*/
+void idSet_RunTests( void )
+{
+	IDSet set;
+	EntityID ids[200];
+	TEST_CHECK( idSet_Init( &set, SDL_arraysize( ids ) ) == 0, "id set created" );
+
+	// ids are claimed in index order until the set is full
+	bool allClaimed = true;
+	for( uint32_t i = 0; i < SDL_arraysize( ids ); ++i ) {
+		ids[i] = idSet_ClaimID( &set );
+		allClaimed = allClaimed && ( ids[i] != INVALID_ENTITY_ID ) && idSet_IsIDValid( &set, ids[i] ) && ( idSet_GetIndex( ids[i] ) == i );
+	}
+	TEST_CHECK( allClaimed, "ids claimed in index order" );
+	TEST_CHECK( idSet_ClaimID( &set ) == INVALID_ENTITY_ID, "no id claimed from a full set" );
+
+	// the oldest released index is reused first, with a new generation so the old id stays invalid
+	idSet_ReleaseID( &set, ids[10] );
+	idSet_ReleaseID( &set, ids[20] );
+	TEST_CHECK( !idSet_IsIDValid( &set, ids[10] ) && !idSet_IsIDValid( &set, ids[20] ), "released ids are invalid" );
+	EntityID reclaimed = idSet_ClaimID( &set );
+	TEST_CHECK( ( idSet_GetIndex( reclaimed ) == 10 ) && ( reclaimed != ids[10] ), "oldest released index reused with a new generation" );
+	idSet_ReleaseID( &set, ids[10] );
+	TEST_CHECK( idSet_IsIDValid( &set, reclaimed ), "releasing an id from an older generation is ignored" );
+	ids[10] = reclaimed;
+	ids[20] = idSet_ClaimID( &set );
+	TEST_CHECK( idSet_GetIndex( ids[20] ) == 20, "next released index reused" );
+
+	// ids can be released while iterating, and iterating only finds the ones still in use in index order
+	for( EntityID id = idSet_GetFirstValidID( &set ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &set, id ) ) {
+		if( ( idSet_GetIndex( id ) % 3 ) != 0 ) {
+			idSet_ReleaseID( &set, id );
 		}
 	}
-	
-	return INVALID_ENTITY_ID;
-}
\ No newline at end of file
+	uint32_t expectedIdx = 0;
+	bool inOrder = true;
+	for( EntityID id = idSet_GetFirstValidID( &set ); ( id != INVALID_ENTITY_ID ) && inOrder; id = idSet_GetNextValidID( &set, id ) ) {
+		inOrder = ( expectedIdx < SDL_arraysize( ids ) ) && ( id == ids[expectedIdx] );
+		expectedIdx += 3;
+	}
+	TEST_CHECK( inOrder && ( expectedIdx >= SDL_arraysize( ids ) ), "iterating finds every id in use in index order" );
+
+	idSet_Clear( &set );
+	TEST_CHECK( ( idSet_GetFirstValidID( &set ) == INVALID_ENTITY_ID ) && !idSet_IsIDValid( &set, ids[0] ), "cleared set has no valid ids" );
+
+	idSet_Destroy( &set );
+}
+
+/*
+Claims and releases numIDs ids in a few patterns and logs how long each takes.
+ Uses the main memory, so mem_Init( ) must have been called.
+*/
+void idSet_RunBenchmark( size_t numIDs )
+{
+	assert( numIDs > 0 );
+	assert( numIDs <= ID_SET_MAX_SIZE );
+
+	IDSet set;
+	if( idSet_Init( &set, numIDs ) != 0 ) {
+		llog( LOG_ERROR, "IDSet benchmark: unable to create set of size %u", (uint32_t)numIDs );
+		return;
+	}
+
+	EntityID* ids = mem_Allocate( sizeof( EntityID ) * numIDs );
+	assert( ids != NULL );
+
+	RandomGroup rand;
+	rand_Seed( &rand, 5678 );
+
+	llog( LOG_INFO, "IDSet benchmark: %u ids, %u index bits and %u generation bits", (uint32_t)numIDs, ID_SET_INDEX_BITS, ID_SET_GENERATION_BITS );
+
+	// fill the set
+	Uint64 start = SDL_GetPerformanceCounter( );
+	for( size_t i = 0; i < numIDs; ++i ) {
+		ids[i] = idSet_ClaimID( &set );
+	}
+	double ms = test_MSSince( start );
+	llog( LOG_INFO, "  Claim all: %.3f ms, %.2f ns per id", ms, ( ms * 1000000.0 ) / (double)numIDs );
+
+	bool passed = ( idSet_ClaimID( &set ) == INVALID_ENTITY_ID );
+	for( size_t i = 0; ( i < numIDs ) && passed; ++i ) {
+		passed = ( ids[i] != INVALID_ENTITY_ID ) && idSet_IsIDValid( &set, ids[i] ) && ( idSet_GetIndex( ids[i] ) == i );
+	}
+	TEST_CHECK( passed, "every id claimed in index order" );
+
+	// release them in a random order
+	for( size_t i = numIDs - 1; i > 0; --i ) {
+		size_t swap = (size_t)( rand_GetU64( &rand ) % ( i + 1 ) );
+		EntityID temp = ids[i];
+		ids[i] = ids[swap];
+		ids[swap] = temp;
+	}
+
+	start = SDL_GetPerformanceCounter( );
+	for( size_t i = 0; i < numIDs; ++i ) {
+		idSet_ReleaseID( &set, ids[i] );
+	}
+	ms = test_MSSince( start );
+	llog( LOG_INFO, "  Release all in random order: %.3f ms, %.2f ns per id", ms, ( ms * 1000000.0 ) / (double)numIDs );
+
+	passed = true;
+	for( size_t i = 0; ( i < numIDs ) && passed; ++i ) {
+		passed = !idSet_IsIDValid( &set, ids[i] );
+	}
+	TEST_CHECK( passed, "every id released" );
+
+	// keep the set half full, releasing a random id and claiming a new one each step
+	size_t live = numIDs / 2;
+	for( size_t i = 0; i < live; ++i ) {
+		ids[i] = idSet_ClaimID( &set );
+	}
+
+	start = SDL_GetPerformanceCounter( );
+	for( size_t i = 0; i < numIDs; ++i ) {
+		size_t victim = (size_t)( rand_GetU64( &rand ) % live );
+		idSet_ReleaseID( &set, ids[victim] );
+		ids[victim] = idSet_ClaimID( &set );
+	}
+	ms = test_MSSince( start );
+	llog( LOG_INFO, "  Churn at half full: %.3f ms, %.2f ns per release and claim", ms, ( ms * 1000000.0 ) / (double)numIDs );
+
+	passed = true;
+	for( size_t i = 0; ( i < live ) && passed; ++i ) {
+		passed = idSet_IsIDValid( &set, ids[i] );
+	}
+	TEST_CHECK( passed, "churned ids are all valid" );
+
+	// iterate over the half full set, and then with only a few ids left spread through it
+	start = SDL_GetPerformanceCounter( );
+	size_t found = 0;
+	for( EntityID id = idSet_GetFirstValidID( &set ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &set, id ) ) {
+		++found;
+	}
+	ms = test_MSSince( start );
+	llog( LOG_INFO, "  Iterate %u ids at half full: %.3f ms", (uint32_t)found, ms );
+	TEST_CHECK( found == live, "iterating at half full finds every id" );
+
+	size_t sparse = ( live < 3 ) ? live : 3;
+	for( size_t i = 0; i < live; ++i ) {
+		if( ( i % ( live / sparse ) ) != 0 ) {
+			idSet_ReleaseID( &set, ids[i] );
+		}
+	}
+
+	const uint32_t sparseRuns = 1000;
+	found = 0;
+	start = SDL_GetPerformanceCounter( );
+	for( uint32_t r = 0; r < sparseRuns; ++r ) {
+		for( EntityID id = idSet_GetFirstValidID( &set ); id != INVALID_ENTITY_ID; id = idSet_GetNextValidID( &set, id ) ) {
+			++found;
+		}
+	}
+	ms = test_MSSince( start );
+	llog( LOG_INFO, "  Iterate %u sparse ids: %.2f us per pass", (uint32_t)( found / sparseRuns ), ( ms * 1000.0 ) / (double)sparseRuns );
+	TEST_CHECK( ( found / sparseRuns ) == ( ( live + ( live / sparse ) - 1 ) / ( live / sparse ) ), "iterating sparse ids finds every id" );
+
+	mem_Release( ids );
+	idSet_Destroy( &set );
+}
@@ -5,7 +5,28 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/*
+Ids are split into an index and a generation, the generation is advanced each time the index is reused so old ids
+ for the index become invalid.
+By default ids are 32 bits, with ID_SET_INDEX_BITS bits for the index and the rest for the generation. Define
+ ID_SET_64BIT_IDS to use 64 bit ids with 32 bits for each.
+*/
+#if defined( ID_SET_64BIT_IDS )
+typedef uint64_t EntityID;
+#undef ID_SET_INDEX_BITS
+#define ID_SET_INDEX_BITS 32
+#define ID_SET_GENERATION_BITS 32
+#else
 typedef uint32_t EntityID;
+#ifndef ID_SET_INDEX_BITS
+#define ID_SET_INDEX_BITS 24
+#endif
+#define ID_SET_GENERATION_BITS ( 32 - ID_SET_INDEX_BITS )
+#endif
+
+// the most ids a set can hold, one less than the number of indices so there's always a value to mark the end of the
+//  free list with
+#define ID_SET_MAX_SIZE ( (size_t)( ( ( (uint64_t)1 ) << ID_SET_INDEX_BITS ) - 1 ) )
 
 #define INVALID_ENTITY_ID 0
 
@@ -14,18 +35,26 @@ Used to store a set of reference ids.
 */
 
 typedef struct {
-	uint16_t flags;
-	uint16_t generation;
+	uint32_t generation;
+	uint32_t nextFree; // only used while the id isn't in use
+	uint8_t flags;
 } IDStorage;
 
+// the unused ids are kept in a first in first out list, so an index that was just released is the last one to be
+//  reused, which keeps the generations from wrapping around quickly
+// which ids are in use is also kept in a bitset, with a second level that has a bit for each word of the first
+//  that has any bits set, so iterating only has to look at the words that have ids in them
 typedef struct {
 	IDStorage* sbIDData;
-	uint16_t currMaxCount;
+	uint64_t* sbInUseBits;
+	uint64_t* sbInUseWords;
+	uint32_t firstFree;
+	uint32_t lastFree;
 } IDSet;
 
 /*
 Initializes an IDSet, the maximum number of ids allowed is set in maxSize.
-Max size can never be larger than 2^16.
+Max size can never be larger than ID_SET_MAX_SIZE.
  Returns 0 if it was a success, a negative number otherwise.
 */
 int idSet_Init( IDSet* set, size_t maxSize );
@@ -37,11 +66,12 @@ void idSet_Destroy( IDSet* set );
 
 /*
 Claims an id and returns it, returns a value of 0 if there were none available.
+ Constant time, takes the oldest released id.
 */
 EntityID idSet_ClaimID( IDSet* set );
 
 /*
-Releases an id from use, allowing it to be used by something else.
+Releases an id from use, allowing it to be used by something else. Ids that aren't currently valid are ignored.
 */
 void idSet_ReleaseID( IDSet* set, EntityID id );
 
@@ -63,22 +93,56 @@ bool idSet_IsIDValid( IDSet* set, EntityID id );
 /*
 Returns an index associated with this id. Does no checking to see if it's valid.
 */
-uint16_t idSet_GetIndex( EntityID id );
+uint32_t idSet_GetIndex( EntityID id );
 
 /*
 Generates an id given an index. Does no checking to see if it's valid.
  Returns 0 if the index is out of range
 */
-EntityID idSet_GetIDFromIndex( IDSet* set, uint16_t index );
+EntityID idSet_GetIDFromIndex( IDSet* set, uint32_t index );
 
 /*
 Returns the first valid id, returns 0 if there is none.
+ Iterating with this and idSet_GetNextValidID( ) skips over unused ids 64 at a time, and skips 4096 at a time
+ where there are none in use.
 */
 EntityID idSet_GetFirstValidID( IDSet* set );
 
 /*
 Returns the first valid id after the passed in id, returns 0 if there is none.
+ The passed in id doesn't have to still be valid, so ids can be released while iterating.
 */
 EntityID idSet_GetNextValidID( IDSet* set, EntityID id );
 
+/*
+Returns how many bytes idSet_WriteSnapshot( ) will write for the set.
+*/
+size_t idSet_GetSnapshotSize( IDSet* set );
+
+/*
+Copies the state of the set into out, which must have room for idSet_GetSnapshotSize( ) bytes.
+ Returns the number of bytes written.
+*/
+size_t idSet_WriteSnapshot( IDSet* set, void* out );
+
+/*
+Sets the state of the set to what was written by idSet_WriteSnapshot( ), growing it if it's smaller than the one the
+ snapshot was taken from. If it's larger the extra ids are left unused but keep their generations, so ids for them
+ that are still around don't become valid again.
+ Returns the number of bytes read, 0 if the snapshot wasn't valid.
+*/
+size_t idSet_ReadSnapshot( IDSet* set, const void* data, size_t size );
+
+/*
+Checks claiming, releasing, and iterating over the ids in a small set, asserting if anything fails.
+ Uses the main memory, so mem_Init( ) must have been called.
+*/
+void idSet_RunTests( void );
+
+/*
+Claims and releases numIDs ids in a few patterns and logs how long each takes.
+ Uses the main memory, so mem_Init( ) must have been called.
+*/
+void idSet_RunBenchmark( size_t numIDs );
+
 #endif
\ No newline at end of file
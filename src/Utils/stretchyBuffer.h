@@ -32,6 +32,9 @@
 // adds a specific number of elements to the buffer and gives you the address where the first of the new elements was added
 #define sb_Add( ptr, amt )	( sb__TestAndGrow( (ptr), (amt) ), sb__Used( (ptr) ) += (amt), &(ptr)[sb__Used((ptr)) - (amt)] )
 
+// reduces the number of elements in the buffer by amt, doesn't deallocate memory, will cause issues if there are less than amt elements
+#define sb_RemoveLast( ptr, amt )	( sb__Used( (ptr) ) -= (amt) )
+
 // returns the data in the last spot in the array
 #define sb_Last( ptr )	( (ptr)[ sb__Used( (ptr) ) - 1] )
 
@@ -56,7 +59,7 @@ static void* sb__GrowData( void* p, int increment, size_t itemSize, const char*
 	int currBased = currSize + ( currSize / 2 ); // 1.5 * current
 	int min = currSize + increment;
 	int newCount = ( min > currBased ) ? min : currBased;
-	int* np = mem_Resize_Data( p ? (void*)( sb__Raw(p) ) : NULL, ( newCount * itemSize ) + ( sizeof( int) * 2 ), fileName, fileLine );
+	size_t* np = mem_Resize_Data( p ? (void*)( sb__Raw(p) ) : NULL, ( newCount * itemSize ) + ( sizeof( size_t ) * 2 ), fileName, fileLine );
 	//int* np = mem_Resize( p ? (void*)( sb__Raw(p) ) : NULL, ( newCount * itemSize ) + ( sizeof( int) * 2 ) );
 	if( np != NULL ) {
 		if( p == NULL ) {
@@ -33,9 +33,14 @@
 #include "System/random.h"
 
 #include "Graphics/debugRendering.h"
+#include "Graphics/images.h"
 #include "Graphics/glPlatform.h"
+#include "Graphics/triRendering.h"
 
 #include "System/jobQueue.h"
+#include "System/jobRingQueue.h"
+#include "System/ECPS/entityComponentProcessSystem.h"
+#include "Utils/idSet.h"
 
 #include "Game/resources.h"
 
@@ -78,6 +83,7 @@ void cleanUp( void )
 		SDL_RWclose( logFile );
 	}
 
+	memArena_CleanUp( &frameArena );
 	mem_CleanUp( );
 
 	atexit( NULL );
@@ -124,6 +130,57 @@ int unalignedAccess( void )
 	return unalignedInt;
 }
 
+// runs the tests for the engine systems, and times them as well if benchmarks is set, everything has to be
+//  initialized first but nothing else can be running yet
+// one worker for every core except the one the main thread is running on
+static int getNumJobWorkers( void )
+{
+	int numWorkers = SDL_GetCPUCount( ) - 1;
+	if( numWorkers < 1 ) numWorkers = 1;
+	return numWorkers;
+}
+
+static void runTests( bool benchmarks )
+{
+	llog( LOG_INFO, "Running tests." );
+	mem_RunTests( );
+	jrq_RunTests( );
+	jq_RunTests( );
+	idSet_RunTests( );
+	ecps_RunTests( );
+	triRenderer_RunTests( );
+	img_RunTests( );
+
+	if( !benchmarks ) {
+		return;
+	}
+
+	llog( LOG_INFO, "Running benchmarks." );
+	mem_RunContentionBenchmark( (uint8_t)SDL_GetCPUCount( ), 100000 );
+	mem_RunProfileBenchmark( 10000 );
+	jrq_RunStressTest( 4, 4, 250000 );
+
+	// the job queue benchmarks start and stop their own workers
+	jq_ShutDown( );
+	jq_RunSchedulerBenchmark( (uint8_t)getNumJobWorkers( ), 256, 256 );
+	jq_RunParallelForBenchmark( (uint8_t)SDL_GetCPUCount( ), 100000, 1024 );
+	if( jq_Initialize( (uint8_t)getNumJobWorkers( ) ) < 0 ) {
+		llog( LOG_ERROR, "Unable to restart job queue after benchmarks." );
+	}
+
+	idSet_RunBenchmark( 1000000 );
+	ecps_RunChurnBenchmark( 50000, 5000, 167, 600 );
+	ecps_RunLayoutBenchmark( 200000, 50 );
+	ecps_RunCommandBufferBenchmark( 50000, 10 );
+	ecps_RunSnapshotBenchmark( 100000, 20 );
+	ecps_RunChangeFilterBenchmark( 100000, 20 );
+	triRenderer_RunBenchmark( 20000, 10, 0 );
+	triRenderer_RunBenchmark( 20000, 10, 1 );
+	triRenderer_RunSortBenchmark( 2048, 20 );
+	triRenderer_RunSortBenchmark( 200000, 10 );
+	img_RunRenderBenchmark( 100000, 10 );
+}
+
 int initEverything( void )
 {
 #ifndef _DEBUG
@@ -138,6 +195,7 @@ int initEverything( void )
 	llog( LOG_INFO, "Initializing memory." );
 	// memory first, won't be used everywhere at first so lets keep the initial allocation low, 64 MB
 	mem_Init( 64 * 1024 * 1024 );
+	memArena_Init( &frameArena, 1024 * 1024 );
 
 	// then SDL
 	SDL_SetMainReady( );
@@ -148,6 +206,15 @@ int initEverything( void )
 	llog( LOG_INFO, "SDL successfully initialized." );
 	atexit( cleanUp );
 
+	int numWorkers = getNumJobWorkers( );
+	if( jq_Initialize( (uint8_t)numWorkers ) < 0 ) {
+		llog( LOG_ERROR, "Unable to initialize job queue." );
+		return -1;
+	}
+	llog( LOG_INFO, "Job queue successfully initialized with %i workers.", numWorkers );
+	// keep main thread jobs (mostly binding loaded assets) from causing hitches
+	jq_SetMainThreadJobBudget( 4.0f );
+
 	// set up opengl
 	//  try opening and parsing the config file
 	int majorVersion;
@@ -156,6 +223,7 @@ int initEverything( void )
 	int greenSize;
 	int blueSize;
 	int depthSize;
+	int instancedSprites;
 
 	void* oglCFGFile;
 #if defined( __EMSCRIPTEN__ )
@@ -174,6 +242,7 @@ int initEverything( void )
 	cfg_GetInt( oglCFGFile, "GREEN_SIZE", 8, &greenSize );
 	cfg_GetInt( oglCFGFile, "BLUE_SIZE", 8, &blueSize );
 	cfg_GetInt( oglCFGFile, "DEPTH_SIZE", 16, &depthSize );
+	cfg_GetInt( oglCFGFile, "INSTANCED_SPRITES", 1, &instancedSprites );
 	cfg_CloseFile( oglCFGFile );
 
 	// todo: commenting these out breaks the font rendering, something wrong with the texture that's created
@@ -208,6 +277,8 @@ int initEverything( void )
 	if( gfx_Init( window, RENDER_WIDTH, RENDER_HEIGHT ) < 0 ) {
 		return -1;
 	}
+	// images are interpolated and transformed on the GPU unless the config turns it off
+	img_SetInstancedRendering( instancedSprites != 0 );
 	llog( LOG_INFO, "Rendering successfully initialized" );
 
 	// Create sound mixer
@@ -309,6 +380,9 @@ void mainLoop( void* v )
 	tickDelta = currTicks - lastTicks;
 	lastTicks = currTicks;
 
+	// everything allocated for the last frame is done being used
+	memArena_Reset( &frameArena );
+
 	if( !focused ) {
 		processEvents( 1 );
 		return;
@@ -374,6 +448,14 @@ int main( int argc, char** argv )
 		return 1;
 	}
 
+	for( int i = 1; i < argc; ++i ) {
+		if( SDL_strcmp( argv[i], "-tests" ) == 0 ) {
+			runTests( false );
+		} else if( SDL_strcmp( argv[i], "-benchmarks" ) == 0 ) {
+			runTests( true );
+		}
+	}
+
 	srand( (unsigned int)time( NULL ) );
 
 	//***** main loop *****
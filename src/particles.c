@@ -4,6 +4,7 @@
 #include "Math/mathUtil.h"
 
 #include "System/systems.h"
+#include "System/jobQueue.h"
 
 #include <string.h>
 
@@ -32,13 +33,15 @@ struct Particle {
 int lastParticle;
 static struct Particle particles[MAX_NUM_PARTICLES];
 
-void physicsTick( float dt )
+// each particle is independent of the others, so the update can be split up between the job threads
+#define PARTICLE_UPDATE_GRAIN 256
+
+static void updateParticles( void* context, size_t start, size_t end )
 {
-	int i;
+	float dt = *( (float*)context );
 	float fadeAmt;
 
-	/* update the positions of all the particles */
-	for( i = 0; i <= lastParticle; ++i ) {
+	for( size_t i = start; i < end; ++i ) {
 		particles[i].lifeElapsed += dt;
 
 		fadeAmt = inverseLerp( particles[i].fadeStart, particles[i].lifeTime, particles[i].lifeElapsed );
@@ -49,6 +52,14 @@ void physicsTick( float dt )
 		vec2_AddScaled( &particles[i].velocity, &particles[i].gravity, dt, &particles[i].velocity );
 		vec2_AddScaled( &particles[i].futureRenderPos, &particles[i].velocity, dt, &particles[i].futureRenderPos );
 	}
+}
+
+void physicsTick( float dt )
+{
+	int i;
+
+	/* update the positions of all the particles */
+	jq_ParallelFor( (size_t)( lastParticle + 1 ), PARTICLE_UPDATE_GRAIN, updateParticles, &dt );
 
 	/* destroy all the dead particles, we won't worry about preserving order but should do some tests to see
 	    if doing so will make it more efficient */
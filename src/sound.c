@@ -32,7 +32,7 @@ void snd_SetMasterVolume( float volume ) { }
 float snd_GetVolume( unsigned int group ) { return 0.0f; }
 void snd_SetVolume( float volume, unsigned int group ) { }
 int snd_LoadSample( const char* fileName, Uint8 desiredChannels, bool loops ) { return 0; }
-void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID ) { (*outID) = 0; }
+void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID, JobCounter* counter ) { (*outID) = 0; }
 EntityID snd_Play( int sampleID, float volume, float pitch, float pan, unsigned int group ) { return 0; }
 void snd_ChangeSoundVolume( EntityID soundID, float volume ) { }
 void snd_ChangeSoundPitch( EntityID soundID, float pitch ) { }
@@ -336,6 +336,7 @@ typedef struct {
 	bool loops;
 	int* outID;
 	SDL_AudioCVT loadConverter;
+	JobCounter* counter;
 } ThreadedSoundLoadData;
 
 static void cleanUpThreadedSoundLoadData( ThreadedSoundLoadData* data )
@@ -423,7 +424,7 @@ static void loadSampleJob( void* data )
 
 	SDL_ConvertAudio( &( loadData->loadConverter ) );
 
-	jq_AddMainThreadJob( bindSampleJob, (void*)loadData );
+	jq_AddMainThreadJobWithCounter( bindSampleJob, (void*)loadData, loadData->counter );
 
 	return;
 
@@ -431,7 +432,7 @@ error:
 	cleanUpThreadedSoundLoadData( loadData );
 }
 
-void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID )
+void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID, JobCounter* counter )
 {
 	assert( ( desiredChannels >= 1 ) && ( desiredChannels <= 2 ) );
 	assert( outID != NULL );
@@ -449,8 +450,9 @@ void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool l
 	loadData->loops = loops;
 	loadData->outID = outID;
 	loadData->loadConverter.buf = NULL;
+	loadData->counter = counter;
 
-	jq_AddJob( loadSampleJob, (void*)loadData );
+	jq_AddJobWithCounter( loadSampleJob, (void*)loadData, counter );
 }
 
 /* Sets up the SDL mixer. Returns 0 on success. */
@@ -5,6 +5,7 @@
 #include <SDL_types.h>
 
 #include "Utils\idSet.h"
+#include "System\jobQueue.h"
 
 // Sets up the SDL mixer. Returns 0 on success.
 int snd_Init( unsigned int numGroups );
@@ -22,7 +23,8 @@ void snd_SetVolume( float volume, unsigned int group );
 
 //***** Loaded all at once
 int snd_LoadSample( const char* fileName, Uint8 desiredChannels, bool loops );
-void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID );
+// if counter isn't NULL it won't reach zero until the sample has been loaded
+void snd_ThreadedLoadSample( const char* fileName, Uint8 desiredChannels, bool loops, int* outID, JobCounter* counter );
 
 // Returns an id that can be used to change the volume and pitch
 //  volume - how loud the sound will be, in the range [0,1], 0 being off, 1 being loudest